@@ -0,0 +1,877 @@
+#include <stdio.h>
+#include <string.h>
+#include <renoir-window/Window.h>
+#include <renoir-gl450/Renoir-gl450.h>
+
+#include <mn/Fabric.h>
+
+#include <assert.h>
+#include <chrono>
+
+const char *vertex_shader = R"""(
+#version 450 core
+
+layout (location = 0) in vec2 pos;
+layout (location = 1) in vec3 color;
+
+out vec3 v_color;
+
+void main()
+{
+	gl_Position = vec4(pos, 0.0, 1.0);
+	v_color = color;
+}
+)""";
+
+const char *pixel_shader = R"""(
+#version 450 core
+
+in vec3 v_color;
+
+out vec4 out_color;
+
+void main()
+{
+	out_color = vec4(v_color, 1.0);
+}
+)""";
+
+constexpr int FRAMES_COUNT = 500;
+
+struct Benchmark
+{
+	Renoir* gfx;
+	Renoir_Window* window;
+	Renoir_Swapchain swapchain;
+	Renoir_Program program;
+	Renoir_Buffer vertices;
+	Renoir_Buffer indices;
+};
+
+static Benchmark
+benchmark_new(Renoir_Settings settings)
+{
+	Benchmark self{};
+	self.gfx = renoir_api();
+	self.window = renoir_window_new(800, 600, "Benchmark", (RENOIR_WINDOW_MSAA_MODE)settings.msaa);
+
+	void *handle, *display;
+	renoir_window_native_handles(self.window, &handle, &display);
+
+	bool ok = self.gfx->init(self.gfx, settings, display);
+	assert(ok && "gfx init failed");
+
+	self.swapchain = self.gfx->swapchain_new(self.gfx, 800, 600, handle, display);
+
+	Renoir_Program_Desc program_desc{};
+	program_desc.vertex.bytes = vertex_shader;
+	program_desc.pixel.bytes = pixel_shader;
+	self.program = self.gfx->program_new(self.gfx, program_desc);
+
+	float triangle_data[] = {
+		-0.01f, -0.01f,
+		 1,  0,  0,
+
+		 0.01f, -0.01f,
+		 0,  1,  0,
+
+		 0,  0.01f,
+		 0,  0,  1,
+	};
+	Renoir_Buffer_Desc vertices_desc{};
+	vertices_desc.type = RENOIR_BUFFER_VERTEX;
+	vertices_desc.data = triangle_data;
+	vertices_desc.data_size = sizeof(triangle_data);
+	self.vertices = self.gfx->buffer_new(self.gfx, vertices_desc);
+
+	uint16_t triangle_indices[] = {
+		0, 1, 2
+	};
+	Renoir_Buffer_Desc indices_desc{};
+	indices_desc.type = RENOIR_BUFFER_INDEX;
+	indices_desc.data = triangle_indices;
+	indices_desc.data_size = sizeof(triangle_indices);
+	self.indices = self.gfx->buffer_new(self.gfx, indices_desc);
+
+	return self;
+}
+
+static void
+benchmark_free(Benchmark& self)
+{
+	self.gfx->program_free(self.gfx, self.program);
+	self.gfx->buffer_free(self.gfx, self.vertices);
+	self.gfx->buffer_free(self.gfx, self.indices);
+	self.gfx->swapchain_free(self.gfx, self.swapchain);
+	self.gfx->dispose(self.gfx);
+	renoir_window_free(self.window);
+}
+
+static Renoir_Draw_Desc
+benchmark_triangle_draw(Benchmark& self)
+{
+	Renoir_Draw_Desc draw{};
+	draw.primitive = RENOIR_PRIMITIVE_TRIANGLES;
+	draw.elements_count = 3;
+	// position
+	draw.vertex_buffers[0].buffer = self.vertices;
+	draw.vertex_buffers[0].type = RENOIR_TYPE_FLOAT_2;
+	draw.vertex_buffers[0].stride = 5 * sizeof(float);
+	// color
+	draw.vertex_buffers[1].buffer = self.vertices;
+	draw.vertex_buffers[1].type = RENOIR_TYPE_FLOAT_3;
+	draw.vertex_buffers[1].stride = 5 * sizeof(float);
+	draw.vertex_buffers[1].offset = 8;
+
+	draw.index_buffer = self.indices;
+	draw.index_type = RENOIR_TYPE_UINT16;
+	return draw;
+}
+
+static void
+benchmark_stats_add(Renoir_GL450_Frame_Stats& total, Renoir_GL450_Frame_Stats stats)
+{
+	total.command_count += stats.command_count;
+	total.command_bytes += stats.command_bytes;
+	total.execute_time_in_nanos += stats.execute_time_in_nanos;
+	total.gl_calls_skipped += stats.gl_calls_skipped;
+	total.gl_state_changes += stats.gl_state_changes;
+	total.draws_merged += stats.draws_merged;
+	total.pipeline_cache_hits += stats.pipeline_cache_hits;
+	total.pipeline_cache_misses += stats.pipeline_cache_misses;
+	total.pipeline_cache_evictions += stats.pipeline_cache_evictions;
+}
+
+static void
+benchmark_report(const char* name, Renoir_GL450_Frame_Stats total, int frames)
+{
+	printf(
+		"%s: %zu commands/frame, %zu bytes/frame, %.3f ms/frame execute, %zu gl calls/frame skipped, %zu gl state changes/frame, %zu draws/frame merged\n",
+		name,
+		total.command_count / frames,
+		total.command_bytes / frames,
+		double(total.execute_time_in_nanos) / frames / 1000000.0,
+		total.gl_calls_skipped / frames,
+		total.gl_state_changes / frames,
+		total.draws_merged / frames
+	);
+}
+
+// records a single pass with 10k small draws each frame and reports the command stream size and execute time
+static void
+benchmark_draws()
+{
+	Renoir_Settings settings{};
+	settings.defer_api_calls = true;
+	auto self = benchmark_new(settings);
+	auto gfx = self.gfx;
+
+	Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+	auto draw = benchmark_triangle_draw(self);
+
+	Renoir_GL450_Frame_Stats total{};
+	for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+	{
+		renoir_window_poll(self.window);
+
+		gfx->pass_begin(gfx, pass);
+
+		Renoir_Clear_Desc clear{};
+		clear.flags = RENOIR_CLEAR(RENOIR_CLEAR_COLOR|RENOIR_CLEAR_DEPTH);
+		clear.color[0] = {0.0f, 0.0f, 0.0f, 1.0f};
+		clear.depth = 1.0f;
+		gfx->clear(gfx, pass, clear);
+
+		gfx->use_pipeline(gfx, pass, Renoir_Pipeline_Desc{});
+		gfx->use_program(gfx, pass, self.program);
+		for (int i = 0; i < 10000; ++i)
+			gfx->draw(gfx, pass, draw);
+
+		gfx->pass_end(gfx, pass);
+		gfx->swapchain_present(gfx, self.swapchain);
+
+		auto stats = renoir_gl450_frame_stats(gfx);
+		benchmark_stats_add(total, stats);
+	}
+	benchmark_report("draws", total, FRAMES_COUNT);
+
+	gfx->pass_free(gfx, pass);
+	benchmark_free(self);
+}
+
+// records 32 offscreen passes with 1k draws each on a varying number of workers, then submits them in order
+static void
+benchmark_record()
+{
+	constexpr int PASSES_COUNT = 32;
+	constexpr int DRAWS_COUNT = 1000;
+	constexpr size_t WORKERS_COUNT[] = {1, 2, 4, 8};
+
+	Renoir_Settings settings{};
+	settings.defer_api_calls = true;
+	auto self = benchmark_new(settings);
+	auto gfx = self.gfx;
+
+	Renoir_Pass passes[PASSES_COUNT];
+	for (int i = 0; i < PASSES_COUNT; ++i)
+	{
+		Renoir_Texture_Desc color_desc{};
+		color_desc.size.width = 256;
+		color_desc.size.height = 256;
+		color_desc.pixel_format = RENOIR_PIXELFORMAT_RGBA8;
+		color_desc.render_target = true;
+
+		Renoir_Pass_Offscreen_Desc pass_desc{};
+		pass_desc.color[0].texture = gfx->texture_new(gfx, color_desc);
+		passes[i] = gfx->pass_offscreen_new(gfx, pass_desc);
+		// the pass holds a reference to the texture
+		gfx->texture_free(gfx, pass_desc.color[0].texture);
+	}
+	auto draw = benchmark_triangle_draw(self);
+
+	for (auto workers_count: WORKERS_COUNT)
+	{
+		mn::Fabric_Settings fabric_settings{};
+		fabric_settings.workers_count = workers_count;
+		auto fabric = mn::fabric_new(fabric_settings);
+
+		uint64_t record_time_in_nanos = 0;
+		Renoir_GL450_Frame_Stats total{};
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			mn::Waitgroup wg{};
+			mn::waitgroup_add(wg, PASSES_COUNT);
+			for (int i = 0; i < PASSES_COUNT; ++i)
+			{
+				mn::go(fabric, [&, pass = passes[i]] {
+					gfx->pass_begin(gfx, pass);
+
+					Renoir_Clear_Desc clear{};
+					clear.flags = RENOIR_CLEAR_COLOR;
+					clear.color[0] = {0.0f, 0.0f, 0.0f, 1.0f};
+					gfx->clear(gfx, pass, clear);
+
+					gfx->use_pipeline(gfx, pass, Renoir_Pipeline_Desc{});
+					gfx->use_program(gfx, pass, self.program);
+					for (int j = 0; j < DRAWS_COUNT; ++j)
+						gfx->draw(gfx, pass, draw);
+
+					gfx->pass_record_end(gfx, pass);
+					mn::waitgroup_done(wg);
+				});
+			}
+			mn::waitgroup_wait(wg);
+			auto end = std::chrono::high_resolution_clock::now();
+			record_time_in_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+			// submission order is the array order no matter which worker finished first
+			gfx->pass_submit(gfx, passes, PASSES_COUNT);
+			gfx->swapchain_present(gfx, self.swapchain);
+
+			auto stats = renoir_gl450_frame_stats(gfx);
+			benchmark_stats_add(total, stats);
+		}
+		mn::fabric_free(fabric);
+
+		double record_ms = double(record_time_in_nanos) / FRAMES_COUNT / 1000000.0;
+		printf(
+			"record: %zu workers, %.3f ms/frame record, %.0f draws/ms\n",
+			workers_count,
+			record_ms,
+			(PASSES_COUNT * DRAWS_COUNT) / record_ms
+		);
+		benchmark_report("record", total, FRAMES_COUNT);
+	}
+
+	for (int i = 0; i < PASSES_COUNT; ++i)
+		gfx->pass_free(gfx, passes[i]);
+	benchmark_free(self);
+}
+
+// replays a bundle of 10k draws which is recorded once instead of recording the draws every frame
+static void
+benchmark_bundle()
+{
+	Renoir_Settings settings{};
+	settings.defer_api_calls = true;
+	auto self = benchmark_new(settings);
+	auto gfx = self.gfx;
+
+	Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+	auto draw = benchmark_triangle_draw(self);
+
+	Renoir_Pass bundle = gfx->pass_bundle_new(gfx);
+	gfx->pass_begin(gfx, bundle);
+	gfx->use_pipeline(gfx, bundle, Renoir_Pipeline_Desc{});
+	gfx->use_program(gfx, bundle, self.program);
+	for (int i = 0; i < 10000; ++i)
+		gfx->draw(gfx, bundle, draw);
+	gfx->pass_end(gfx, bundle);
+
+	uint64_t record_time_in_nanos = 0;
+	Renoir_GL450_Frame_Stats total{};
+	for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+	{
+		renoir_window_poll(self.window);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		gfx->pass_begin(gfx, pass);
+
+		Renoir_Clear_Desc clear{};
+		clear.flags = RENOIR_CLEAR(RENOIR_CLEAR_COLOR|RENOIR_CLEAR_DEPTH);
+		clear.color[0] = {0.0f, 0.0f, 0.0f, 1.0f};
+		clear.depth = 1.0f;
+		gfx->clear(gfx, pass, clear);
+		gfx->bundle_execute(gfx, pass, bundle);
+
+		gfx->pass_end(gfx, pass);
+		auto end = std::chrono::high_resolution_clock::now();
+		record_time_in_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+		gfx->swapchain_present(gfx, self.swapchain);
+
+		auto stats = renoir_gl450_frame_stats(gfx);
+		benchmark_stats_add(total, stats);
+	}
+	printf("bundle: %.3f ms/frame record\n", double(record_time_in_nanos) / FRAMES_COUNT / 1000000.0);
+	benchmark_report("bundle", total, FRAMES_COUNT);
+
+	gfx->pass_free(gfx, bundle);
+	gfx->pass_free(gfx, pass);
+	benchmark_free(self);
+}
+
+// records 10k draws each frame and measures the frame time on the recording side, first without the
+// render thread then with the render thread and different queue sizes
+static void
+benchmark_render_thread()
+{
+	constexpr int QUEUE_SIZES[] = {0, 1, 2, 3};
+
+	for (auto queue_size: QUEUE_SIZES)
+	{
+		Renoir_Settings settings{};
+		settings.defer_api_calls = true;
+		settings.vsync = RENOIR_VSYNC_MODE_OFF;
+		settings.render_thread = queue_size > 0;
+		settings.render_thread_queue_size = queue_size;
+		auto self = benchmark_new(settings);
+		auto gfx = self.gfx;
+
+		Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+		auto draw = benchmark_triangle_draw(self);
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+
+			gfx->pass_begin(gfx, pass);
+
+			Renoir_Clear_Desc clear{};
+			clear.flags = RENOIR_CLEAR(RENOIR_CLEAR_COLOR|RENOIR_CLEAR_DEPTH);
+			clear.color[0] = {0.0f, 0.0f, 0.0f, 1.0f};
+			clear.depth = 1.0f;
+			gfx->clear(gfx, pass, clear);
+
+			gfx->use_pipeline(gfx, pass, Renoir_Pipeline_Desc{});
+			gfx->use_program(gfx, pass, self.program);
+			for (int i = 0; i < 10000; ++i)
+				gfx->draw(gfx, pass, draw);
+
+			gfx->pass_end(gfx, pass);
+			gfx->swapchain_present(gfx, self.swapchain);
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		auto frame_time_in_nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / FRAMES_COUNT;
+
+		if (queue_size > 0)
+			printf("render_thread: queue size %d, %.3f ms/frame\n", queue_size, double(frame_time_in_nanos) / 1000000.0);
+		else
+			printf("render_thread: off, %.3f ms/frame\n", double(frame_time_in_nanos) / 1000000.0);
+
+		gfx->pass_free(gfx, pass);
+		benchmark_free(self);
+	}
+}
+
+// writes 10k small uniform updates each frame and reports the upload arena usage
+static void
+benchmark_uploads()
+{
+	Renoir_Settings settings{};
+	settings.defer_api_calls = true;
+	auto self = benchmark_new(settings);
+	auto gfx = self.gfx;
+
+	Renoir_Buffer_Desc uniform_desc{};
+	uniform_desc.type = RENOIR_BUFFER_UNIFORM;
+	uniform_desc.usage = RENOIR_USAGE_DYNAMIC;
+	uniform_desc.access = RENOIR_ACCESS_WRITE;
+	uniform_desc.data_size = 64;
+	auto uniform = gfx->buffer_new(gfx, uniform_desc);
+
+	Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+
+	float data[16] = {};
+	Renoir_GL450_Frame_Stats total{};
+	Renoir_GL450_Frame_Stats last{};
+	for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+	{
+		renoir_window_poll(self.window);
+
+		gfx->pass_begin(gfx, pass);
+		for (int i = 0; i < 10000; ++i)
+		{
+			data[0] = float(i);
+			gfx->buffer_write(gfx, pass, uniform, 0, data, sizeof(data));
+		}
+		gfx->pass_end(gfx, pass);
+		gfx->swapchain_present(gfx, self.swapchain);
+
+		last = renoir_gl450_frame_stats(gfx);
+		benchmark_stats_add(total, last);
+	}
+	benchmark_report("uploads", total, FRAMES_COUNT);
+	printf(
+		"uploads: %zu upload bytes/frame, %zu bytes high water, %zu bytes arena size\n",
+		last.upload_bytes,
+		last.upload_bytes_high_water,
+		last.upload_arena_size
+	);
+
+	gfx->pass_free(gfx, pass);
+	gfx->buffer_free(gfx, uniform);
+	benchmark_free(self);
+}
+
+// switches between 16 distinct pipelines every 100 draws with different pipeline cache sizes
+// and reports the cache hits/misses/evictions along with the execute time
+static void
+benchmark_pipelines()
+{
+	constexpr int PIPELINES_COUNT = 16;
+	constexpr int CACHE_SIZES[] = {8, 16, 64};
+
+	for (auto cache_size: CACHE_SIZES)
+	{
+		Renoir_Settings settings{};
+		settings.defer_api_calls = true;
+		settings.pipeline_cache_size = cache_size;
+		auto self = benchmark_new(settings);
+		auto gfx = self.gfx;
+
+		Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+		auto draw = benchmark_triangle_draw(self);
+
+		Renoir_Pipeline_Desc pipelines[PIPELINES_COUNT];
+		for (int i = 0; i < PIPELINES_COUNT; ++i)
+		{
+			pipelines[i] = Renoir_Pipeline_Desc{};
+			pipelines[i].rasterizer.cull = (i & 1) ? RENOIR_SWITCH_ENABLE : RENOIR_SWITCH_DISABLE;
+			pipelines[i].depth_stencil.depth = (i & 2) ? RENOIR_SWITCH_ENABLE : RENOIR_SWITCH_DISABLE;
+			pipelines[i].blend[0].enabled = (i & 4) ? RENOIR_SWITCH_ENABLE : RENOIR_SWITCH_DISABLE;
+			pipelines[i].blend[0].color_mask = (i & 8) ? RENOIR_COLOR_MASK_ALL : RENOIR_COLOR_MASK_RED;
+		}
+
+		Renoir_GL450_Frame_Stats total{};
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+
+			gfx->pass_begin(gfx, pass);
+			gfx->use_program(gfx, pass, self.program);
+			for (int i = 0; i < 10000; ++i)
+			{
+				if (i % 100 == 0)
+					gfx->use_pipeline(gfx, pass, pipelines[(i / 100) % PIPELINES_COUNT]);
+				gfx->draw(gfx, pass, draw);
+			}
+			gfx->pass_end(gfx, pass);
+			gfx->swapchain_present(gfx, self.swapchain);
+
+			benchmark_stats_add(total, renoir_gl450_frame_stats(gfx));
+		}
+		printf("pipelines: cache size %d\n", cache_size);
+		benchmark_report("pipelines", total, FRAMES_COUNT);
+		printf(
+			"pipelines: %zu hits/frame, %zu misses/frame, %zu evictions/frame\n",
+			total.pipeline_cache_hits / FRAMES_COUNT,
+			total.pipeline_cache_misses / FRAMES_COUNT,
+			total.pipeline_cache_evictions / FRAMES_COUNT
+		);
+
+		gfx->pass_free(gfx, pass);
+		benchmark_free(self);
+	}
+}
+
+// draws 10k triangles in an interleaved order of 4 pipelines and 8 textures, with the draw sorting off then on
+// and reports the gl state changes per frame
+static void
+benchmark_sort()
+{
+	constexpr int PIPELINES_COUNT = 4;
+	constexpr int TEXTURES_COUNT = 8;
+
+	for (auto draw_sort: {false, true})
+	{
+		Renoir_Settings settings{};
+		settings.defer_api_calls = true;
+		auto self = benchmark_new(settings);
+		auto gfx = self.gfx;
+
+		Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+		gfx->pass_draw_sort(gfx, pass, draw_sort);
+		auto draw = benchmark_triangle_draw(self);
+
+		Renoir_Pipeline_Desc pipelines[PIPELINES_COUNT];
+		for (int i = 0; i < PIPELINES_COUNT; ++i)
+		{
+			pipelines[i] = Renoir_Pipeline_Desc{};
+			pipelines[i].rasterizer.cull = (i & 1) ? RENOIR_SWITCH_ENABLE : RENOIR_SWITCH_DISABLE;
+			pipelines[i].blend[0].enabled = (i & 2) ? RENOIR_SWITCH_ENABLE : RENOIR_SWITCH_DISABLE;
+		}
+
+		Renoir_Texture textures[TEXTURES_COUNT];
+		for (int i = 0; i < TEXTURES_COUNT; ++i)
+		{
+			uint32_t pixel = 0xFF000000 | uint32_t(i * 32);
+			Renoir_Texture_Desc texture_desc{};
+			texture_desc.size.width = 1;
+			texture_desc.size.height = 1;
+			texture_desc.pixel_format = RENOIR_PIXELFORMAT_RGBA8;
+			texture_desc.data[0] = &pixel;
+			texture_desc.data_size = sizeof(pixel);
+			textures[i] = gfx->texture_new(gfx, texture_desc);
+		}
+
+		Renoir_GL450_Frame_Stats total{};
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+
+			gfx->pass_begin(gfx, pass);
+			gfx->use_program(gfx, pass, self.program);
+			for (int i = 0; i < 10000; ++i)
+			{
+				gfx->use_pipeline(gfx, pass, pipelines[i % PIPELINES_COUNT]);
+				gfx->texture_bind(gfx, pass, textures[i % TEXTURES_COUNT], RENOIR_SHADER_PIXEL, 0);
+				draw.sort_depth = float(i % 100) / 100.0f;
+				gfx->draw(gfx, pass, draw);
+			}
+			gfx->pass_end(gfx, pass);
+			gfx->swapchain_present(gfx, self.swapchain);
+
+			benchmark_stats_add(total, renoir_gl450_frame_stats(gfx));
+		}
+		benchmark_report(draw_sort ? "sort: on" : "sort: off", total, FRAMES_COUNT);
+
+		for (int i = 0; i < TEXTURES_COUNT; ++i)
+			gfx->texture_free(gfx, textures[i]);
+		gfx->pass_free(gfx, pass);
+		benchmark_free(self);
+	}
+}
+
+// records 10k draws of the same triangle each frame, once as separate draw calls and once as a single draw_batch,
+// and reports the record time along with the command stream size and execute time
+static void
+benchmark_batch()
+{
+	constexpr int DRAWS_COUNT = 10000;
+
+	for (int batched = 0; batched < 2; ++batched)
+	{
+		Renoir_Settings settings{};
+		settings.defer_api_calls = true;
+		auto self = benchmark_new(settings);
+		auto gfx = self.gfx;
+
+		Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+		auto draw = benchmark_triangle_draw(self);
+
+		static Renoir_Draw_Range ranges[DRAWS_COUNT];
+		for (auto& range: ranges)
+		{
+			range = Renoir_Draw_Range{};
+			range.elements_count = draw.elements_count;
+		}
+
+		uint64_t record_time_in_nanos = 0;
+		Renoir_GL450_Frame_Stats total{};
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+
+			gfx->pass_begin(gfx, pass);
+
+			Renoir_Clear_Desc clear{};
+			clear.flags = RENOIR_CLEAR_COLOR;
+			clear.color[0] = {0.0f, 0.0f, 0.0f, 1.0f};
+			gfx->clear(gfx, pass, clear);
+
+			gfx->use_pipeline(gfx, pass, Renoir_Pipeline_Desc{});
+			gfx->use_program(gfx, pass, self.program);
+
+			auto start = std::chrono::high_resolution_clock::now();
+			if (batched)
+			{
+				gfx->draw_batch(gfx, pass, &draw, ranges, DRAWS_COUNT);
+			}
+			else
+			{
+				for (int i = 0; i < DRAWS_COUNT; ++i)
+					gfx->draw(gfx, pass, draw);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			record_time_in_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+			gfx->pass_end(gfx, pass);
+			gfx->swapchain_present(gfx, self.swapchain);
+
+			benchmark_stats_add(total, renoir_gl450_frame_stats(gfx));
+		}
+		printf("%s: %.3f ms/frame record\n", batched ? "batch: draw_batch" : "batch: draw", double(record_time_in_nanos) / FRAMES_COUNT / 1000000.0);
+		benchmark_report(batched ? "batch: draw_batch" : "batch: draw", total, FRAMES_COUNT);
+
+		gfx->pass_free(gfx, pass);
+		benchmark_free(self);
+	}
+}
+
+// uploads 100 meshes of 1k triangles each frame and draws each of them 10 times, once with static buffers which are
+// created with the data (immutable storage without dynamic flags) and once with dynamic buffers which are written,
+// and reports the frame time along with the execute time
+static void
+benchmark_storage()
+{
+	constexpr int MESHES_COUNT = 100;
+	constexpr int TRIANGLES_COUNT = 1000;
+	constexpr int DRAWS_COUNT = 10;
+
+	static float mesh_data[TRIANGLES_COUNT * 3 * 5];
+	for (int i = 0; i < TRIANGLES_COUNT * 3; ++i)
+	{
+		auto vertex = mesh_data + i * 5;
+		vertex[0] = (i % 3 == 1 ? 0.01f : -0.01f) + float(i % 97) / 97.0f - 0.5f;
+		vertex[1] = (i % 3 == 2 ? 0.01f : -0.01f) + float(i % 89) / 89.0f - 0.5f;
+		vertex[2] = float(i % 3 == 0);
+		vertex[3] = float(i % 3 == 1);
+		vertex[4] = float(i % 3 == 2);
+	}
+
+	for (int dynamic = 0; dynamic < 2; ++dynamic)
+	{
+		Renoir_Settings settings{};
+		auto self = benchmark_new(settings);
+		auto gfx = self.gfx;
+
+		Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+
+		Renoir_Buffer_Desc mesh_desc{};
+		mesh_desc.type = RENOIR_BUFFER_VERTEX;
+		mesh_desc.data = mesh_data;
+		mesh_desc.data_size = sizeof(mesh_data);
+		if (dynamic)
+		{
+			mesh_desc.usage = RENOIR_USAGE_DYNAMIC;
+			mesh_desc.access = RENOIR_ACCESS_WRITE;
+		}
+
+		Renoir_Buffer meshes[MESHES_COUNT] = {};
+		if (dynamic)
+		{
+			for (auto& mesh: meshes)
+				mesh = gfx->buffer_new(gfx, mesh_desc);
+		}
+
+		uint64_t frame_time_in_nanos = 0;
+		Renoir_GL450_Frame_Stats total{};
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+			auto start = std::chrono::high_resolution_clock::now();
+
+			gfx->pass_begin(gfx, pass);
+
+			Renoir_Clear_Desc clear{};
+			clear.flags = RENOIR_CLEAR_COLOR;
+			clear.color[0] = {0.0f, 0.0f, 0.0f, 1.0f};
+			gfx->clear(gfx, pass, clear);
+
+			gfx->use_pipeline(gfx, pass, Renoir_Pipeline_Desc{});
+			gfx->use_program(gfx, pass, self.program);
+
+			for (auto& mesh: meshes)
+			{
+				if (dynamic)
+					gfx->buffer_write(gfx, pass, mesh, 0, mesh_data, sizeof(mesh_data));
+				else
+					mesh = gfx->buffer_new(gfx, mesh_desc);
+
+				Renoir_Draw_Desc draw{};
+				draw.primitive = RENOIR_PRIMITIVE_TRIANGLES;
+				draw.elements_count = TRIANGLES_COUNT * 3;
+				draw.vertex_buffers[0].buffer = mesh;
+				draw.vertex_buffers[0].type = RENOIR_TYPE_FLOAT_2;
+				draw.vertex_buffers[0].stride = 5 * sizeof(float);
+				draw.vertex_buffers[1].buffer = mesh;
+				draw.vertex_buffers[1].type = RENOIR_TYPE_FLOAT_3;
+				draw.vertex_buffers[1].stride = 5 * sizeof(float);
+				draw.vertex_buffers[1].offset = 8;
+				for (int i = 0; i < DRAWS_COUNT; ++i)
+					gfx->draw(gfx, pass, draw);
+			}
+
+			gfx->pass_end(gfx, pass);
+
+			if (dynamic == false)
+			{
+				for (auto mesh: meshes)
+					gfx->buffer_free(gfx, mesh);
+			}
+			gfx->swapchain_present(gfx, self.swapchain);
+
+			auto end = std::chrono::high_resolution_clock::now();
+			frame_time_in_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			benchmark_stats_add(total, renoir_gl450_frame_stats(gfx));
+		}
+		printf("%s: %.3f ms/frame\n", dynamic ? "storage: dynamic" : "storage: static", double(frame_time_in_nanos) / FRAMES_COUNT / 1000000.0);
+		benchmark_report(dynamic ? "storage: dynamic" : "storage: static", total, FRAMES_COUNT);
+
+		if (dynamic)
+		{
+			for (auto mesh: meshes)
+				gfx->buffer_free(gfx, mesh);
+		}
+		gfx->pass_free(gfx, pass);
+		benchmark_free(self);
+	}
+}
+
+// writes a full RGBA8 frame into a dynamic texture each frame, like a video texture, and reports the upload
+// throughput for 1080p and 4K frames
+static void
+benchmark_texture_stream()
+{
+	struct Resolution { const char* name; int width, height; };
+	Resolution resolutions[] = {
+		{"texture_stream: 1080p", 1920, 1080},
+		{"texture_stream: 4K", 3840, 2160},
+	};
+
+	for (auto resolution: resolutions)
+	{
+		Renoir_Settings settings{};
+		auto self = benchmark_new(settings);
+		auto gfx = self.gfx;
+
+		size_t frame_size = size_t(resolution.width) * resolution.height * 4;
+		auto pixels_block = mn::alloc(frame_size, alignof(uint8_t));
+		auto pixels = (uint8_t*)pixels_block.ptr;
+		::memset(pixels, 0x7F, frame_size);
+
+		Renoir_Texture_Desc texture_desc{};
+		texture_desc.size.width = resolution.width;
+		texture_desc.size.height = resolution.height;
+		texture_desc.usage = RENOIR_USAGE_DYNAMIC;
+		texture_desc.access = RENOIR_ACCESS_WRITE;
+		texture_desc.pixel_format = RENOIR_PIXELFORMAT_RGBA8;
+		auto texture = gfx->texture_new(gfx, texture_desc);
+
+		Renoir_Pass pass = gfx->pass_swapchain_new(gfx, self.swapchain);
+
+		uint64_t frame_time_in_nanos = 0;
+		Renoir_GL450_Frame_Stats total{};
+		for (int frame = 0; frame < FRAMES_COUNT; ++frame)
+		{
+			renoir_window_poll(self.window);
+			// change the frame a little so the driver can't skip the upload
+			pixels[0] = uint8_t(frame);
+			auto start = std::chrono::high_resolution_clock::now();
+
+			gfx->pass_begin(gfx, pass);
+			Renoir_Texture_Edit_Desc edit{};
+			edit.width = resolution.width;
+			edit.height = resolution.height;
+			edit.bytes = pixels;
+			edit.bytes_size = frame_size;
+			gfx->texture_write(gfx, pass, texture, edit);
+			gfx->pass_end(gfx, pass);
+			gfx->swapchain_present(gfx, self.swapchain);
+
+			auto end = std::chrono::high_resolution_clock::now();
+			frame_time_in_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			benchmark_stats_add(total, renoir_gl450_frame_stats(gfx));
+		}
+		auto seconds = double(frame_time_in_nanos) / 1000000000.0;
+		printf(
+			"%s: %.3f ms/frame, %.1f MB/s uploaded\n",
+			resolution.name,
+			double(frame_time_in_nanos) / FRAMES_COUNT / 1000000.0,
+			double(frame_size) * FRAMES_COUNT / (1024.0 * 1024.0) / seconds
+		);
+		benchmark_report(resolution.name, total, FRAMES_COUNT);
+
+		gfx->pass_free(gfx, pass);
+		gfx->texture_free(gfx, texture);
+		mn::free(pixels_block);
+		benchmark_free(self);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const char* name = argc > 1 ? argv[1] : "draws";
+
+	if (strcmp(name, "draws") == 0)
+	{
+		benchmark_draws();
+	}
+	else if (strcmp(name, "record") == 0)
+	{
+		benchmark_record();
+	}
+	else if (strcmp(name, "bundle") == 0)
+	{
+		benchmark_bundle();
+	}
+	else if (strcmp(name, "render_thread") == 0)
+	{
+		benchmark_render_thread();
+	}
+	else if (strcmp(name, "uploads") == 0)
+	{
+		benchmark_uploads();
+	}
+	else if (strcmp(name, "pipelines") == 0)
+	{
+		benchmark_pipelines();
+	}
+	else if (strcmp(name, "sort") == 0)
+	{
+		benchmark_sort();
+	}
+	else if (strcmp(name, "batch") == 0)
+	{
+		benchmark_batch();
+	}
+	else if (strcmp(name, "storage") == 0)
+	{
+		benchmark_storage();
+	}
+	else if (strcmp(name, "texture_stream") == 0)
+	{
+		benchmark_texture_stream();
+	}
+	else
+	{
+		printf("unknown benchmark '%s', available benchmarks: draws, record, bundle, render_thread, uploads, pipelines, sort, batch, storage, texture_stream\n", name);
+		return 1;
+	}
+	return 0;
+}
@@ -11,7 +11,12 @@ typedef enum RENOIR_CONSTANT {
 	RENOIR_CONSTANT_DEFAULT_SAMPLER_CACHE_SIZE = 32,
 	RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE = 10,
 	RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE = 4,
-	RENOIR_CONSTANT_DEFAULT_PIPELINE_CACHE_SIZE = 64
+	RENOIR_CONSTANT_DEFAULT_PIPELINE_CACHE_SIZE = 64,
+	RENOIR_CONSTANT_DEFAULT_RENDER_THREAD_QUEUE_SIZE = 2,
+	RENOIR_CONSTANT_MULTI_BIND_SIZE = 16,
+	RENOIR_CONSTANT_DEFAULT_TRANSIENT_BUFFER_SIZE = 4 * 1024 * 1024,
+	RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT = 3,
+	RENOIR_CONSTANT_DEFAULT_MAX_FRAMES_IN_FLIGHT = 3
 } RENOIR_CONSTANT;
 
 // Enums
@@ -33,7 +38,9 @@ typedef enum RENOIR_BUFFER {
 	RENOIR_BUFFER_VERTEX,
 	RENOIR_BUFFER_INDEX,
 	RENOIR_BUFFER_UNIFORM,
-	RENOIR_BUFFER_COMPUTE
+	RENOIR_BUFFER_COMPUTE,
+	// holds the arguments of indirect draws/dispatches, it can be written by compute shaders using buffer_compute_bind
+	RENOIR_BUFFER_INDIRECT
 } RENOIR_BUFFER;
 
 typedef enum RENOIR_USAGE {
@@ -205,6 +212,8 @@ typedef struct Renoir_Compute { void* handle; } Renoir_Compute;
 typedef struct Renoir_Pass { void* handle; } Renoir_Pass;
 typedef struct Renoir_Swapchain { void* handle; } Renoir_Swapchain;
 typedef struct Renoir_Timer { void* handle; } Renoir_Timer;
+typedef struct Renoir_Readback { void* handle; } Renoir_Readback;
+typedef struct Renoir_Fence { void* handle; } Renoir_Fence;
 
 
 // Descriptons
@@ -227,6 +236,19 @@ typedef struct Renoir_Settings {
 	RENOIR_VSYNC_MODE vsync; // default: RENOIR_VSYNC_MODE_ON
 	int sampler_cache_size; // default: RENOIR_CONSTANT_DEFAULT_SAMPLER_CACHE_SIZE
 	int pipeline_cache_size; // default: RENOIR_CONSTANT_DEFAULT_PIPELINE_CACHE_SIZE
+	// gl450 only, executes the deferred commands on a dedicated thread which owns the gl context so that
+	// recording of the next frame overlaps with the execution of the current one, it implies defer_api_calls
+	// and it's not supported with external_context or hot reloading
+	bool render_thread; // default: false
+	// number of frames which can be queued to the render thread before swapchain_present/flush blocks
+	int render_thread_queue_size; // default: RENOIR_CONSTANT_DEFAULT_RENDER_THREAD_QUEUE_SIZE
+	// gl450 only, initial size of the ring which backs the transient allocations, it grows if a frame doesn't fit
+	size_t transient_buffer_size; // default: RENOIR_CONSTANT_DEFAULT_TRANSIENT_BUFFER_SIZE
+	// number of presented frames which the gpu can lag behind before the next present blocks, lower values reduce
+	// the input latency with vsync off, it's clamped to [1, RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT]
+	int max_frames_in_flight; // default: RENOIR_CONSTANT_DEFAULT_MAX_FRAMES_IN_FLIGHT
+	// caps the frame rate by sleeping in swapchain_present until the frame's time slot, 0 means no cap
+	int max_frame_rate; // default: 0
 } Renoir_Settings;
 
 typedef struct Renoir_Depth_Desc {
@@ -322,6 +344,8 @@ typedef struct Renoir_Vertex_Desc {
 	RENOIR_TYPE type;
 	size_t stride;
 	size_t offset;
+	// 0 means per vertex data, n means the attribute advances once every n instances
+	int instance_step_rate; // default: 0
 } Renoir_Vertex_Desc;
 
 typedef struct Renoir_Draw_Desc {
@@ -329,11 +353,61 @@ typedef struct Renoir_Draw_Desc {
 	int base_element;
 	int elements_count;
 	int instances_count;
+	// added to each index before fetching the vertices, only used by indexed draws
+	int base_vertex;
+	// first instance fed to the per instance vertex buffers
+	int base_instance;
 	Renoir_Vertex_Desc vertex_buffers[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
 	Renoir_Buffer index_buffer;
 	RENOIR_TYPE index_type; // default: RENOIR_TYPE_UINT16
+	// byte offset of the indices in the index buffer, it's not supported by indirect draws
+	size_t index_offset;
+	// used by passes with draw sorting enabled, draws with the same state are sorted front to back
+	float sort_depth;
+	// draws which depend on their submission order (e.g. transparent) are neither moved nor crossed by the sorting
+	bool sort_ordered;
 } Renoir_Draw_Desc;
 
+// memory which is only valid for the frame it's allocated in, the data should be written through ptr before the
+// frame is presented/flushed, and it's used through buffer with the offset in vertex descs, index_offset, or buffer_bind_range
+typedef struct Renoir_Transient {
+	Renoir_Buffer buffer;
+	size_t offset;
+	size_t size;
+	void* ptr;
+} Renoir_Transient;
+
+// the per draw part of a Renoir_Draw_Desc, used by draw_batch to issue many draws which share the same buffers
+typedef struct Renoir_Draw_Range {
+	int base_element;
+	int elements_count;
+	int instances_count;
+	int base_vertex;
+	int base_instance;
+} Renoir_Draw_Range;
+
+// layout of the arguments of indirect draws without an index buffer
+typedef struct Renoir_Draw_Indirect_Args {
+	uint32_t elements_count;
+	uint32_t instances_count;
+	uint32_t base_element;
+	uint32_t base_instance;
+} Renoir_Draw_Indirect_Args;
+
+// layout of the arguments of indirect draws with an index buffer
+typedef struct Renoir_Draw_Indexed_Indirect_Args {
+	uint32_t elements_count;
+	uint32_t instances_count;
+	uint32_t base_element;
+	int32_t base_vertex;
+	uint32_t base_instance;
+} Renoir_Draw_Indexed_Indirect_Args;
+
+// layout of the arguments of indirect dispatches, it's the number of work groups in each dimension
+typedef struct Renoir_Dispatch_Indirect_Args {
+	uint32_t x, y, z;
+} Renoir_Dispatch_Indirect_Args;
+
 typedef struct Renoir_Texture_Edit_Desc {
 	int x, y, z;
 	int width, height, depth;
@@ -341,6 +415,16 @@ typedef struct Renoir_Texture_Edit_Desc {
 	size_t bytes_size;
 } Renoir_Texture_Read_Desc;
 
+typedef struct Renoir_Texture_Read_Async_Desc {
+	// for cube maps z should hold the face index (RENOIR_CUBE_FACE), 0 height/depth are treated as 1
+	int x, y, z;
+	int width, height, depth;
+	// mip map level to read
+	int level;
+	// distance in bytes between the rows of the read pixels, 0 means they're tightly packed
+	size_t row_pitch;
+} Renoir_Texture_Read_Async_Desc;
+
 typedef struct Renoir_Pass_Attachment {
 	Renoir_Texture texture;
 	// this is used for cube maps and it should hold face index (RENOIR_CUBE_FACE), otherwise it should be 0
@@ -393,42 +477,113 @@ typedef struct Renoir
 	Renoir_Pass (*pass_swapchain_new)(struct Renoir* api, Renoir_Swapchain view);
 	Renoir_Pass (*pass_offscreen_new)(struct Renoir* api, Renoir_Pass_Offscreen_Desc desc);
 	Renoir_Pass (*pass_compute_new)(struct Renoir* api);
+	// bundles are recorded once like a raster pass (pass_begin, commands, pass_end) then replayed into
+	// other passes using bundle_execute, they are freed using pass_free
+	Renoir_Pass (*pass_bundle_new)(struct Renoir* api);
 	void (*pass_free)(struct Renoir* api, Renoir_Pass pass);
 	Renoir_Size (*pass_size)(struct Renoir* api, Renoir_Pass pass);
 	Renoir_Pass_Offscreen_Desc (*pass_offscreen_desc)(struct Renoir* api, Renoir_Pass pass);
+	// opt-in, groups the draws of the raster pass with the state they use and sorts them by program, pipeline,
+	// textures, and depth when the pass recording ends, backends which don't support it ignore it
+	void (*pass_draw_sort)(struct Renoir* api, Renoir_Pass pass, bool enabled);
 
 	Renoir_Timer (*timer_new)(struct Renoir* api);
 	void (*timer_free)(struct Renoir* api, Renoir_Timer timer);
 	bool (*timer_elapsed)(struct Renoir* api, Renoir_Timer timer, uint64_t* elapsed_time_in_nanos);
 
+	// readbacks are tickets of the async reads, poll returns false until the gpu finishes the copy then it returns true
+	// and sets data to the read bytes, they stay valid until the readback is freed, if wait is true it blocks until
+	// the copy is done, but it can't wait for copies which weren't submitted yet
+	bool (*readback_poll)(struct Renoir* api, Renoir_Readback readback, bool wait, const void** data);
+	void (*readback_free)(struct Renoir* api, Renoir_Readback readback);
+
+	// fences are signaled once the gpu finishes all the commands before their last fence_insert, a fence which
+	// was never inserted isn't signaled
+	Renoir_Fence (*fence_new)(struct Renoir* api);
+	void (*fence_free)(struct Renoir* api, Renoir_Fence fence);
+	bool (*fence_signaled)(struct Renoir* api, Renoir_Fence fence);
+	// waits up to timeout_in_nanos for the fence and returns whether it's signaled, it can't wait for inserts
+	// which weren't submitted yet
+	bool (*fence_wait)(struct Renoir* api, Renoir_Fence fence, uint64_t timeout_in_nanos);
+
 	// Graphics Commands
 	void (*pass_begin)(struct Renoir* api, Renoir_Pass pass);
 	void (*pass_end)(struct Renoir* api, Renoir_Pass pass);
+	// ends the pass recording without submitting its commands, different passes can be recorded
+	// concurrently on different threads and then submitted in a deterministic order using pass_submit
+	void (*pass_record_end)(struct Renoir* api, Renoir_Pass pass);
+	// submits the recorded passes in the given order, pass_end is pass_record_end followed by pass_submit
+	void (*pass_submit)(struct Renoir* api, Renoir_Pass* passes, size_t passes_count);
 	void (*clear)(struct Renoir* api, Renoir_Pass pass, Renoir_Clear_Desc desc);
 	void (*use_pipeline)(struct Renoir* api, Renoir_Pass pass, Renoir_Pipeline_Desc pipeline);
 	void (*use_program)(struct Renoir* api, Renoir_Pass pass, Renoir_Program program);
 	void (*use_compute)(struct Renoir* api, Renoir_Pass pass, Renoir_Compute compute);
 	void (*scissor)(struct Renoir* api, Renoir_Pass pass, int x, int y, int width, int height);
+	void (*bundle_execute)(struct Renoir* api, Renoir_Pass pass, Renoir_Pass bundle);
 	// Write Functions
 	void (*buffer_write)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, void* bytes, size_t bytes_size);
 	void (*texture_write)(struct Renoir* api, Renoir_Pass pass, Renoir_Texture texture, Renoir_Texture_Edit_Desc desc);
 	// Read Functions
 	void (*buffer_read)(struct Renoir* api, Renoir_Buffer buffer, size_t offset, void* bytes, size_t bytes_size);
 	void (*texture_read)(struct Renoir* api, Renoir_Texture texture, Renoir_Texture_Edit_Desc desc);
+	// records a copy of size bytes of the buffer starting at offset into a staging buffer, it doesn't stall the pipeline
+	// like buffer_read, the data is read using readback_poll a frame or two later, the buffer doesn't need cpu read access
+	Renoir_Readback (*buffer_read_async)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, size_t size);
+	// same as buffer_read_async but it reads a region of the texture, the data is row_pitch * height * depth bytes with
+	// the same pixel layout as texture_read, msaa textures can't be read, dx11 only supports 2D textures and cube maps
+	Renoir_Readback (*texture_read_async)(struct Renoir* api, Renoir_Pass pass, Renoir_Texture texture, Renoir_Texture_Read_Async_Desc desc);
+	// Map Functions
+	// maps size bytes of the buffer starting at offset, a buffer can only have one mapped range at a time
+	// - RENOIR_ACCESS_WRITE: returns memory which buffer_unmap records into the pass as a buffer write, so the data is written
+	//   in place instead of being copied by buffer_write, the previous contents of the range are undefined
+	// - RENOIR_ACCESS_READ: returns the contents of the range like buffer_read, the memory is the gl mapping itself when
+	//   the calling thread owns the context, otherwise it's a copy, the pass is ignored
+	void* (*buffer_map)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, size_t size, RENOIR_ACCESS access);
+	void (*buffer_unmap)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer);
+	// Transient Functions
+	// allocates size bytes of vertex, index, or uniform data for the current frame, gl450 only, it returns an empty
+	// transient (null ptr) if it fails, transient memory shouldn't be used in bundles since they outlive the frame
+	Renoir_Transient (*transient_alloc)(struct Renoir* api, RENOIR_BUFFER type, size_t size);
 	// Bind Functions
 	void (*buffer_bind)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RENOIR_SHADER shader, int slot);
+	// binds size bytes of the buffer starting at offset, the offset should be aligned to 256 bytes for uniform buffers,
+	// dx11 only supports offset 0
+	void (*buffer_bind_range)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RENOIR_SHADER shader, int slot, size_t offset, size_t size);
 	void (*texture_bind)(struct Renoir* api, Renoir_Pass pass, Renoir_Texture texture, RENOIR_SHADER shader, int slot);
 	void (*texture_sampler_bind)(struct Renoir* api, Renoir_Pass pass, Renoir_Texture texture, RENOIR_SHADER shader, int slot, Renoir_Sampler_Desc sampler);
+	// binds textures[i] to slot first_slot + i in a single command, each texture uses samplers[i] or its own sampler if
+	// samplers is null, textures_count is at most RENOIR_CONSTANT_MULTI_BIND_SIZE
+	void (*textures_bind)(struct Renoir* api, Renoir_Pass pass, const Renoir_Texture* textures, const Renoir_Sampler_Desc* samplers, int textures_count, RENOIR_SHADER shader, int first_slot);
+	// binds the uniform buffers[i] to slot first_slot + i in a single command, buffers_count is at most RENOIR_CONSTANT_MULTI_BIND_SIZE
+	void (*buffers_bind)(struct Renoir* api, Renoir_Pass pass, const Renoir_Buffer* buffers, int buffers_count, RENOIR_SHADER shader, int first_slot);
 	// Compute Bind Functions
 	void (*buffer_compute_bind)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, int slot, RENOIR_ACCESS gpu_access);
 	void (*texture_compute_bind)(struct Renoir* api, Renoir_Pass pass, Renoir_Texture texture, int slot, RENOIR_ACCESS gpu_access);
 	// Draw
 	void (*draw)(struct Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc);
+	// records ranges_count draws as a single command, they use the primitive, vertex buffers, and index buffer of the
+	// base desc and the ranges replace its elements and instances, the ranges are copied so they can be reused right away
+	void (*draw_batch)(struct Renoir* api, Renoir_Pass pass, const Renoir_Draw_Desc* base, const Renoir_Draw_Range* ranges, size_t ranges_count);
+	// indirect draws read their arguments from a RENOIR_BUFFER_INDIRECT buffer at the given offset, the desc only supplies
+	// the primitive, vertex buffers, and index buffer, the arguments are Renoir_Draw_Indexed_Indirect_Args if the desc
+	// has an index buffer and Renoir_Draw_Indirect_Args otherwise
+	void (*draw_indirect)(struct Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset);
+	// stride is the distance between consecutive arguments, 0 means they're tightly packed
+	void (*multi_draw_indirect)(struct Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, int draws_count, size_t stride);
+	// same as multi_draw_indirect but the draws count is a uint32_t read from count_buffer at count_offset, it's clamped
+	// to max_draws_count, gl450 only and it requires GL_ARB_indirect_parameters
+	void (*multi_draw_indirect_count)(struct Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, Renoir_Buffer count_buffer, size_t count_offset, int max_draws_count, size_t stride);
 	// Dispatch
 	void (*dispatch)(struct Renoir* api, Renoir_Pass pass, int x, int y, int z);
+	// reads Renoir_Dispatch_Indirect_Args from a RENOIR_BUFFER_INDIRECT buffer at the given offset, so compute passes
+	// can consume the counts written by a previous dispatch without reading them back to the cpu
+	void (*dispatch_indirect)(struct Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset);
 	// Timer
 	void (*timer_begin)(struct Renoir* api, Renoir_Pass pass, Renoir_Timer timer);
 	void (*timer_end)(struct Renoir* api, Renoir_Pass pass, Renoir_Timer timer);
+	// Fence
+	// inserting a fence again rearms it, so it's only signaled once the gpu reaches the new insert
+	void (*fence_insert)(struct Renoir* api, Renoir_Pass pass, Renoir_Fence fence);
 } Renoir;
 
 #define RENOIR_API "renoir"
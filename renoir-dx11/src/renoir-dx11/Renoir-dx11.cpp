@@ -14,6 +14,8 @@
 #include <mn/Debug.h>
 
 #include <atomic>
+#include <chrono>
+#include <thread>
 #include <assert.h>
 #include <math.h>
 #include <stdio.h>
@@ -23,6 +25,10 @@
 #include <d3dcompiler.h>
 #include <dxgi.h>
 
+// CREATE_WAITABLE_TIMER_HIGH_RESOLUTION is only defined by the windows 10 1803+ sdks, older windows versions
+// fail to create the timer with it and we fall back to the regular sleep
+constexpr DWORD RENOIR_DX11_CREATE_WAITABLE_TIMER_HIGH_RESOLUTION = 0x00000002;
+
 inline static int
 _renoir_buffer_type_to_dx(RENOIR_BUFFER type)
 {
@@ -32,6 +38,8 @@ _renoir_buffer_type_to_dx(RENOIR_BUFFER type)
 	case RENOIR_BUFFER_UNIFORM: return D3D11_BIND_CONSTANT_BUFFER;
 	case RENOIR_BUFFER_INDEX: return D3D11_BIND_INDEX_BUFFER;
 	case RENOIR_BUFFER_COMPUTE: return D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
+	// indirect arguments are usually generated by compute shaders so we expose them as raw views
+	case RENOIR_BUFFER_INDIRECT: return D3D11_BIND_UNORDERED_ACCESS | D3D11_BIND_SHADER_RESOURCE;
 	default: assert(false && "unreachable"); return 0;
 	}
 }
@@ -307,6 +315,16 @@ enum RENOIR_TIMER_STATE
 	RENOIR_TIMER_STATE_READY,
 };
 
+enum RENOIR_READBACK_STATE
+{
+	// readback copy has been recorded but it didn't execute yet or the gpu didn't finish it
+	RENOIR_READBACK_STATE_PENDING,
+	// readback poll has been scheduled but the actual query polling hasn't executed yet
+	RENOIR_READBACK_STATE_POLL_SCHEDULED,
+	// readback copy is done and the staging buffer is mapped
+	RENOIR_READBACK_STATE_READY,
+};
+
 enum RENOIR_HANDLE_KIND
 {
 	RENOIR_HANDLE_KIND_NONE,
@@ -320,6 +338,9 @@ enum RENOIR_HANDLE_KIND
 	RENOIR_HANDLE_KIND_COMPUTE,
 	RENOIR_HANDLE_KIND_PIPELINE,
 	RENOIR_HANDLE_KIND_TIMER,
+	RENOIR_HANDLE_KIND_BUNDLE,
+	RENOIR_HANDLE_KIND_READBACK,
+	RENOIR_HANDLE_KIND_FENCE,
 };
 
 struct Renoir_Handle
@@ -370,6 +391,11 @@ struct Renoir_Handle
 			ID3D11Buffer* buffer_staging;
 			ID3D11ShaderResourceView* srv;
 			ID3D11UnorderedAccessView* uav;
+			// the range mapped by buffer_map, map_ptr is null if the buffer isn't mapped
+			void* map_ptr;
+			size_t map_offset;
+			size_t map_size;
+			RENOIR_ACCESS map_access;
 		} buffer;
 
 		struct
@@ -425,6 +451,40 @@ struct Renoir_Handle
 			uint64_t elapsed_time_in_nanos;
 			RENOIR_TIMER_STATE state;
 		} timer;
+
+		struct
+		{
+			ID3D11Resource* staging;
+			// signaled when the gpu finishes the copy
+			ID3D11Query* event;
+			void* mapped;
+			// texture readbacks are copied out of the mapped staging texture to use the requested row pitch,
+			// buffer readbacks have 0 rows and use the mapped staging buffer directly
+			mn::Block bytes;
+			size_t row_size;
+			size_t row_pitch;
+			int rows;
+			RENOIR_READBACK_STATE state;
+		} readback;
+
+		struct
+		{
+			// event query of the last executed insert, it's created by the first insert
+			ID3D11Query* query;
+			uint64_t query_generation;
+			// every insert has a new generation, the fence is signaled once the gpu reaches the last inserted one
+			uint64_t inserted_generation;
+			uint64_t signaled_generation;
+			bool poll_scheduled;
+		} fence;
+
+		struct
+		{
+			Renoir_Command *command_list_head;
+			Renoir_Command *command_list_tail;
+			// bundles are recorded once, after that they hold a reference to all the handles they use
+			bool recorded;
+		} bundle;
 	};
 };
 
@@ -443,6 +503,9 @@ _renoir_handle_kind_name(RENOIR_HANDLE_KIND kind)
 	case RENOIR_HANDLE_KIND_PROGRAM: return "program";
 	case RENOIR_HANDLE_KIND_COMPUTE: return "compute";
 	case RENOIR_HANDLE_KIND_PIPELINE: return "pipeline";
+	case RENOIR_HANDLE_KIND_BUNDLE: return "bundle";
+	case RENOIR_HANDLE_KIND_READBACK: return "readback";
+	case RENOIR_HANDLE_KIND_FENCE: return "fence";
 	default: assert(false && "invalid handle kind"); return "<INVALID>";
 	}
 }
@@ -460,7 +523,8 @@ _renoir_handle_kind_should_track(RENOIR_HANDLE_KIND kind)
 		// we ignore the samplers because they are cached not user created
 		// kind == RENOIR_HANDLE_KIND_SAMPLER ||
 		kind == RENOIR_HANDLE_KIND_PROGRAM ||
-		kind == RENOIR_HANDLE_KIND_COMPUTE
+		kind == RENOIR_HANDLE_KIND_COMPUTE ||
+		kind == RENOIR_HANDLE_KIND_BUNDLE
 		// we ignore the pipeline because they are cached not user created
 		// kind == RENOIR_HANDLE_KIND_PIPELINE
 	);
@@ -537,6 +601,10 @@ enum RENOIR_COMMAND_KIND
 	RENOIR_COMMAND_KIND_TIMER_NEW,
 	RENOIR_COMMAND_KIND_TIMER_FREE,
 	RENOIR_COMMAND_KIND_TIMER_ELAPSED,
+	RENOIR_COMMAND_KIND_READBACK_FREE,
+	RENOIR_COMMAND_KIND_READBACK_POLL,
+	RENOIR_COMMAND_KIND_FENCE_FREE,
+	RENOIR_COMMAND_KIND_FENCE_POLL,
 	RENOIR_COMMAND_KIND_PASS_BEGIN,
 	RENOIR_COMMAND_KIND_PASS_END,
 	RENOIR_COMMAND_KIND_PASS_CLEAR,
@@ -548,12 +616,21 @@ enum RENOIR_COMMAND_KIND
 	RENOIR_COMMAND_KIND_TEXTURE_WRITE,
 	RENOIR_COMMAND_KIND_BUFFER_READ,
 	RENOIR_COMMAND_KIND_TEXTURE_READ,
+	RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC,
+	RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC,
 	RENOIR_COMMAND_KIND_BUFFER_BIND,
 	RENOIR_COMMAND_KIND_TEXTURE_BIND,
+	RENOIR_COMMAND_KIND_TEXTURES_BIND,
+	RENOIR_COMMAND_KIND_BUFFERS_BIND,
 	RENOIR_COMMAND_KIND_DRAW,
+	RENOIR_COMMAND_KIND_DRAW_INDIRECT,
+	RENOIR_COMMAND_KIND_DRAW_BATCH,
 	RENOIR_COMMAND_KIND_DISPATCH,
+	RENOIR_COMMAND_KIND_DISPATCH_INDIRECT,
 	RENOIR_COMMAND_KIND_TIMER_BEGIN,
 	RENOIR_COMMAND_KIND_TIMER_END,
+	RENOIR_COMMAND_KIND_FENCE_INSERT,
+	RENOIR_COMMAND_KIND_BUNDLE_EXECUTE,
 };
 
 struct Renoir_Command
@@ -687,6 +764,29 @@ struct Renoir_Command
 			Renoir_Handle* handle;
 		} timer_elapsed;
 
+		struct
+		{
+			Renoir_Handle* handle;
+		} readback_free;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			// blocks until the copy is done instead of just checking the query
+			bool wait;
+		} readback_poll;
+
+		struct
+		{
+			Renoir_Handle* handle;
+		} fence_free;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			uint64_t timeout_in_nanos;
+		} fence_poll;
+
 		struct
 		{
 			Renoir_Handle* handle;
@@ -744,6 +844,21 @@ struct Renoir_Command
 			size_t bytes_size;
 		} buffer_read;
 
+		struct
+		{
+			Renoir_Handle* handle;
+			Renoir_Handle* buffer;
+			size_t offset;
+			size_t size;
+		} buffer_read_async;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			Renoir_Handle* texture;
+			Renoir_Texture_Read_Async_Desc desc;
+		} texture_read_async;
+
 		struct
 		{
 			Renoir_Handle* handle;
@@ -767,16 +882,55 @@ struct Renoir_Command
 			RENOIR_ACCESS gpu_access;
 		} texture_bind;
 
+		struct
+		{
+			RENOIR_SHADER shader;
+			int first_slot;
+			int count;
+			Renoir_Handle* textures[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+			Renoir_Handle* samplers[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		} textures_bind;
+
+		struct
+		{
+			RENOIR_SHADER shader;
+			int first_slot;
+			int count;
+			Renoir_Handle* handles[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		} buffers_bind;
+
 		struct
 		{
 			Renoir_Draw_Desc desc;
 		} draw;
 
+		struct
+		{
+			Renoir_Draw_Desc desc;
+			Renoir_Handle* buffer;
+			size_t offset;
+			int draws_count;
+			size_t stride;
+		} draw_indirect;
+
+		struct
+		{
+			Renoir_Draw_Desc desc;
+			Renoir_Draw_Range* ranges;
+			size_t ranges_count;
+		} draw_batch;
+
 		struct
 		{
 			int x, y, z;
 		} dispatch;
 
+		struct
+		{
+			Renoir_Handle* buffer;
+			size_t offset;
+		} dispatch_indirect;
+
 		struct
 		{
 			Renoir_Handle* handle;
@@ -786,6 +940,17 @@ struct Renoir_Command
 		{
 			Renoir_Handle* handle;
 		} timer_end;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			uint64_t generation;
+		} fence_insert;
+
+		struct
+		{
+			Renoir_Handle* handle;
+		} bundle_execute;
 	};
 };
 
@@ -822,11 +987,26 @@ struct IRenoir
 
 	// leak detection
 	mn::Map<Renoir_Handle*, Renoir_Leak_Info> alive_handles;
+
+	// event queries which are ended after each present, the oldest one is waited on before it's reused
+	// which bounds the frames that the gpu is lagging behind to settings.max_frames_in_flight
+	ID3D11Query* frame_queries[RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT];
+	uint64_t frame_index;
+	// time slot of the next present when the frame rate is capped
+	std::chrono::steady_clock::time_point frame_pace_deadline;
+	// high resolution waitable timer used to sleep until the time slot, it's null if the os doesn't support it
+	HANDLE frame_pace_timer;
 };
 
 static void
 _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command);
 
+static void
+_renoir_dx11_command_process(IRenoir* self, Renoir_Command* command);
+
+static void
+_renoir_dx11_handle_release(IRenoir* self, Renoir_Handle* h);
+
 static Renoir_Handle*
 _renoir_dx11_handle_new(IRenoir* self, RENOIR_HANDLE_KIND kind)
 {
@@ -892,6 +1072,12 @@ _renoir_dx11_command_free(T* self, Renoir_Command* command)
 {
 	switch(command->kind)
 	{
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE:
+	{
+		// release the reference which the command took on the bundle
+		_renoir_dx11_handle_release(self, command->bundle_execute.handle);
+		break;
+	}
 	case RENOIR_COMMAND_KIND_BUFFER_NEW:
 	{
 		if(command->buffer_new.owns_data)
@@ -941,6 +1127,11 @@ _renoir_dx11_command_free(T* self, Renoir_Command* command)
 		mn::free(mn::Block{(void*)command->texture_write.desc.bytes, command->texture_write.desc.bytes_size});
 		break;
 	}
+	case RENOIR_COMMAND_KIND_DRAW_BATCH:
+	{
+		mn::free(mn::Block{command->draw_batch.ranges, command->draw_batch.ranges_count * sizeof(Renoir_Draw_Range)});
+		break;
+	}
 	case RENOIR_COMMAND_KIND_NONE:
 	case RENOIR_COMMAND_KIND_INIT:
 	case RENOIR_COMMAND_KIND_SWAPCHAIN_NEW:
@@ -961,6 +1152,10 @@ _renoir_dx11_command_free(T* self, Renoir_Command* command)
 	case RENOIR_COMMAND_KIND_TIMER_NEW:
 	case RENOIR_COMMAND_KIND_TIMER_FREE:
 	case RENOIR_COMMAND_KIND_TIMER_ELAPSED:
+	case RENOIR_COMMAND_KIND_READBACK_FREE:
+	case RENOIR_COMMAND_KIND_READBACK_POLL:
+	case RENOIR_COMMAND_KIND_FENCE_FREE:
+	case RENOIR_COMMAND_KIND_FENCE_POLL:
 	case RENOIR_COMMAND_KIND_PASS_BEGIN:
 	case RENOIR_COMMAND_KIND_PASS_END:
 	case RENOIR_COMMAND_KIND_PASS_CLEAR:
@@ -970,12 +1165,19 @@ _renoir_dx11_command_free(T* self, Renoir_Command* command)
 	case RENOIR_COMMAND_KIND_SCISSOR:
 	case RENOIR_COMMAND_KIND_BUFFER_READ:
 	case RENOIR_COMMAND_KIND_TEXTURE_READ:
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC:
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC:
 	case RENOIR_COMMAND_KIND_BUFFER_BIND:
 	case RENOIR_COMMAND_KIND_TEXTURE_BIND:
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND:
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND:
 	case RENOIR_COMMAND_KIND_DRAW:
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT:
 	case RENOIR_COMMAND_KIND_DISPATCH:
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT:
 	case RENOIR_COMMAND_KIND_TIMER_BEGIN:
 	case RENOIR_COMMAND_KIND_TIMER_END:
+	case RENOIR_COMMAND_KIND_FENCE_INSERT:
 	default:
 		// do nothing
 		break;
@@ -999,6 +1201,138 @@ _renoir_dx11_command_push(T* self, Renoir_Command* command)
 	self->command_list_tail = command;
 }
 
+// pushes the command to the command list of the pass or bundle
+inline static void
+_renoir_dx11_pass_command_push(Renoir_Handle* h, Renoir_Command* command)
+{
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
+		_renoir_dx11_command_push(&h->raster_pass, command);
+	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+		_renoir_dx11_command_push(&h->compute_pass, command);
+	else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		_renoir_dx11_command_push(&h->bundle, command);
+	else
+		assert(false && "invalid pass");
+}
+
+// multi binds reference a texture and a sampler per slot
+constexpr size_t RENOIR_DX11_COMMAND_HANDLES_SIZE = 2 * RENOIR_CONSTANT_MULTI_BIND_SIZE;
+static_assert(RENOIR_DX11_COMMAND_HANDLES_SIZE >= RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE + 2, "draw handles don't fit");
+
+// handles used by the command, bundles hold a reference to them so they stay alive as long as the bundle
+inline static size_t
+_renoir_dx11_command_handles(Renoir_Command* command, Renoir_Handle** handles)
+{
+	size_t count = 0;
+	switch(command->kind)
+	{
+	case RENOIR_COMMAND_KIND_USE_PIPELINE:
+		handles[count++] = command->use_pipeline.pipeline;
+		break;
+	case RENOIR_COMMAND_KIND_USE_PROGRAM:
+		handles[count++] = command->use_program.program;
+		break;
+	case RENOIR_COMMAND_KIND_BUFFER_WRITE:
+		handles[count++] = command->buffer_write.handle;
+		break;
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC:
+		handles[count++] = command->buffer_read_async.buffer;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC:
+		handles[count++] = command->texture_read_async.texture;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURE_WRITE:
+		handles[count++] = command->texture_write.handle;
+		break;
+	case RENOIR_COMMAND_KIND_BUFFER_BIND:
+		handles[count++] = command->buffer_bind.handle;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURE_BIND:
+		handles[count++] = command->texture_bind.handle;
+		if (command->texture_bind.sampler)
+			handles[count++] = command->texture_bind.sampler;
+		break;
+	case RENOIR_COMMAND_KIND_DRAW:
+		for (size_t i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+			if (auto h = (Renoir_Handle*)command->draw.desc.vertex_buffers[i].buffer.handle)
+				handles[count++] = h;
+		if (auto h = (Renoir_Handle*)command->draw.desc.index_buffer.handle)
+			handles[count++] = h;
+		break;
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT:
+		for (size_t i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+			if (auto h = (Renoir_Handle*)command->draw_indirect.desc.vertex_buffers[i].buffer.handle)
+				handles[count++] = h;
+		if (auto h = (Renoir_Handle*)command->draw_indirect.desc.index_buffer.handle)
+			handles[count++] = h;
+		handles[count++] = command->draw_indirect.buffer;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND:
+		for (int i = 0; i < command->textures_bind.count; ++i)
+		{
+			handles[count++] = command->textures_bind.textures[i];
+			handles[count++] = command->textures_bind.samplers[i];
+		}
+		break;
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND:
+		for (int i = 0; i < command->buffers_bind.count; ++i)
+			handles[count++] = command->buffers_bind.handles[i];
+		break;
+	case RENOIR_COMMAND_KIND_DRAW_BATCH:
+		for (size_t i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+			if (auto h = (Renoir_Handle*)command->draw_batch.desc.vertex_buffers[i].buffer.handle)
+				handles[count++] = h;
+		if (auto h = (Renoir_Handle*)command->draw_batch.desc.index_buffer.handle)
+			handles[count++] = h;
+		break;
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT:
+		handles[count++] = command->dispatch_indirect.buffer;
+		break;
+	default:
+		// do nothing
+		break;
+	}
+	return count;
+}
+
+// issues the free command which releases a reference to the handle, should be called while holding the mutex
+static void
+_renoir_dx11_handle_release(IRenoir* self, Renoir_Handle* h)
+{
+	Renoir_Command* command = nullptr;
+	switch(h->kind)
+	{
+	case RENOIR_HANDLE_KIND_BUFFER:
+		command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_BUFFER_FREE);
+		command->buffer_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_TEXTURE:
+		command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
+		command->texture_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_SAMPLER:
+		command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_SAMPLER_FREE);
+		command->sampler_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_PROGRAM:
+		command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PROGRAM_FREE);
+		command->program_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_PIPELINE:
+		command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PIPELINE_FREE);
+		command->pipeline_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_BUNDLE:
+		command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_FREE);
+		command->pass_free.handle = h;
+		break;
+	default:
+		assert(false && "unreachable");
+		return;
+	}
+	_renoir_dx11_command_process(self, command);
+}
+
 static void
 _renoir_dx11_command_process(IRenoir* self, Renoir_Command* command)
 {
@@ -1146,8 +1480,16 @@ _renoir_dx11_input_layout_create(IRenoir* self, Renoir_Handle* h, const Renoir_D
 		desc.Format = dx_type;
 		desc.InputSlot = i;
 		desc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
-		desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
-		desc.InstanceDataStepRate = 0;
+		if (draw.vertex_buffers[i].instance_step_rate > 0)
+		{
+			desc.InputSlotClass = D3D11_INPUT_PER_INSTANCE_DATA;
+			desc.InstanceDataStepRate = draw.vertex_buffers[i].instance_step_rate;
+		}
+		else
+		{
+			desc.InputSlotClass = D3D11_INPUT_PER_VERTEX_DATA;
+			desc.InstanceDataStepRate = 0;
+		}
 	}
 
 	res = self->device->CreateInputLayout(
@@ -1160,6 +1502,57 @@ _renoir_dx11_input_layout_create(IRenoir* self, Renoir_Handle* h, const Renoir_D
 	assert(SUCCEEDED(res));
 }
 
+// binds the input layout, topology, vertex and index buffers of the draw
+inline static void
+_renoir_dx11_draw_buffers_bind(IRenoir* self, Renoir_Draw_Desc& desc, UINT index_offset)
+{
+	auto hprogram = self->current_program;
+	if (hprogram->program.input_layout == nullptr)
+		_renoir_dx11_input_layout_create(self, hprogram, desc);
+
+	self->context->IASetInputLayout(hprogram->program.input_layout);
+	switch(desc.primitive)
+	{
+	case RENOIR_PRIMITIVE_POINTS:
+		self->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
+		break;
+	case RENOIR_PRIMITIVE_LINES:
+		self->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
+		break;
+	case RENOIR_PRIMITIVE_TRIANGLES:
+		self->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		break;
+	default:
+		assert(false && "unreachable");
+		break;
+	}
+
+	for (size_t i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+	{
+		auto& vertex_buffer = desc.vertex_buffers[i];
+		if (vertex_buffer.buffer.handle == nullptr)
+			continue;
+
+		// calculate the default stride for the vertex buffer
+		if (vertex_buffer.stride == 0)
+			vertex_buffer.stride = _renoir_type_to_size(vertex_buffer.type);
+
+		auto hbuffer = (Renoir_Handle*)vertex_buffer.buffer.handle;
+		UINT offset = vertex_buffer.offset;
+		UINT stride = vertex_buffer.stride;
+		self->context->IASetVertexBuffers(i, 1, &hbuffer->buffer.buffer, &stride, &offset);
+	}
+
+	if (desc.index_buffer.handle != nullptr)
+	{
+		if (desc.index_type == RENOIR_TYPE_NONE)
+			desc.index_type = RENOIR_TYPE_UINT16;
+
+		auto dx_type = _renoir_type_to_dx(desc.index_type);
+		auto hbuffer = (Renoir_Handle*)desc.index_buffer.handle;
+		self->context->IASetIndexBuffer(hbuffer->buffer.buffer, dx_type, index_offset);
+	}
+}
 
 static void
 _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
@@ -1402,8 +1795,12 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 
 		if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
 		{
-			for(auto it = h->raster_pass.command_list_head; it != NULL; it = it->next)
-				_renoir_dx11_command_free(self, command);
+			for(auto it = h->raster_pass.command_list_head; it != NULL;)
+			{
+				auto next = it->next;
+				_renoir_dx11_command_free(self, it);
+				it = next;
+			}
 
 			// free all the bound textures if it's a framebuffer pass
 			if (h->raster_pass.swapchain == nullptr)
@@ -1436,11 +1833,32 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		}
 		else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
 		{
-			for(auto it = h->compute_pass.command_list_head; it != NULL; it = it->next)
-				_renoir_dx11_command_free(self, command);
+			for(auto it = h->compute_pass.command_list_head; it != NULL;)
+			{
+				auto next = it->next;
+				_renoir_dx11_command_free(self, it);
+				it = next;
+			}
 
 			mn::buf_free(h->compute_pass.write_resources);
 		}
+		else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		{
+			for(auto it = h->bundle.command_list_head; it != NULL;)
+			{
+				auto next = it->next;
+				// release the handles which the bundle kept alive
+				if (h->bundle.recorded)
+				{
+					Renoir_Handle* handles[RENOIR_DX11_COMMAND_HANDLES_SIZE];
+					auto handles_count = _renoir_dx11_command_handles(it, handles);
+					for (size_t i = 0; i < handles_count; ++i)
+						_renoir_dx11_handle_release(self, handles[i]);
+				}
+				_renoir_dx11_command_free(self, it);
+				it = next;
+			}
+		}
 
 		_renoir_dx11_handle_free(self, h);
 		break;
@@ -1455,7 +1873,8 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		D3D11_BUFFER_DESC buffer_desc{};
 		buffer_desc.ByteWidth = desc.data_size;
 		buffer_desc.BindFlags = dx_buffer_type;
-		if (desc.usage == RENOIR_USAGE_STATIC)
+		// indirect buffers have an unordered access view which immutable buffers can't have
+		if (desc.usage == RENOIR_USAGE_STATIC && desc.type != RENOIR_BUFFER_INDIRECT)
 		{
 			buffer_desc.Usage = D3D11_USAGE_IMMUTABLE;
 		}
@@ -1474,6 +1893,11 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 			buffer_desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
 			buffer_desc.StructureByteStride = desc.compute_buffer_stride;
 		}
+		else if (desc.type == RENOIR_BUFFER_INDIRECT)
+		{
+			assert(desc.data_size % 4 == 0 && "indirect buffer size should be a multiple of 4");
+			buffer_desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS | D3D11_RESOURCE_MISC_BUFFER_ALLOW_RAW_VIEWS;
+		}
 
 		if (desc.data)
 		{
@@ -1504,6 +1928,24 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 			res = self->device->CreateUnorderedAccessView(h->buffer.buffer, &uav_desc, &h->buffer.uav);
 			assert(SUCCEEDED(res));
 		}
+		else if (desc.type == RENOIR_BUFFER_INDIRECT)
+		{
+			D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc{};
+			srv_desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFEREX;
+			srv_desc.Format = DXGI_FORMAT_R32_TYPELESS;
+			srv_desc.BufferEx.NumElements = buffer_desc.ByteWidth / 4;
+			srv_desc.BufferEx.Flags = D3D11_BUFFEREX_SRV_FLAG_RAW;
+			auto res = self->device->CreateShaderResourceView(h->buffer.buffer, &srv_desc, &h->buffer.srv);
+			assert(SUCCEEDED(res));
+
+			D3D11_UNORDERED_ACCESS_VIEW_DESC uav_desc{};
+			uav_desc.ViewDimension = D3D11_UAV_DIMENSION_BUFFER;
+			uav_desc.Format = DXGI_FORMAT_R32_TYPELESS;
+			uav_desc.Buffer.NumElements = buffer_desc.ByteWidth / 4;
+			uav_desc.Buffer.Flags = D3D11_BUFFER_UAV_FLAG_RAW;
+			res = self->device->CreateUnorderedAccessView(h->buffer.buffer, &uav_desc, &h->buffer.uav);
+			assert(SUCCEEDED(res));
+		}
 
 		if (desc.usage == RENOIR_USAGE_DYNAMIC && desc.access != RENOIR_ACCESS_NONE)
 		{
@@ -2136,6 +2578,100 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		}
 		break;
 	}
+	case RENOIR_COMMAND_KIND_READBACK_FREE:
+	{
+		auto h = command->readback_free.handle;
+		if (_renoir_dx11_handle_unref(h) == false)
+			break;
+		if (h->readback.rows > 0)
+			mn::free(h->readback.bytes);
+		else if (h->readback.mapped)
+			self->context->Unmap(h->readback.staging, 0);
+		if (h->readback.staging)
+			h->readback.staging->Release();
+		if (h->readback.event)
+			h->readback.event->Release();
+		_renoir_dx11_handle_free(self, h);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_FENCE_FREE:
+	{
+		auto h = command->fence_free.handle;
+		if (_renoir_dx11_handle_unref(h) == false)
+			break;
+		if (h->fence.query)
+			h->fence.query->Release();
+		_renoir_dx11_handle_free(self, h);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_FENCE_POLL:
+	{
+		auto h = command->fence_poll.handle;
+		h->fence.poll_scheduled = false;
+		// nothing was inserted yet or the last executed insert is already signaled
+		if (h->fence.query == nullptr || h->fence.signaled_generation == h->fence.query_generation)
+			break;
+
+		auto timeout_in_millis = (command->fence_poll.timeout_in_nanos + 999999) / 1000000;
+		auto deadline = mn::time_in_millis() + timeout_in_millis;
+		auto res = self->context->GetData(h->fence.query, nullptr, 0, 0);
+		while (res == S_FALSE && mn::time_in_millis() < deadline)
+		{
+			mn::thread_sleep(0);
+			res = self->context->GetData(h->fence.query, nullptr, 0, 0);
+		}
+
+		if (res == S_OK)
+			h->fence.signaled_generation = h->fence.query_generation;
+		break;
+	}
+	case RENOIR_COMMAND_KIND_READBACK_POLL:
+	{
+		auto h = command->readback_poll.handle;
+		// a blocking poll could have finished the readback before this one executed
+		if (h->readback.state == RENOIR_READBACK_STATE_READY)
+			break;
+
+		h->readback.state = RENOIR_READBACK_STATE_PENDING;
+		// the copy didn't execute yet
+		if (h->readback.event == nullptr)
+			break;
+
+		auto res = self->context->GetData(h->readback.event, nullptr, 0, 0);
+		while (res == S_FALSE && command->readback_poll.wait)
+		{
+			mn::thread_sleep(0);
+			res = self->context->GetData(h->readback.event, nullptr, 0, 0);
+		}
+
+		if (res == S_OK)
+		{
+			D3D11_MAPPED_SUBRESOURCE mapped_resource{};
+			res = self->context->Map(h->readback.staging, 0, D3D11_MAP_READ, 0, &mapped_resource);
+			assert(SUCCEEDED(res));
+			if (h->readback.rows > 0)
+			{
+				// repack the rows from the driver's row pitch into the requested one
+				h->readback.bytes = mn::alloc(h->readback.row_pitch * h->readback.rows, alignof(char));
+				for (int i = 0; i < h->readback.rows; ++i)
+				{
+					::memcpy(
+						(char*)h->readback.bytes.ptr + i * h->readback.row_pitch,
+						(char*)mapped_resource.pData + i * mapped_resource.RowPitch,
+						h->readback.row_size
+					);
+				}
+				self->context->Unmap(h->readback.staging, 0);
+				h->readback.mapped = h->readback.bytes.ptr;
+			}
+			else
+			{
+				h->readback.mapped = mapped_resource.pData;
+			}
+			h->readback.state = RENOIR_READBACK_STATE_READY;
+		}
+		break;
+	}
 	case RENOIR_COMMAND_KIND_PASS_BEGIN:
 	{
 		auto h = command->pass_begin.handle;
@@ -2613,27 +3149,110 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		self->context->Unmap(h->buffer.buffer_staging, 0);
 		break;
 	}
-	case RENOIR_COMMAND_KIND_TEXTURE_READ:
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC:
 	{
-		auto h = command->texture_read.handle;
-		auto& desc = command->texture_read.desc;
+		auto h = command->buffer_read_async.handle;
+		auto hbuffer = command->buffer_read_async.buffer;
+		assert(h->readback.staging == nullptr && "readbacks can only be executed once");
 
-		auto dx_pixel_size = _renoir_pixelformat_to_size(h->texture.desc.pixel_format);
+		D3D11_BUFFER_DESC staging_desc{};
+		staging_desc.ByteWidth = UINT(command->buffer_read_async.size);
+		staging_desc.Usage = D3D11_USAGE_STAGING;
+		staging_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		ID3D11Buffer* staging = nullptr;
+		auto res = self->device->CreateBuffer(&staging_desc, nullptr, &staging);
+		assert(SUCCEEDED(res));
+		h->readback.staging = staging;
 
-		if (h->texture.texture1d)
-		{
-			D3D11_MAPPED_SUBRESOURCE mapped_resource{};
-			auto subresource = D3D11CalcSubresource(0, 0, h->texture.desc.mipmaps);
-			self->context->Map(h->texture.texture1d_staging, subresource, D3D11_MAP_READ, 0, &mapped_resource);
-			::memcpy(
-				desc.bytes,
-				(char*)mapped_resource.pData + desc.x * dx_pixel_size,
-				desc.bytes_size
-			);
-			self->context->Unmap(h->texture.texture1d_staging, subresource);
-		}
-		else if (h->texture.texture2d)
-		{
+		D3D11_QUERY_DESC query_desc{};
+		query_desc.Query = D3D11_QUERY_EVENT;
+		res = self->device->CreateQuery(&query_desc, &h->readback.event);
+		assert(SUCCEEDED(res));
+
+		D3D11_BOX src_box{};
+		src_box.left = UINT(command->buffer_read_async.offset);
+		src_box.right = UINT(command->buffer_read_async.offset + command->buffer_read_async.size);
+		src_box.bottom = 1;
+		src_box.back = 1;
+		self->context->CopySubresourceRegion(
+			h->readback.staging,
+			0,
+			0,
+			0,
+			0,
+			hbuffer->buffer.buffer,
+			0,
+			&src_box
+		);
+		self->context->End(h->readback.event);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC:
+	{
+		auto h = command->texture_read_async.handle;
+		auto htexture = command->texture_read_async.texture;
+		auto& desc = command->texture_read_async.desc;
+		assert(h->readback.staging == nullptr && "readbacks can only be executed once");
+
+		D3D11_TEXTURE2D_DESC staging_desc{};
+		staging_desc.Width = desc.width;
+		staging_desc.Height = desc.height;
+		staging_desc.MipLevels = 1;
+		staging_desc.ArraySize = 1;
+		staging_desc.Format = _renoir_pixelformat_to_dx(htexture->texture.desc.pixel_format);
+		staging_desc.SampleDesc.Count = 1;
+		staging_desc.Usage = D3D11_USAGE_STAGING;
+		staging_desc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+		ID3D11Texture2D* staging = nullptr;
+		auto res = self->device->CreateTexture2D(&staging_desc, nullptr, &staging);
+		assert(SUCCEEDED(res));
+		h->readback.staging = staging;
+
+		D3D11_QUERY_DESC query_desc{};
+		query_desc.Query = D3D11_QUERY_EVENT;
+		res = self->device->CreateQuery(&query_desc, &h->readback.event);
+		assert(SUCCEEDED(res));
+
+		D3D11_BOX src_box{};
+		src_box.left = desc.x;
+		src_box.right = desc.x + desc.width;
+		src_box.top = desc.y;
+		src_box.bottom = desc.y + desc.height;
+		src_box.back = 1;
+		self->context->CopySubresourceRegion(
+			h->readback.staging,
+			0,
+			0,
+			0,
+			0,
+			htexture->texture.texture2d,
+			D3D11CalcSubresource(desc.level, desc.z, htexture->texture.desc.mipmaps),
+			&src_box
+		);
+		self->context->End(h->readback.event);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TEXTURE_READ:
+	{
+		auto h = command->texture_read.handle;
+		auto& desc = command->texture_read.desc;
+
+		auto dx_pixel_size = _renoir_pixelformat_to_size(h->texture.desc.pixel_format);
+
+		if (h->texture.texture1d)
+		{
+			D3D11_MAPPED_SUBRESOURCE mapped_resource{};
+			auto subresource = D3D11CalcSubresource(0, 0, h->texture.desc.mipmaps);
+			self->context->Map(h->texture.texture1d_staging, subresource, D3D11_MAP_READ, 0, &mapped_resource);
+			::memcpy(
+				desc.bytes,
+				(char*)mapped_resource.pData + desc.x * dx_pixel_size,
+				desc.bytes_size
+			);
+			self->context->Unmap(h->texture.texture1d_staging, subresource);
+		}
+		else if (h->texture.texture2d)
+		{
 			if (h->texture.desc.cube_map == false)
 				desc.z = 0;
 
@@ -2709,7 +3328,7 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 				break;
 			}
 		}
-		else if (h->buffer.type == RENOIR_BUFFER_COMPUTE)
+		else if (h->buffer.type == RENOIR_BUFFER_COMPUTE || h->buffer.type == RENOIR_BUFFER_INDIRECT)
 		{
 			if (command->buffer_bind.gpu_access == RENOIR_ACCESS_READ)
 			{
@@ -2783,61 +3402,25 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		assert(self->current_pipeline && self->current_program && "you should use a program and a pipeline before drawing");
 
 		auto& desc = command->draw.desc;
-		auto hprogram = self->current_program;
-		if (hprogram->program.input_layout == nullptr)
-			_renoir_dx11_input_layout_create(self, hprogram, desc);
-
-		self->context->IASetInputLayout(hprogram->program.input_layout);
-		switch(desc.primitive)
-		{
-		case RENOIR_PRIMITIVE_POINTS:
-			self->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_POINTLIST);
-			break;
-		case RENOIR_PRIMITIVE_LINES:
-			self->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_LINELIST);
-			break;
-		case RENOIR_PRIMITIVE_TRIANGLES:
-			self->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-			break;
-		default:
-			assert(false && "unreachable");
-			break;
-		}
-
-		for (size_t i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
-		{
-			auto& vertex_buffer = desc.vertex_buffers[i];
-			if (vertex_buffer.buffer.handle == nullptr)
-				continue;
-
-			// calculate the default stride for the vertex buffer
-			if (vertex_buffer.stride == 0)
-				vertex_buffer.stride = _renoir_type_to_size(vertex_buffer.type);
-
-			auto hbuffer = (Renoir_Handle*)vertex_buffer.buffer.handle;
-			UINT offset = vertex_buffer.offset;
-			UINT stride = vertex_buffer.stride;
-			self->context->IASetVertexBuffers(i, 1, &hbuffer->buffer.buffer, &stride, &offset);
-		}
-
+		UINT index_offset = 0;
 		if (desc.index_buffer.handle != nullptr)
 		{
 			if (desc.index_type == RENOIR_TYPE_NONE)
 				desc.index_type = RENOIR_TYPE_UINT16;
+			index_offset = UINT(desc.index_offset + desc.base_element * _renoir_type_to_size(desc.index_type));
+		}
+		_renoir_dx11_draw_buffers_bind(self, desc, index_offset);
 
-			auto dx_type = _renoir_type_to_dx(desc.index_type);
-			auto dx_type_size = _renoir_type_to_size(desc.index_type);
-			auto hbuffer = (Renoir_Handle*)desc.index_buffer.handle;
-			self->context->IASetIndexBuffer(hbuffer->buffer.buffer, dx_type, desc.base_element * dx_type_size);
-
-			if (desc.instances_count > 1)
+		if (desc.index_buffer.handle != nullptr)
+		{
+			if (desc.instances_count > 1 || desc.base_instance != 0)
 			{
 				self->context->DrawIndexedInstanced(
 					desc.elements_count,
-					desc.instances_count,
+					desc.instances_count > 1 ? desc.instances_count : 1,
 					0,
-					0,
-					0
+					desc.base_vertex,
+					desc.base_instance
 				);
 			}
 			else
@@ -2845,19 +3428,19 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 				self->context->DrawIndexed(
 					desc.elements_count,
 					0,
-					0
+					desc.base_vertex
 				);
 			}
 		}
 		else
 		{
-			if (desc.instances_count > 1)
+			if (desc.instances_count > 1 || desc.base_instance != 0)
 			{
 				self->context->DrawInstanced(
 					desc.elements_count,
-					desc.instances_count,
+					desc.instances_count > 1 ? desc.instances_count : 1,
 					desc.base_element,
-					0
+					desc.base_instance
 				);
 			}
 			else
@@ -2867,12 +3450,140 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		}
 		break;
 	}
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND:
+	{
+		auto& desc = command->textures_bind;
+		ID3D11ShaderResourceView* views[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		ID3D11SamplerState* samplers[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		for (int i = 0; i < desc.count; ++i)
+		{
+			views[i] = desc.textures[i]->texture.shader_view;
+			samplers[i] = desc.samplers[i]->sampler.sampler;
+		}
+
+		switch(desc.shader)
+		{
+		case RENOIR_SHADER_VERTEX:
+			self->context->VSSetShaderResources(desc.first_slot, desc.count, views);
+			self->context->VSSetSamplers(desc.first_slot, desc.count, samplers);
+			break;
+		case RENOIR_SHADER_PIXEL:
+			self->context->PSSetShaderResources(desc.first_slot, desc.count, views);
+			self->context->PSSetSamplers(desc.first_slot, desc.count, samplers);
+			break;
+		case RENOIR_SHADER_GEOMETRY:
+			self->context->GSSetShaderResources(desc.first_slot, desc.count, views);
+			self->context->GSSetSamplers(desc.first_slot, desc.count, samplers);
+			break;
+		case RENOIR_SHADER_COMPUTE:
+			self->context->CSSetShaderResources(desc.first_slot, desc.count, views);
+			self->context->CSSetSamplers(desc.first_slot, desc.count, samplers);
+			break;
+		default:
+			assert(false && "unreachable");
+			break;
+		}
+		break;
+	}
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND:
+	{
+		auto& desc = command->buffers_bind;
+		ID3D11Buffer* buffers[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		for (int i = 0; i < desc.count; ++i)
+			buffers[i] = desc.handles[i]->buffer.buffer;
+
+		switch(desc.shader)
+		{
+		case RENOIR_SHADER_VERTEX:
+			self->context->VSSetConstantBuffers(desc.first_slot, desc.count, buffers);
+			break;
+		case RENOIR_SHADER_PIXEL:
+			self->context->PSSetConstantBuffers(desc.first_slot, desc.count, buffers);
+			break;
+		case RENOIR_SHADER_GEOMETRY:
+			self->context->GSSetConstantBuffers(desc.first_slot, desc.count, buffers);
+			break;
+		case RENOIR_SHADER_COMPUTE:
+			self->context->CSSetConstantBuffers(desc.first_slot, desc.count, buffers);
+			break;
+		default:
+			assert(false && "unreachable");
+			break;
+		}
+		break;
+	}
+	case RENOIR_COMMAND_KIND_DRAW_BATCH:
+	{
+		assert(self->current_pipeline && self->current_program && "you should use a program and a pipeline before drawing");
+
+		// the buffers are bound once, the ranges carry their own base element and base vertex
+		auto& desc = command->draw_batch.desc;
+		_renoir_dx11_draw_buffers_bind(self, desc, UINT(desc.index_offset));
+
+		for (size_t i = 0; i < command->draw_batch.ranges_count; ++i)
+		{
+			const auto& range = command->draw_batch.ranges[i];
+			auto instances_count = range.instances_count > 1 ? range.instances_count : 1;
+			if (desc.index_buffer.handle != nullptr)
+			{
+				self->context->DrawIndexedInstanced(
+					range.elements_count,
+					instances_count,
+					range.base_element,
+					range.base_vertex,
+					range.base_instance
+				);
+			}
+			else
+			{
+				self->context->DrawInstanced(
+					range.elements_count,
+					instances_count,
+					range.base_element,
+					range.base_instance
+				);
+			}
+		}
+		break;
+	}
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT:
+	{
+		assert(self->current_pipeline && self->current_program && "you should use a program and a pipeline before drawing");
+
+		auto& desc = command->draw_indirect.desc;
+		// indirect arguments carry their own base element so the index buffer is bound from the start
+		_renoir_dx11_draw_buffers_bind(self, desc, 0);
+
+		// dx11 has no multi draw indirect so we issue one indirect draw per argument struct
+		auto hbuffer = command->draw_indirect.buffer;
+		auto offset = command->draw_indirect.offset;
+		if (desc.index_buffer.handle != nullptr)
+		{
+			auto stride = command->draw_indirect.stride != 0 ? command->draw_indirect.stride : sizeof(Renoir_Draw_Indexed_Indirect_Args);
+			for (int i = 0; i < command->draw_indirect.draws_count; ++i)
+				self->context->DrawIndexedInstancedIndirect(hbuffer->buffer.buffer, UINT(offset + i * stride));
+		}
+		else
+		{
+			auto stride = command->draw_indirect.stride != 0 ? command->draw_indirect.stride : sizeof(Renoir_Draw_Indirect_Args);
+			for (int i = 0; i < command->draw_indirect.draws_count; ++i)
+				self->context->DrawInstancedIndirect(hbuffer->buffer.buffer, UINT(offset + i * stride));
+		}
+		break;
+	}
 	case RENOIR_COMMAND_KIND_DISPATCH:
 	{
 		assert(self->current_compute && "you should use a compute before dispatching it");
 		self->context->Dispatch(command->dispatch.x, command->dispatch.y, command->dispatch.z);
 		break;
 	}
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT:
+	{
+		assert(self->current_compute && "you should use a compute before dispatching it");
+		auto hbuffer = command->dispatch_indirect.buffer;
+		self->context->DispatchIndirect(hbuffer->buffer.buffer, UINT(command->dispatch_indirect.offset));
+		break;
+	}
 	case RENOIR_COMMAND_KIND_TIMER_BEGIN:
 	{
 		auto h = command->timer_begin.handle;
@@ -2887,6 +3598,29 @@ _renoir_dx11_command_execute(IRenoir* self, Renoir_Command* command)
 		self->context->End(h->timer.frequency);
 		break;
 	}
+	case RENOIR_COMMAND_KIND_FENCE_INSERT:
+	{
+		auto h = command->fence_insert.handle;
+		if (h->fence.query == nullptr)
+		{
+			D3D11_QUERY_DESC desc{};
+			desc.Query = D3D11_QUERY_EVENT;
+			auto res = self->device->CreateQuery(&desc, &h->fence.query);
+			assert(SUCCEEDED(res));
+		}
+		// ending the event query again moves it to the new insert
+		self->context->End(h->fence.query);
+		h->fence.query_generation = command->fence_insert.generation;
+		break;
+	}
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE:
+	{
+		// replay the bundle commands, they are owned by the bundle so we don't free them here
+		auto h = command->bundle_execute.handle;
+		for (auto it = h->bundle.command_list_head; it != nullptr; it = it->next)
+			_renoir_dx11_command_execute(self, it);
+		break;
+	}
 	default:
 		assert(false && "unreachable");
 		break;
@@ -3218,6 +3952,22 @@ _renoir_dx11_handle_leak_free(IRenoir* self, Renoir_Command* command)
 				}
 			}
 		}
+		else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		{
+			for (auto it = h->bundle.command_list_head; it != nullptr; it = it->next)
+			{
+				// release the handles which the bundle kept alive
+				if (h->bundle.recorded)
+				{
+					Renoir_Handle* handles[RENOIR_DX11_COMMAND_HANDLES_SIZE];
+					auto handles_count = _renoir_dx11_command_handles(it, handles);
+					for (size_t i = 0; i < handles_count; ++i)
+						if (_renoir_dx11_handle_unref(handles[i]))
+							_renoir_dx11_handle_free(self, handles[i]);
+				}
+				_renoir_dx11_handle_leak_free(self, it);
+			}
+		}
 		_renoir_dx11_handle_free(self, h);
 		break;
 	}
@@ -3277,6 +4027,31 @@ _renoir_dx11_handle_leak_free(IRenoir* self, Renoir_Command* command)
 		_renoir_dx11_handle_free(self, h);
 		break;
 	}
+	case RENOIR_COMMAND_KIND_READBACK_FREE:
+	{
+		auto h = command->readback_free.handle;
+		if (_renoir_dx11_handle_unref(h) == false)
+			break;
+		_renoir_dx11_handle_free(self, h);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_FENCE_FREE:
+	{
+		auto h = command->fence_free.handle;
+		if (_renoir_dx11_handle_unref(h) == false)
+			break;
+		_renoir_dx11_handle_free(self, h);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE:
+	{
+		// release the reference which the command took on the bundle
+		Renoir_Command command_free{};
+		command_free.kind = RENOIR_COMMAND_KIND_PASS_FREE;
+		command_free.pass_free.handle = command->bundle_execute.handle;
+		_renoir_dx11_handle_leak_free(self, &command_free);
+		break;
+	}
 	}
 }
 
@@ -3291,6 +4066,10 @@ _renoir_dx11_init(Renoir* api, Renoir_Settings settings, void*)
 		settings.sampler_cache_size = RENOIR_CONSTANT_DEFAULT_SAMPLER_CACHE_SIZE;
 	if (settings.pipeline_cache_size <= 0)
 		settings.pipeline_cache_size = RENOIR_CONSTANT_DEFAULT_PIPELINE_CACHE_SIZE;
+	if (settings.max_frames_in_flight <= 0)
+		settings.max_frames_in_flight = RENOIR_CONSTANT_DEFAULT_MAX_FRAMES_IN_FLIGHT;
+	if (settings.max_frames_in_flight > RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT)
+		settings.max_frames_in_flight = RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT;
 
 	IDXGIFactory* factory = nullptr;
 	IDXGIAdapter* adapter = nullptr;
@@ -3355,6 +4134,8 @@ _renoir_dx11_init(Renoir* api, Renoir_Settings settings, void*)
 	self->alive_handles = mn::map_new<Renoir_Handle*, Renoir_Leak_Info>();
 	mn::buf_resize_fill(self->sampler_cache, self->settings.sampler_cache_size, nullptr);
 	mn::buf_resize_fill(self->pipeline_cache, self->settings.pipeline_cache_size, nullptr);
+	if (self->settings.max_frame_rate > 0)
+		self->frame_pace_timer = CreateWaitableTimerExW(nullptr, nullptr, RENOIR_DX11_CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
 
 	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_INIT);
 	_renoir_dx11_command_process(self, command);
@@ -3384,6 +4165,11 @@ _renoir_dx11_dispose(Renoir* api)
 			::fprintf(stderr, "renoir leak count: %zu, for callstack turn on 'RENOIR_LEAK' flag\n", self->alive_handles.count);
 	#endif
 	mn::mutex_free(self->mtx);
+	for (auto query: self->frame_queries)
+		if (query)
+			query->Release();
+	if (self->frame_pace_timer)
+		CloseHandle(self->frame_pace_timer);
 	if (self->settings.external_context == false)
 	{
 		self->factory->Release();
@@ -3495,6 +4281,73 @@ _renoir_dx11_swapchain_resize(Renoir* api, Renoir_Swapchain swapchain, int width
 	_renoir_dx11_command_process(self, command);
 }
 
+// ends the frame's event query after the present, the query slot is reused every max_frames_in_flight
+// frames so we wait for its previous frame to complete first
+static void
+_renoir_dx11_frame_end(IRenoir* self)
+{
+	auto& query = self->frame_queries[self->frame_index % self->settings.max_frames_in_flight];
+	if (query == nullptr)
+	{
+		D3D11_QUERY_DESC desc{};
+		desc.Query = D3D11_QUERY_EVENT;
+		auto res = self->device->CreateQuery(&desc, &query);
+		assert(SUCCEEDED(res));
+	}
+	else
+	{
+		while (self->context->GetData(query, nullptr, 0, 0) == S_FALSE)
+			mn::thread_sleep(0);
+	}
+	self->context->End(query);
+	self->frame_index += 1;
+}
+
+// sleeps until the time slot of the frame when the frame rate is capped, we wake up a bit early and spin
+// the rest to absorb the wake up latency of the timer
+static void
+_renoir_dx11_frame_pace(IRenoir* self)
+{
+	if (self->settings.max_frame_rate <= 0)
+		return;
+
+	using clock = std::chrono::steady_clock;
+	auto frame_time = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / self->settings.max_frame_rate));
+	auto spin_time = std::chrono::microseconds(50);
+
+	auto deadline = self->frame_pace_deadline;
+	auto now = clock::now();
+	if (now < deadline)
+	{
+		if (deadline - now > spin_time)
+		{
+			auto sleep_time = deadline - now - spin_time;
+			if (self->frame_pace_timer)
+			{
+				// negative due time is relative and it's in 100 nanoseconds units
+				LARGE_INTEGER due_time{};
+				due_time.QuadPart = -LONGLONG(std::chrono::duration_cast<std::chrono::nanoseconds>(sleep_time).count() / 100);
+				SetWaitableTimer(self->frame_pace_timer, &due_time, 0, nullptr, nullptr, FALSE);
+				WaitForSingleObject(self->frame_pace_timer, INFINITE);
+			}
+			else
+			{
+				// without the high resolution timer the sleep is as precise as the system timer resolution
+				std::this_thread::sleep_until(deadline - spin_time);
+			}
+		}
+		while (clock::now() < deadline)
+			;
+		now = deadline;
+	}
+
+	// a frame which missed its slot by more than a frame starts a new schedule instead of rushing
+	// the next frames to catch up
+	if (now - deadline > frame_time)
+		deadline = now;
+	self->frame_pace_deadline = deadline + frame_time;
+}
+
 static void
 _renoir_dx11_swapchain_present(Renoir* api, Renoir_Swapchain swapchain)
 {
@@ -3502,6 +4355,8 @@ _renoir_dx11_swapchain_present(Renoir* api, Renoir_Swapchain swapchain)
 	auto h = (Renoir_Handle*)swapchain.handle;
 	assert(h != nullptr);
 
+	_renoir_dx11_frame_pace(self);
+
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
@@ -3519,6 +4374,8 @@ _renoir_dx11_swapchain_present(Renoir* api, Renoir_Swapchain swapchain)
 		h->swapchain.swapchain->Present(1, 0);
 	else
 		h->swapchain.swapchain->Present(0, 0);
+
+	_renoir_dx11_frame_end(self);
 }
 
 static Renoir_Buffer
@@ -3879,6 +4736,19 @@ _renoir_dx11_pass_compute_new(Renoir* api)
 	return Renoir_Pass{h};
 }
 
+static Renoir_Pass
+_renoir_dx11_pass_bundle_new(Renoir* api)
+{
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	// bundles have no gpu objects so there's nothing to create on the device
+	auto h = _renoir_dx11_handle_new(self, RENOIR_HANDLE_KIND_BUNDLE);
+	return Renoir_Pass{h};
+}
+
 static void
 _renoir_dx11_pass_free(Renoir* api, Renoir_Pass pass)
 {
@@ -3926,6 +4796,13 @@ _renoir_dx11_pass_offscreen_desc(Renoir* api, Renoir_Pass pass)
 	return h->raster_pass.offscreen;
 }
 
+static void
+_renoir_dx11_pass_draw_sort(Renoir*, Renoir_Pass pass, bool)
+{
+	// draw sorting is only a performance hint, dx11 executes the draws in their submission order
+	assert(pass.handle != nullptr && ((Renoir_Handle*)pass.handle)->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+}
+
 static Renoir_Timer
 _renoir_dx11_timer_new(Renoir* api)
 {
@@ -3987,48 +4864,235 @@ _renoir_dx11_timer_elapsed(struct Renoir* api, Renoir_Timer timer, uint64_t* ela
 	return false;
 }
 
-// Graphics Commands
-static void
-_renoir_dx11_pass_begin(Renoir* api, Renoir_Pass pass)
+static bool
+_renoir_dx11_readback_poll(struct Renoir* api, Renoir_Readback readback, bool wait, const void** data)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)pass.handle;
+	auto h = (Renoir_Handle*)readback.handle;
 	assert(h != nullptr);
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
-	{
-		h->raster_pass.command_list_head = nullptr;
-		h->raster_pass.command_list_tail = nullptr;
-
-		mn::mutex_lock(self->mtx);
-		mn_defer(mn::mutex_unlock(self->mtx));
+	assert(h->kind == RENOIR_HANDLE_KIND_READBACK);
 
-		auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_BEGIN);
-		command->pass_begin.handle = h;
-		_renoir_dx11_command_push(&h->raster_pass, command);
-	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+	if (h->readback.state != RENOIR_READBACK_STATE_READY)
 	{
-		h->compute_pass.command_list_head = nullptr;
-		h->compute_pass.command_list_tail = nullptr;
+		if (wait)
+		{
+			// blocking polls are executed right away like buffer_read
+			Renoir_Command command{};
+			command.kind = RENOIR_COMMAND_KIND_READBACK_POLL;
+			command.readback_poll.handle = h;
+			command.readback_poll.wait = true;
 
-		mn::mutex_lock(self->mtx);
-		mn_defer(mn::mutex_unlock(self->mtx));
+			mn::mutex_lock(self->mtx);
+			_renoir_dx11_command_execute(self, &command);
+			mn::mutex_unlock(self->mtx);
+		}
+		else if (h->readback.state == RENOIR_READBACK_STATE_PENDING)
+		{
+			mn::mutex_lock(self->mtx);
+			auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_READBACK_POLL);
+			h->readback.state = RENOIR_READBACK_STATE_POLL_SCHEDULED;
+			mn::mutex_unlock(self->mtx);
 
-		auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_BEGIN);
-		command->pass_begin.handle = h;
-		_renoir_dx11_command_push(&h->compute_pass, command);
+			command->readback_poll.handle = h;
+			_renoir_dx11_command_process(self, command);
+		}
 	}
-	else
+
+	if (h->readback.state == RENOIR_READBACK_STATE_READY)
 	{
-		assert(false && "invalid pass");
+		if (data) *data = h->readback.mapped;
+		return true;
 	}
+
+	return false;
 }
 
 static void
-_renoir_dx11_pass_end(Renoir* api, Renoir_Pass pass)
+_renoir_dx11_readback_free(struct Renoir* api, Renoir_Readback readback)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)pass.handle;
+	auto h = (Renoir_Handle*)readback.handle;
+	assert(h != nullptr);
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_READBACK_FREE);
+	mn::mutex_unlock(self->mtx);
+
+	command->readback_free.handle = h;
+	_renoir_dx11_command_process(self, command);
+}
+
+static Renoir_Fence
+_renoir_dx11_fence_new(struct Renoir* api)
+{
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	// the query is created by the first insert so there's nothing to execute here
+	auto h = _renoir_dx11_handle_new(self, RENOIR_HANDLE_KIND_FENCE);
+	return Renoir_Fence{h};
+}
+
+static void
+_renoir_dx11_fence_free(struct Renoir* api, Renoir_Fence fence)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)fence.handle;
+	assert(h != nullptr);
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_FENCE_FREE);
+	mn::mutex_unlock(self->mtx);
+
+	command->fence_free.handle = h;
+	_renoir_dx11_command_process(self, command);
+}
+
+inline static bool
+_renoir_dx11_fence_is_signaled(Renoir_Handle* h)
+{
+	return h->fence.inserted_generation > 0 && h->fence.signaled_generation == h->fence.inserted_generation;
+}
+
+static bool
+_renoir_dx11_fence_signaled(struct Renoir* api, Renoir_Fence fence)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)fence.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_FENCE);
+
+	// a fence which was never inserted isn't signaled
+	if (h->fence.inserted_generation == 0)
+		return false;
+	if (_renoir_dx11_fence_is_signaled(h))
+		return true;
+
+	// polls are scheduled like timer_elapsed, in immediate mode it executes right away
+	if (h->fence.poll_scheduled == false)
+	{
+		mn::mutex_lock(self->mtx);
+		auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_FENCE_POLL);
+		h->fence.poll_scheduled = true;
+		mn::mutex_unlock(self->mtx);
+
+		command->fence_poll.handle = h;
+		_renoir_dx11_command_process(self, command);
+	}
+
+	return _renoir_dx11_fence_is_signaled(h);
+}
+
+static bool
+_renoir_dx11_fence_wait(struct Renoir* api, Renoir_Fence fence, uint64_t timeout_in_nanos)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)fence.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_FENCE);
+
+	// a fence which was never inserted isn't signaled
+	if (h->fence.inserted_generation == 0)
+		return false;
+	if (_renoir_dx11_fence_is_signaled(h))
+		return true;
+
+	// waits are executed right away like buffer_read
+	Renoir_Command command{};
+	command.kind = RENOIR_COMMAND_KIND_FENCE_POLL;
+	command.fence_poll.handle = h;
+	command.fence_poll.timeout_in_nanos = timeout_in_nanos;
+
+	mn::mutex_lock(self->mtx);
+	_renoir_dx11_command_execute(self, &command);
+	mn::mutex_unlock(self->mtx);
+
+	return _renoir_dx11_fence_is_signaled(h);
+}
+
+// Graphics Commands
+static void
+_renoir_dx11_pass_begin(Renoir* api, Renoir_Pass pass)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
+	{
+		h->raster_pass.command_list_head = nullptr;
+		h->raster_pass.command_list_tail = nullptr;
+
+		mn::mutex_lock(self->mtx);
+		mn_defer(mn::mutex_unlock(self->mtx));
+
+		auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_BEGIN);
+		command->pass_begin.handle = h;
+		_renoir_dx11_command_push(&h->raster_pass, command);
+	}
+	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+	{
+		h->compute_pass.command_list_head = nullptr;
+		h->compute_pass.command_list_tail = nullptr;
+
+		mn::mutex_lock(self->mtx);
+		mn_defer(mn::mutex_unlock(self->mtx));
+
+		auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_BEGIN);
+		command->pass_begin.handle = h;
+		_renoir_dx11_command_push(&h->compute_pass, command);
+	}
+	else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+	{
+		// bundles have no begin command, they are spliced into the pass which executes them
+		assert(h->bundle.recorded == false && "bundles can only be recorded once");
+	}
+	else
+	{
+		assert(false && "invalid pass");
+	}
+}
+
+// submits the recorded commands of the pass, should be called while holding the mutex
+static void
+_renoir_dx11_pass_submit_commands(IRenoir* self, Renoir_Command*& head, Renoir_Command*& tail)
+{
+	if (head == nullptr)
+		return;
+
+	// push the commands to the end of command list, if the user requested to defer api calls
+	if (self->settings.defer_api_calls)
+	{
+		if (self->command_list_tail == nullptr)
+		{
+			self->command_list_head = head;
+			self->command_list_tail = tail;
+		}
+		else
+		{
+			self->command_list_tail->next = head;
+			self->command_list_tail = tail;
+		}
+	}
+	// other than this just process the command
+	else
+	{
+		for(auto it = head; it != nullptr; it = it->next)
+		{
+			_renoir_dx11_command_execute(self, it);
+			_renoir_dx11_command_free(self, it);
+		}
+	}
+	head = nullptr;
+	tail = nullptr;
+}
+
+static void
+_renoir_dx11_pass_record_end(Renoir* api, Renoir_Pass pass)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
 	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
@@ -4036,78 +5100,40 @@ _renoir_dx11_pass_end(Renoir* api, Renoir_Pass pass)
 		if (h->raster_pass.command_list_head != nullptr)
 		{
 			mn::mutex_lock(self->mtx);
+			mn_defer(mn::mutex_unlock(self->mtx));
 
 			// push the pass end command
 			auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_END);
 			command->pass_end.handle = h;
 			_renoir_dx11_command_push(&h->raster_pass, command);
-
-			// push the commands to the end of command list, if the user requested to defer api calls
-			if (self->settings.defer_api_calls)
-			{
-				if (self->command_list_tail == nullptr)
-				{
-					self->command_list_head = h->raster_pass.command_list_head;
-					self->command_list_tail = h->raster_pass.command_list_tail;
-				}
-				else
-				{
-					self->command_list_tail->next = h->raster_pass.command_list_head;
-					self->command_list_tail = h->raster_pass.command_list_tail;
-				}
-			}
-			// other than this just process the command
-			else
-			{
-				for(auto it = h->raster_pass.command_list_head; it != nullptr; it = it->next)
-				{
-					_renoir_dx11_command_execute(self, it);
-					_renoir_dx11_command_free(self, it);
-				}
-			}
-			mn::mutex_unlock(self->mtx);
 		}
-		h->raster_pass.command_list_head = nullptr;
-		h->raster_pass.command_list_tail = nullptr;
 	}
 	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
 	{
 		if (h->compute_pass.command_list_head != nullptr)
 		{
 			mn::mutex_lock(self->mtx);
+			mn_defer(mn::mutex_unlock(self->mtx));
 
 			// push the pass end command
 			auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_PASS_END);
 			command->pass_end.handle = h;
 			_renoir_dx11_command_push(&h->compute_pass, command);
+		}
+	}
+	else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+	{
+		assert(h->bundle.recorded == false && "bundles can only be recorded once");
 
-			// push the commands to the end of command list, if the user requested to defer api calls
-			if (self->settings.defer_api_calls)
-			{
-				if (self->command_list_tail == nullptr)
-				{
-					self->command_list_head = h->compute_pass.command_list_head;
-					self->command_list_tail = h->compute_pass.command_list_tail;
-				}
-				else
-				{
-					self->command_list_tail->next = h->compute_pass.command_list_head;
-					self->command_list_tail = h->compute_pass.command_list_tail;
-				}
-			}
-			// other than this just process the command
-			else
-			{
-				for(auto it = h->compute_pass.command_list_head; it != nullptr; it = it->next)
-				{
-					_renoir_dx11_command_execute(self, it);
-					_renoir_dx11_command_free(self, it);
-				}
-			}
-			mn::mutex_unlock(self->mtx);
+		// hold a reference to all the used handles so that the bundle can be replayed after the user frees them
+		for (auto it = h->bundle.command_list_head; it != nullptr; it = it->next)
+		{
+			Renoir_Handle* handles[RENOIR_DX11_COMMAND_HANDLES_SIZE];
+			auto handles_count = _renoir_dx11_command_handles(it, handles);
+			for (size_t i = 0; i < handles_count; ++i)
+				_renoir_dx11_handle_ref(handles[i]);
 		}
-		h->compute_pass.command_list_head = nullptr;
-		h->compute_pass.command_list_tail = nullptr;
+		h->bundle.recorded = true;
 	}
 	else
 	{
@@ -4115,6 +5141,38 @@ _renoir_dx11_pass_end(Renoir* api, Renoir_Pass pass)
 	}
 }
 
+static void
+_renoir_dx11_pass_submit(Renoir* api, Renoir_Pass* passes, size_t passes_count)
+{
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	// passes are submitted in the given order regardless of the order in which they finished recording
+	for (size_t i = 0; i < passes_count; ++i)
+	{
+		auto h = (Renoir_Handle*)passes[i].handle;
+		assert(h != nullptr);
+
+		if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
+			_renoir_dx11_pass_submit_commands(self, h->raster_pass.command_list_head, h->raster_pass.command_list_tail);
+		else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+			_renoir_dx11_pass_submit_commands(self, h->compute_pass.command_list_head, h->compute_pass.command_list_tail);
+		else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+			continue; // bundles are only executed through bundle_execute
+		else
+			assert(false && "invalid pass");
+	}
+}
+
+static void
+_renoir_dx11_pass_end(Renoir* api, Renoir_Pass pass)
+{
+	_renoir_dx11_pass_record_end(api, pass);
+	_renoir_dx11_pass_submit(api, &pass, 1);
+}
+
 static void
 _renoir_dx11_clear(Renoir* api, Renoir_Pass pass, Renoir_Clear_Desc desc)
 {
@@ -4122,7 +5180,7 @@ _renoir_dx11_clear(Renoir* api, Renoir_Pass pass, Renoir_Clear_Desc desc)
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
 	if (desc.independent_clear_color == RENOIR_SWITCH_DEFAULT)
 		desc.independent_clear_color = RENOIR_SWITCH_DISABLE;
@@ -4132,7 +5190,7 @@ _renoir_dx11_clear(Renoir* api, Renoir_Pass pass, Renoir_Clear_Desc desc)
 	mn::mutex_unlock(self->mtx);
 
 	command->pass_clear.desc = desc;
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4142,7 +5200,7 @@ _renoir_dx11_use_pipeline(Renoir* api, Renoir_Pass pass, Renoir_Pipeline_Desc pi
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 	_renoir_dx11_pipeline_desc_defaults(&pipeline_desc);
 
 	mn::mutex_lock(self->mtx);
@@ -4151,7 +5209,7 @@ _renoir_dx11_use_pipeline(Renoir* api, Renoir_Pass pass, Renoir_Pipeline_Desc pi
 	mn::mutex_unlock(self->mtx);
 
 	command->use_pipeline.pipeline = pipeline;
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4161,14 +5219,14 @@ _renoir_dx11_use_program(Renoir* api, Renoir_Pass pass, Renoir_Program program)
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
 	mn::mutex_lock(self->mtx);
 	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_USE_PROGRAM);
 	mn::mutex_unlock(self->mtx);
 
 	command->use_program.program = (Renoir_Handle*)program.handle;
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4195,7 +5253,7 @@ _renoir_dx11_scissor(Renoir* api, Renoir_Pass pass, int x, int y, int width, int
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
 	mn::mutex_lock(self->mtx);
 	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_SCISSOR);
@@ -4205,7 +5263,30 @@ _renoir_dx11_scissor(Renoir* api, Renoir_Pass pass, int x, int y, int width, int
 	command->scissor.y = y;
 	command->scissor.w = width;
 	command->scissor.h = height;
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_bundle_execute(Renoir* api, Renoir_Pass pass, Renoir_Pass bundle)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	auto hbundle = (Renoir_Handle*)bundle.handle;
+	assert(hbundle != nullptr);
+	assert(hbundle->kind == RENOIR_HANDLE_KIND_BUNDLE);
+	assert(hbundle->bundle.recorded && "bundles should be recorded before they get executed");
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_BUNDLE_EXECUTE);
+	mn::mutex_unlock(self->mtx);
+
+	// the command holds a reference to the bundle so the user can free it while it's still in flight
+	command->bundle_execute.handle = _renoir_dx11_handle_ref(hbundle);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4312,6 +5393,129 @@ _renoir_dx11_buffer_read(Renoir* api, Renoir_Buffer buffer, size_t offset, void*
 	mn::mutex_unlock(self->mtx);
 }
 
+static Renoir_Readback
+_renoir_dx11_buffer_read_async(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, size_t size)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	// bundles are replayed so they would copy into the same readback multiple times
+	assert(h->kind != RENOIR_HANDLE_KIND_BUNDLE && "readbacks can't be recorded in bundles");
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr);
+	assert(size > 0 && offset + size <= hbuffer->buffer.size);
+
+	mn::mutex_lock(self->mtx);
+	auto hreadback = _renoir_dx11_handle_new(self, RENOIR_HANDLE_KIND_READBACK);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC);
+	mn::mutex_unlock(self->mtx);
+
+	command->buffer_read_async.handle = hreadback;
+	command->buffer_read_async.buffer = hbuffer;
+	command->buffer_read_async.offset = offset;
+	command->buffer_read_async.size = size;
+	_renoir_dx11_pass_command_push(h, command);
+	return Renoir_Readback{hreadback};
+}
+
+static Renoir_Readback
+_renoir_dx11_texture_read_async(Renoir* api, Renoir_Pass pass, Renoir_Texture texture, Renoir_Texture_Read_Async_Desc desc)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	// bundles are replayed so they would copy into the same readback multiple times
+	assert(h->kind != RENOIR_HANDLE_KIND_BUNDLE && "readbacks can't be recorded in bundles");
+
+	auto htexture = (Renoir_Handle*)texture.handle;
+	assert(htexture != nullptr);
+	assert(htexture->texture.desc.msaa == RENOIR_MSAA_MODE_NONE && "msaa textures can't be read");
+	assert(desc.width > 0);
+
+	if (htexture->texture.desc.size.height == 0 || htexture->texture.desc.size.depth > 0)
+	{
+		mn::log_error("dx11: texture_read_async only supports 2D textures and cube maps");
+		return Renoir_Readback{};
+	}
+
+	if (desc.height == 0)
+		desc.height = 1;
+	if (htexture->texture.desc.cube_map == false)
+		desc.z = 0;
+	desc.depth = 1;
+
+	auto pixel_size = size_t(_renoir_pixelformat_to_size(htexture->texture.desc.pixel_format));
+	if (desc.row_pitch == 0)
+		desc.row_pitch = desc.width * pixel_size;
+	assert(desc.row_pitch >= desc.width * pixel_size && desc.row_pitch % pixel_size == 0 && "invalid row pitch");
+
+	mn::mutex_lock(self->mtx);
+	auto hreadback = _renoir_dx11_handle_new(self, RENOIR_HANDLE_KIND_READBACK);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC);
+	mn::mutex_unlock(self->mtx);
+
+	hreadback->readback.row_size = desc.width * pixel_size;
+	hreadback->readback.row_pitch = desc.row_pitch;
+	hreadback->readback.rows = desc.height;
+
+	command->texture_read_async.handle = hreadback;
+	command->texture_read_async.texture = htexture;
+	command->texture_read_async.desc = desc;
+	_renoir_dx11_pass_command_push(h, command);
+	return Renoir_Readback{hreadback};
+}
+
+static void*
+_renoir_dx11_buffer_map(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, size_t size, RENOIR_ACCESS access)
+{
+	auto h = (Renoir_Handle*)buffer.handle;
+	assert(h != nullptr);
+	assert(h->buffer.map_ptr == nullptr && "buffer is already mapped");
+	assert(size > 0 && offset + size <= h->buffer.size && "out of range buffer map");
+	assert((access == RENOIR_ACCESS_READ || access == RENOIR_ACCESS_WRITE) && "buffers can be mapped for either read or write");
+
+	// the memory is handed to the buffer write command on unmap, and read maps get a copy of the contents
+	h->buffer.map_offset = offset;
+	h->buffer.map_size = size;
+	h->buffer.map_access = access;
+	h->buffer.map_ptr = mn::alloc(size, alignof(char)).ptr;
+	if (access == RENOIR_ACCESS_READ)
+		_renoir_dx11_buffer_read(api, buffer, offset, h->buffer.map_ptr, size);
+	return h->buffer.map_ptr;
+}
+
+static void
+_renoir_dx11_buffer_unmap(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)buffer.handle;
+	assert(h != nullptr);
+	assert(h->buffer.map_ptr != nullptr && "buffer is not mapped");
+
+	if (h->buffer.map_access == RENOIR_ACCESS_WRITE)
+	{
+		auto hpass = (Renoir_Handle*)pass.handle;
+		assert(hpass != nullptr);
+		assert(h->buffer.usage != RENOIR_USAGE_STATIC);
+
+		mn::mutex_lock(self->mtx);
+		auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_BUFFER_WRITE);
+		mn::mutex_unlock(self->mtx);
+
+		command->buffer_write.handle = h;
+		command->buffer_write.offset = h->buffer.map_offset;
+		command->buffer_write.bytes = h->buffer.map_ptr;
+		command->buffer_write.bytes_size = h->buffer.map_size;
+		_renoir_dx11_pass_command_push(hpass, command);
+	}
+	else
+	{
+		mn::free(mn::Block{h->buffer.map_ptr, h->buffer.map_size});
+	}
+	h->buffer.map_ptr = nullptr;
+}
+
 static void
 _renoir_dx11_texture_read(Renoir* api, Renoir_Texture texture, Renoir_Texture_Edit_Desc desc)
 {
@@ -4340,6 +5544,13 @@ _renoir_dx11_texture_read(Renoir* api, Renoir_Texture texture, Renoir_Texture_Ed
 	mn::mutex_unlock(self->mtx);
 }
 
+static Renoir_Transient
+_renoir_dx11_transient_alloc(Renoir* api, RENOIR_BUFFER type, size_t size)
+{
+	mn::log_error("dx11: transient_alloc is not supported");
+	return Renoir_Transient{};
+}
+
 static void
 _renoir_dx11_buffer_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RENOIR_SHADER shader, int slot)
 {
@@ -4347,7 +5558,7 @@ _renoir_dx11_buffer_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RE
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
 	mn::mutex_lock(self->mtx);
 	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_BUFFER_BIND);
@@ -4358,7 +5569,19 @@ _renoir_dx11_buffer_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RE
 	command->buffer_bind.slot = slot;
 	command->buffer_bind.gpu_access = RENOIR_ACCESS_NONE;
 
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_buffer_bind_range(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RENOIR_SHADER shader, int slot, size_t offset, size_t size)
+{
+	// constant buffer offsets need d3d11.1, so only the ranges which start at the beginning are supported
+	if (offset != 0)
+	{
+		mn::log_error("dx11: buffer_bind_range only supports offset 0");
+		return;
+	}
+	_renoir_dx11_buffer_bind(api, pass, buffer, shader, slot);
 }
 
 static void
@@ -4381,7 +5604,7 @@ _renoir_dx11_texture_bind(Renoir* api, Renoir_Pass pass, Renoir_Texture texture,
 	command->texture_bind.slot = slot;
 	command->texture_bind.sampler = hsampler;
 
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4404,7 +5627,66 @@ _renoir_dx11_texture_sampler_bind(Renoir* api, Renoir_Pass pass, Renoir_Texture
 	command->texture_bind.slot = slot;
 	command->texture_bind.sampler = hsampler;
 
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_textures_bind(Renoir* api, Renoir_Pass pass, const Renoir_Texture* textures, const Renoir_Sampler_Desc* samplers, int textures_count, RENOIR_SHADER shader, int first_slot)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(textures_count >= 0 && textures_count <= RENOIR_CONSTANT_MULTI_BIND_SIZE);
+	if (textures_count == 0)
+		return;
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_TEXTURES_BIND);
+	for (int i = 0; i < textures_count; ++i)
+	{
+		auto htex = (Renoir_Handle*)textures[i].handle;
+		assert(htex != nullptr);
+
+		command->textures_bind.textures[i] = htex;
+		command->textures_bind.samplers[i] = _renoir_dx11_sampler_get(self, samplers ? samplers[i] : htex->texture.desc.sampler);
+	}
+	mn::mutex_unlock(self->mtx);
+
+	command->textures_bind.shader = shader;
+	command->textures_bind.first_slot = first_slot;
+	command->textures_bind.count = textures_count;
+
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_buffers_bind(Renoir* api, Renoir_Pass pass, const Renoir_Buffer* buffers, int buffers_count, RENOIR_SHADER shader, int first_slot)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+	assert(buffers_count >= 0 && buffers_count <= RENOIR_CONSTANT_MULTI_BIND_SIZE);
+	if (buffers_count == 0)
+		return;
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_BUFFERS_BIND);
+	mn::mutex_unlock(self->mtx);
+
+	command->buffers_bind.shader = shader;
+	command->buffers_bind.first_slot = first_slot;
+	command->buffers_bind.count = buffers_count;
+	for (int i = 0; i < buffers_count; ++i)
+	{
+		auto hbuffer = (Renoir_Handle*)buffers[i].handle;
+		assert(hbuffer != nullptr && hbuffer->buffer.type == RENOIR_BUFFER_UNIFORM);
+		command->buffers_bind.handles[i] = hbuffer;
+	}
+
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4429,7 +5711,7 @@ _renoir_dx11_buffer_compute_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer bu
 	command->buffer_bind.slot = slot;
 	command->buffer_bind.gpu_access = gpu_access;
 
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4456,7 +5738,7 @@ _renoir_dx11_texture_compute_bind(Renoir* api, Renoir_Pass pass, Renoir_Texture
 	command->texture_bind.slot = slot;
 	command->texture_bind.gpu_access = gpu_access;
 
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
 }
 
 static void
@@ -4466,7 +5748,7 @@ _renoir_dx11_draw(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc)
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
 	mn::mutex_lock(self->mtx);
 	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_DRAW);
@@ -4474,7 +5756,73 @@ _renoir_dx11_draw(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc)
 
 	command->draw.desc = desc;
 
-	_renoir_dx11_command_push(&h->raster_pass, command);
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_draw_batch(Renoir* api, Renoir_Pass pass, const Renoir_Draw_Desc* base, const Renoir_Draw_Range* ranges, size_t ranges_count)
+{
+	if (ranges_count == 0)
+		return;
+
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr && base != nullptr && ranges != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_DRAW_BATCH);
+	mn::mutex_unlock(self->mtx);
+
+	auto ranges_size = ranges_count * sizeof(Renoir_Draw_Range);
+	command->draw_batch.desc = *base;
+	command->draw_batch.ranges = (Renoir_Draw_Range*)mn::alloc(ranges_size, alignof(Renoir_Draw_Range)).ptr;
+	::memcpy(command->draw_batch.ranges, ranges, ranges_size);
+	command->draw_batch.ranges_count = ranges_count;
+
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_multi_draw_indirect(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, int draws_count, size_t stride)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr && hbuffer->buffer.type == RENOIR_BUFFER_INDIRECT);
+	assert(offset % 4 == 0 && stride % 4 == 0 && "indirect arguments should be 4 bytes aligned");
+	assert(draws_count >= 0);
+	assert(desc.index_offset == 0 && "indirect draws don't support index offsets");
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_DRAW_INDIRECT);
+	mn::mutex_unlock(self->mtx);
+
+	command->draw_indirect.desc = desc;
+	command->draw_indirect.buffer = hbuffer;
+	command->draw_indirect.offset = offset;
+	command->draw_indirect.draws_count = draws_count;
+	command->draw_indirect.stride = stride;
+
+	_renoir_dx11_pass_command_push(h, command);
+}
+
+static void
+_renoir_dx11_draw_indirect(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset)
+{
+	_renoir_dx11_multi_draw_indirect(api, pass, desc, buffer, offset, 1, 0);
+}
+
+static void
+_renoir_dx11_multi_draw_indirect_count(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, Renoir_Buffer count_buffer, size_t count_offset, int max_draws_count, size_t stride)
+{
+	assert(false && "multi_draw_indirect_count is not supported in dx11");
+	mn::log_error("dx11: multi_draw_indirect_count is not supported");
 }
 
 static void
@@ -4499,6 +5847,30 @@ _renoir_dx11_dispatch(Renoir* api, Renoir_Pass pass, int x, int y, int z)
 	_renoir_dx11_command_push(&h->compute_pass, command);
 }
 
+static void
+_renoir_dx11_dispatch_indirect(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset)
+{
+	assert(offset % 4 == 0 && "indirect arguments should be 4 bytes aligned");
+
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS);
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr && hbuffer->buffer.type == RENOIR_BUFFER_INDIRECT);
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_DISPATCH_INDIRECT);
+	mn::mutex_unlock(self->mtx);
+
+	command->dispatch_indirect.buffer = hbuffer;
+	command->dispatch_indirect.offset = offset;
+
+	_renoir_dx11_pass_command_push(h, command);
+}
+
 static void
 _renoir_dx11_timer_begin(struct Renoir* api, Renoir_Pass pass, Renoir_Timer timer)
 {
@@ -4566,6 +5938,27 @@ _renoir_dx11_timer_end(struct Renoir* api, Renoir_Pass pass, Renoir_Timer timer)
 	}
 }
 
+static void
+_renoir_dx11_fence_insert(struct Renoir* api, Renoir_Pass pass, Renoir_Fence fence)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	// bundles are replayed so they would insert the same generation multiple times
+	assert(h->kind != RENOIR_HANDLE_KIND_BUNDLE && "fences can't be recorded in bundles");
+
+	auto hfence = (Renoir_Handle*)fence.handle;
+	assert(hfence != nullptr && hfence->kind == RENOIR_HANDLE_KIND_FENCE);
+
+	mn::mutex_lock(self->mtx);
+	auto command = _renoir_dx11_command_new(self, RENOIR_COMMAND_KIND_FENCE_INSERT);
+	mn::mutex_unlock(self->mtx);
+
+	command->fence_insert.handle = hfence;
+	command->fence_insert.generation = ++hfence->fence.inserted_generation;
+	_renoir_dx11_pass_command_push(h, command);
+}
+
 
 inline static void
 _renoir_load_api(Renoir* api)
@@ -4603,34 +5996,61 @@ _renoir_load_api(Renoir* api)
 	api->pass_swapchain_new = _renoir_dx11_pass_swapchain_new;
 	api->pass_offscreen_new = _renoir_dx11_pass_offscreen_new;
 	api->pass_compute_new = _renoir_dx11_pass_compute_new;
+	api->pass_bundle_new = _renoir_dx11_pass_bundle_new;
 	api->pass_free = _renoir_dx11_pass_free;
 	api->pass_size = _renoir_dx11_pass_size;
 	api->pass_offscreen_desc = _renoir_dx11_pass_offscreen_desc;
+	api->pass_draw_sort = _renoir_dx11_pass_draw_sort;
 
 	api->timer_new = _renoir_dx11_timer_new;
 	api->timer_free = _renoir_dx11_timer_free;
 	api->timer_elapsed = _renoir_dx11_timer_elapsed;
 
+	api->readback_poll = _renoir_dx11_readback_poll;
+	api->readback_free = _renoir_dx11_readback_free;
+
+	api->fence_new = _renoir_dx11_fence_new;
+	api->fence_free = _renoir_dx11_fence_free;
+	api->fence_signaled = _renoir_dx11_fence_signaled;
+	api->fence_wait = _renoir_dx11_fence_wait;
+
 	api->pass_begin = _renoir_dx11_pass_begin;
 	api->pass_end = _renoir_dx11_pass_end;
+	api->pass_record_end = _renoir_dx11_pass_record_end;
+	api->pass_submit = _renoir_dx11_pass_submit;
 	api->clear = _renoir_dx11_clear;
 	api->use_pipeline = _renoir_dx11_use_pipeline;
 	api->use_program = _renoir_dx11_use_program;
 	api->use_compute = _renoir_dx11_use_compute;
 	api->scissor = _renoir_dx11_scissor;
+	api->bundle_execute = _renoir_dx11_bundle_execute;
 	api->buffer_write = _renoir_dx11_buffer_write;
 	api->texture_write = _renoir_dx11_texture_write;
 	api->buffer_read = _renoir_dx11_buffer_read;
 	api->texture_read = _renoir_dx11_texture_read;
+	api->buffer_read_async = _renoir_dx11_buffer_read_async;
+	api->texture_read_async = _renoir_dx11_texture_read_async;
+	api->buffer_map = _renoir_dx11_buffer_map;
+	api->buffer_unmap = _renoir_dx11_buffer_unmap;
+	api->transient_alloc = _renoir_dx11_transient_alloc;
 	api->buffer_bind = _renoir_dx11_buffer_bind;
+	api->buffer_bind_range = _renoir_dx11_buffer_bind_range;
 	api->texture_bind = _renoir_dx11_texture_bind;
 	api->texture_sampler_bind = _renoir_dx11_texture_sampler_bind;
+	api->textures_bind = _renoir_dx11_textures_bind;
+	api->buffers_bind = _renoir_dx11_buffers_bind;
 	api->texture_compute_bind = _renoir_dx11_texture_compute_bind;
 	api->buffer_compute_bind = _renoir_dx11_buffer_compute_bind;
 	api->draw = _renoir_dx11_draw;
+	api->draw_batch = _renoir_dx11_draw_batch;
+	api->draw_indirect = _renoir_dx11_draw_indirect;
+	api->multi_draw_indirect = _renoir_dx11_multi_draw_indirect;
+	api->multi_draw_indirect_count = _renoir_dx11_multi_draw_indirect_count;
 	api->dispatch = _renoir_dx11_dispatch;
+	api->dispatch_indirect = _renoir_dx11_dispatch_indirect;
 	api->timer_begin = _renoir_dx11_timer_begin;
 	api->timer_end = _renoir_dx11_timer_end;
+	api->fence_insert = _renoir_dx11_fence_insert;
 }
 
 Renoir*
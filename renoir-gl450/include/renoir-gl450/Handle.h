@@ -6,7 +6,28 @@
 
 #include <GL/glew.h>
 
-struct Renoir_Command;
+struct Renoir_Command_Page;
+struct Renoir_Upload_Block;
+struct Renoir_GL450_Draw_Sort;
+
+// dynamic buffers are allocated with this many copies (slices) of their data, each frame writes into
+// the next slice so that the cpu never waits for the gpu to finish reading the previous frames data
+constexpr int RENOIR_GL450_BUFFER_SLICES_COUNT = 3;
+
+// variable sized commands packed one after the other in a list of pages, it's owned by a single
+// recording thread so it doesn't need locking
+struct Renoir_Command_Stream
+{
+	Renoir_Command_Page* head;
+	Renoir_Command_Page* tail;
+	// payload of the buffer/texture writes, it's released with the stream
+	Renoir_Upload_Block* upload_head;
+	Renoir_Upload_Block* upload_tail;
+	// transient allocations of the frame, only the global stream has them, they're copied into the transient ring
+	// before the stream executes
+	Renoir_Upload_Block* transient_head;
+	Renoir_Upload_Block* transient_tail;
+};
 
 enum RENOIR_TIMER_STATE
 {
@@ -22,6 +43,16 @@ enum RENOIR_TIMER_STATE
 	RENOIR_TIMER_STATE_READY,
 };
 
+enum RENOIR_READBACK_STATE
+{
+	// readback copy has been recorded but it didn't execute yet or the gpu didn't finish it
+	RENOIR_READBACK_STATE_PENDING,
+	// readback poll has been scheduled but the actual fence polling hasn't executed yet
+	RENOIR_READBACK_STATE_POLL_SCHEDULED,
+	// readback copy is done and the data is in the staging buffer
+	RENOIR_READBACK_STATE_READY,
+};
+
 enum RENOIR_HANDLE_KIND
 {
 	RENOIR_HANDLE_KIND_NONE,
@@ -35,6 +66,9 @@ enum RENOIR_HANDLE_KIND
 	RENOIR_HANDLE_KIND_COMPUTE,
 	RENOIR_HANDLE_KIND_PIPELINE,
 	RENOIR_HANDLE_KIND_TIMER,
+	RENOIR_HANDLE_KIND_BUNDLE,
+	RENOIR_HANDLE_KIND_READBACK,
+	RENOIR_HANDLE_KIND_FENCE,
 };
 
 struct Renoir_Handle
@@ -54,20 +88,20 @@ struct Renoir_Handle
 
 		struct
 		{
-			Renoir_Command *command_list_head;
-			Renoir_Command *command_list_tail;
+			Renoir_Command_Stream command_stream;
 			// used when rendering is done on screen/window
 			Renoir_Handle* swapchain;
 			// used when rendering is done off screen
 			GLuint fb;
 			int width, height;
 			Renoir_Pass_Offscreen_Desc offscreen;
+			// scratch memory of the draw sorting, it's null when the draw sorting is disabled
+			Renoir_GL450_Draw_Sort* draw_sort;
 		} raster_pass;
 
 		struct
 		{
-			Renoir_Command *command_list_head;
-			Renoir_Command *command_list_tail;
+			Renoir_Command_Stream command_stream;
 		} compute_pass;
 
 		struct
@@ -77,6 +111,37 @@ struct Renoir_Handle
 			RENOIR_USAGE usage;
 			RENOIR_ACCESS access;
 			size_t size;
+			// renamed buffers are persistently mapped and hold RENOIR_GL450_BUFFER_SLICES_COUNT slices in their own
+			// storage, the gpu commands only use the current version of the data which is one of the slices, or a
+			// region of the rename ring if the buffer got more than one new version in the frame
+			bool renamed;
+			// the transient ring, its base moves to the region of each frame
+			bool transient;
+			// id and mapped refer to the storage of the current version
+			void* mapped;
+			// offset of the data which the gpu commands use, it's added to every offset they use
+			size_t base;
+			GLuint storage_id;
+			void* storage_mapped;
+			size_t slice_size;
+			int slice;
+			// the number of frames which should complete before the gpu stops reading each slice, 0 if it's unused
+			uint64_t slice_frames[RENOIR_GL450_BUFFER_SLICES_COUNT];
+			// frame_index + 1 of the frame which took the current slice, at most one slice is taken per frame
+			uint64_t slice_frame;
+			// gpu commands were issued with the current version so writes should create a new one
+			bool version_used;
+			// the current version lives in the rename ring
+			bool spilled;
+			// the range mapped by buffer_map, map_ptr is null if the buffer isn't mapped
+			void* map_ptr;
+			size_t map_offset;
+			size_t map_size;
+			RENOIR_ACCESS map_access;
+			Renoir_Handle* map_pass;
+			// read maps of the gl buffer itself should be unmapped, and read maps which copied the contents own the memory
+			bool map_gl;
+			bool map_owned;
 		} buffer;
 
 		struct
@@ -105,6 +170,14 @@ struct Renoir_Handle
 		struct
 		{
 			Renoir_Pipeline_Desc desc;
+			// hash of the normalized desc, it's compared first on pipeline cache lookup
+			uint64_t hash;
+			// the desc resolved to gl enums once when the pipeline is created
+			GLenum gl_cull_face;
+			GLenum gl_cull_front;
+			GLenum gl_blend_func[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE][4];
+			GLenum gl_blend_eq[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE][2];
+			int color_mask[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE];
 		} pipeline;
 
 		struct
@@ -113,5 +186,34 @@ struct Renoir_Handle
 			uint64_t elapsed_time_in_nanos;
 			RENOIR_TIMER_STATE state;
 		} timer;
+
+		struct
+		{
+			// persistently mapped staging buffer, it's taken from the staging pool when the copy executes
+			GLuint staging;
+			size_t staging_size;
+			void* mapped;
+			// signaled when the gpu finishes the copy, it's null until the copy executes
+			GLsync fence;
+			RENOIR_READBACK_STATE state;
+		} readback;
+
+		struct
+		{
+			// sync of the last executed insert, it's null once it's signaled
+			GLsync sync;
+			uint64_t sync_generation;
+			// every insert has a new generation, the fence is signaled once the gpu reaches the last inserted one
+			uint64_t inserted_generation;
+			uint64_t signaled_generation;
+			bool poll_scheduled;
+		} fence;
+
+		struct
+		{
+			Renoir_Command_Stream command_stream;
+			// bundles are recorded once, after that they hold a reference to all the handles they use
+			bool recorded;
+		} bundle;
 	};
 };
@@ -3,5 +3,39 @@
 #include "renoir-gl450/Exports.h"
 #include "renoir/Renoir.h"
 
+#include <stddef.h>
+#include <stdint.h>
+
+// statistics of the last executed frame, they are updated on each flush/swapchain_present
+struct Renoir_GL450_Frame_Stats
+{
+	// number of executed commands
+	size_t command_count;
+	// size of the executed command stream in bytes
+	size_t command_bytes;
+	// cpu time spent executing the command stream
+	uint64_t execute_time_in_nanos;
+	// bytes of buffer/texture write payload allocated from the upload arena
+	size_t upload_bytes;
+	// max upload_bytes of a single frame since init, use it to size the upload arena
+	size_t upload_bytes_high_water;
+	// bytes currently held by the upload arena including the reusable free blocks
+	size_t upload_arena_size;
+	// gl calls which were skipped because they wouldn't change the gl state
+	size_t gl_calls_skipped;
+	// gl calls which were issued because they changed the gl state
+	size_t gl_state_changes;
+	// draws which were merged into the multi draw call of a previous draw with the same vertex and index buffers
+	size_t draws_merged;
+	// use_pipeline calls which found/didn't find their pipeline in the cache, and the pipelines evicted
+	// to make room for the misses, use them to tune Renoir_Settings::pipeline_cache_size
+	size_t pipeline_cache_hits;
+	size_t pipeline_cache_misses;
+	size_t pipeline_cache_evictions;
+};
+
 extern "C" RENOIR_GL450_EXPORT Renoir*
 renoir_api();
+
+extern "C" RENOIR_GL450_EXPORT Renoir_GL450_Frame_Stats
+renoir_gl450_frame_stats(Renoir* api);
@@ -17,6 +17,10 @@
 #include <math.h>
 #include <stdio.h>
 
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
 inline static bool
 _renoir_gl450_check()
 {
@@ -242,6 +246,9 @@ _renoir_buffer_type_to_gl(RENOIR_BUFFER type)
 	case RENOIR_BUFFER_COMPUTE:
 		res = GL_SHADER_STORAGE_BUFFER;
 		break;
+	case RENOIR_BUFFER_INDIRECT:
+		res = GL_DRAW_INDIRECT_BUFFER;
+		break;
 	default:
 		assert(false && "unreachable");
 		break;
@@ -249,22 +256,16 @@ _renoir_buffer_type_to_gl(RENOIR_BUFFER type)
 	return res;
 }
 
-inline static GLenum
-_renoir_usage_to_gl(RENOIR_USAGE usage)
+// immutable storage flags of a buffer, static buffers are never written after creation so only the cpu reads
+// are allowed, and dynamic buffers can always be written by buffer_write whatever their cpu access is
+inline static GLbitfield
+_renoir_buffer_storage_flags_to_gl(RENOIR_USAGE usage, RENOIR_ACCESS access)
 {
-	GLenum res = 0;
-	switch (usage)
-	{
-	case RENOIR_USAGE_STATIC:
-		res = GL_STATIC_DRAW;
-		break;
-	case RENOIR_USAGE_DYNAMIC:
-		res = GL_DYNAMIC_DRAW;
-		break;
-	default:
-		assert(false && "unreachable");
-		break;
-	}
+	GLbitfield res = 0;
+	if (access == RENOIR_ACCESS_READ || access == RENOIR_ACCESS_READ_WRITE)
+		res |= GL_MAP_READ_BIT;
+	if (usage == RENOIR_USAGE_DYNAMIC)
+		res |= GL_DYNAMIC_STORAGE_BIT;
 	return res;
 }
 
@@ -381,6 +382,29 @@ _renoir_pixelformat_to_type_gl(RENOIR_PIXELFORMAT format)
 	return res;
 }
 
+// size of a pixel in the layout which the texture reads and writes transfer, half floats are transferred as floats
+inline static size_t
+_renoir_pixelformat_to_size(RENOIR_PIXELFORMAT format)
+{
+	switch (format)
+	{
+	case RENOIR_PIXELFORMAT_R8: return 1;
+	case RENOIR_PIXELFORMAT_R16I:
+	case RENOIR_PIXELFORMAT_D32:
+		return 2;
+	case RENOIR_PIXELFORMAT_RGBA8:
+	case RENOIR_PIXELFORMAT_R16F:
+	case RENOIR_PIXELFORMAT_R32F:
+	case RENOIR_PIXELFORMAT_D24S8:
+		return 4;
+	case RENOIR_PIXELFORMAT_R32G32F: return 8;
+	case RENOIR_PIXELFORMAT_R16G16B16A16F:
+	case RENOIR_PIXELFORMAT_R32G32B32A32F:
+		return 16;
+	default: assert(false && "unreachable"); return 0;
+	}
+}
+
 inline static GLenum
 _renoir_pixelformat_to_gl_compute(RENOIR_PIXELFORMAT format)
 {
@@ -707,6 +731,9 @@ _renoir_handle_kind_name(RENOIR_HANDLE_KIND kind)
 	case RENOIR_HANDLE_KIND_PROGRAM: return "program";
 	case RENOIR_HANDLE_KIND_COMPUTE: return "compute";
 	case RENOIR_HANDLE_KIND_PIPELINE: return "pipeline";
+	case RENOIR_HANDLE_KIND_BUNDLE: return "bundle";
+	case RENOIR_HANDLE_KIND_READBACK: return "readback";
+	case RENOIR_HANDLE_KIND_FENCE: return "fence";
 	default: assert(false && "invalid handle kind"); return "<INVALID>";
 	}
 }
@@ -724,7 +751,8 @@ _renoir_handle_kind_should_track(RENOIR_HANDLE_KIND kind)
 		// we ignore the samplers because they are cached not user created
 		// kind == RENOIR_HANDLE_KIND_SAMPLER ||
 		kind == RENOIR_HANDLE_KIND_PROGRAM ||
-		kind == RENOIR_HANDLE_KIND_COMPUTE
+		kind == RENOIR_HANDLE_KIND_COMPUTE ||
+		kind == RENOIR_HANDLE_KIND_BUNDLE
 		// we ignore the pipeline because they are cached not user created
 		// kind == RENOIR_HANDLE_KIND_PIPELINE
 	);
@@ -799,6 +827,10 @@ enum RENOIR_COMMAND_KIND
 	RENOIR_COMMAND_KIND_TIMER_NEW,
 	RENOIR_COMMAND_KIND_TIMER_FREE,
 	RENOIR_COMMAND_KIND_TIMER_ELAPSED,
+	RENOIR_COMMAND_KIND_READBACK_FREE,
+	RENOIR_COMMAND_KIND_READBACK_POLL,
+	RENOIR_COMMAND_KIND_FENCE_FREE,
+	RENOIR_COMMAND_KIND_FENCE_POLL,
 	RENOIR_COMMAND_KIND_PASS_BEGIN,
 	RENOIR_COMMAND_KIND_PASS_END,
 	RENOIR_COMMAND_KIND_PASS_CLEAR,
@@ -810,18 +842,35 @@ enum RENOIR_COMMAND_KIND
 	RENOIR_COMMAND_KIND_TEXTURE_WRITE,
 	RENOIR_COMMAND_KIND_BUFFER_READ,
 	RENOIR_COMMAND_KIND_TEXTURE_READ,
+	RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC,
+	RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC,
 	RENOIR_COMMAND_KIND_BUFFER_BIND,
 	RENOIR_COMMAND_KIND_TEXTURE_BIND,
+	RENOIR_COMMAND_KIND_TEXTURES_BIND,
+	RENOIR_COMMAND_KIND_BUFFERS_BIND,
 	RENOIR_COMMAND_KIND_DRAW,
+	RENOIR_COMMAND_KIND_DRAW_INDIRECT,
+	RENOIR_COMMAND_KIND_DRAW_BATCH,
 	RENOIR_COMMAND_KIND_DISPATCH,
+	RENOIR_COMMAND_KIND_DISPATCH_INDIRECT,
 	RENOIR_COMMAND_KIND_TIMER_BEGIN,
 	RENOIR_COMMAND_KIND_TIMER_END,
+	RENOIR_COMMAND_KIND_FENCE_INSERT,
+	RENOIR_COMMAND_KIND_BUNDLE_EXECUTE,
+};
+
+struct Renoir_GL450_Texture_Binding
+{
+	Renoir_Handle* texture;
+	Renoir_Handle* sampler;
 };
 
+// commands are packed one after the other in the command stream, each command only occupies the
+// size of its own payload which is stored in the command header
 struct Renoir_Command
 {
-	Renoir_Command *prev, *next;
 	RENOIR_COMMAND_KIND kind;
+	uint32_t size;
 	union
 	{
 		struct
@@ -933,6 +982,29 @@ struct Renoir_Command
 			Renoir_Handle* handle;
 		} timer_elapsed;
 
+		struct
+		{
+			Renoir_Handle* handle;
+		} readback_free;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			// blocks until the copy is done instead of just checking the fence
+			bool wait;
+		} readback_poll;
+
+		struct
+		{
+			Renoir_Handle* handle;
+		} fence_free;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			uint64_t timeout_in_nanos;
+		} fence_poll;
+
 		struct
 		{
 			Renoir_Handle* handle;
@@ -950,7 +1022,7 @@ struct Renoir_Command
 
 		struct
 		{
-			Renoir_Pipeline_Desc pipeline_desc;
+			Renoir_Handle* handle;
 		} use_pipeline;
 
 		struct
@@ -990,6 +1062,22 @@ struct Renoir_Command
 			size_t bytes_size;
 		} buffer_read;
 
+		struct
+		{
+			Renoir_Handle* handle;
+			Renoir_Handle* buffer;
+			size_t offset;
+			size_t size;
+		} buffer_read_async;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			Renoir_Handle* texture;
+			Renoir_Texture_Read_Async_Desc desc;
+			size_t size;
+		} texture_read_async;
+
 		struct
 		{
 			Renoir_Handle* handle;
@@ -1002,6 +1090,9 @@ struct Renoir_Command
 			RENOIR_SHADER shader;
 			int slot;
 			RENOIR_ACCESS gpu_access;
+			// the bound range, size 0 binds the whole buffer
+			size_t offset;
+			size_t size;
 		} buffer_bind;
 
 		struct
@@ -1013,16 +1104,83 @@ struct Renoir_Command
 			RENOIR_ACCESS gpu_access;
 		} texture_bind;
 
+		// the bindings are the last member, so we only encode the first count slots
+		struct
+		{
+			RENOIR_SHADER shader;
+			int first_slot;
+			int count;
+			Renoir_GL450_Texture_Binding bindings[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		} textures_bind;
+
+		// same as textures_bind
+		struct
+		{
+			RENOIR_SHADER shader;
+			int first_slot;
+			int count;
+			Renoir_Handle* handles[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		} buffers_bind;
+
+		// vertex buffers are the last member, so we only encode the first vertex_buffers_count slots
 		struct
 		{
-			Renoir_Draw_Desc desc;
+			RENOIR_PRIMITIVE primitive;
+			int base_element;
+			int elements_count;
+			int instances_count;
+			int base_vertex;
+			int base_instance;
+			Renoir_Buffer index_buffer;
+			RENOIR_TYPE index_type;
+			size_t index_offset;
+			float sort_depth;
+			bool sort_ordered;
+			int vertex_buffers_count;
+			Renoir_Vertex_Desc vertex_buffers[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
 		} draw;
 
+		// same as draw, vertex buffers are the last member
+		struct
+		{
+			Renoir_Handle* buffer;
+			size_t offset;
+			int draws_count;
+			size_t stride;
+			// optional, when it's set the draws count is read from it and draws_count is the max
+			Renoir_Handle* count_buffer;
+			size_t count_offset;
+			RENOIR_PRIMITIVE primitive;
+			Renoir_Buffer index_buffer;
+			RENOIR_TYPE index_type;
+			int vertex_buffers_count;
+			Renoir_Vertex_Desc vertex_buffers[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+		} draw_indirect;
+
+		// same as draw, the ranges live in the upload blocks of the stream
+		struct
+		{
+			Renoir_Draw_Range* ranges;
+			size_t ranges_count;
+			RENOIR_PRIMITIVE primitive;
+			Renoir_Buffer index_buffer;
+			RENOIR_TYPE index_type;
+			size_t index_offset;
+			int vertex_buffers_count;
+			Renoir_Vertex_Desc vertex_buffers[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+		} draw_batch;
+
 		struct
 		{
 			int x, y, z;
 		} dispatch;
 
+		struct
+		{
+			Renoir_Handle* buffer;
+			size_t offset;
+		} dispatch_indirect;
+
 		struct
 		{
 			Renoir_Handle* handle;
@@ -1032,9 +1190,64 @@ struct Renoir_Command
 		{
 			Renoir_Handle* handle;
 		} timer_end;
+
+		struct
+		{
+			Renoir_Handle* handle;
+			uint64_t generation;
+		} fence_insert;
+
+		struct
+		{
+			Renoir_Handle* handle;
+		} bundle_execute;
 	};
 };
 
+constexpr size_t RENOIR_GL450_COMMAND_PAGE_SIZE = 64 * 1024;
+
+// command streams are made of pages, each pass has its own pages so recording threads can allocate
+// commands without taking the global mutex, all the pages are returned in bulk after execution
+struct Renoir_Command_Page
+{
+	Renoir_Command_Page* next;
+	size_t used;
+};
+
+constexpr size_t RENOIR_GL450_UPLOAD_BLOCK_SIZE = 1024 * 1024;
+constexpr size_t RENOIR_GL450_UPLOAD_ALIGNMENT = 16;
+
+// write payloads are bump allocated from upload blocks instead of a heap allocation per write, the blocks
+// belong to the command stream and go back to the free list with it so they are reused across frames,
+// payloads bigger than the default block size get a block of their own size
+struct Renoir_Upload_Block
+{
+	Renoir_Upload_Block* next;
+	size_t capacity;
+	size_t used;
+	// offset of the block in the frame's transient region, only used by the transient blocks
+	size_t base;
+};
+
+// transient uniform data is bound with glBindBufferRange so its offsets are aligned to the largest
+// GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT that drivers report
+constexpr size_t RENOIR_GL450_TRANSIENT_ALIGNMENT = 256;
+
+// the regions of the transient ring which belong to the frames that the gpu may still read, it's one more
+// than the fenced frames since the currently executing frame has no fence yet
+constexpr size_t RENOIR_GL450_TRANSIENT_FRAMES_COUNT = RENOIR_GL450_BUFFER_SLICES_COUNT + 1;
+
+// initial size of the ring which the texture writes are staged in, it grows to fit a few frames of the largest write
+constexpr size_t RENOIR_GL450_UNPACK_RING_SIZE = 16 * 1024 * 1024;
+
+// initial size of the ring which holds the versions of the renamed buffers that are written more than once in a frame
+constexpr size_t RENOIR_GL450_RENAME_RING_SIZE = 1024 * 1024;
+
+// readback staging buffers are rounded up to this size so that they can be reused by reads of different sizes
+constexpr size_t RENOIR_GL450_STAGING_ALIGNMENT = 64 * 1024;
+// freed staging buffers which are kept for reuse, the rest are deleted
+constexpr size_t RENOIR_GL450_STAGING_POOL_SIZE = 16;
+
 struct Renoir_GL450_State
 {
 	// this is a copy from imgui
@@ -1131,34 +1344,280 @@ _renoir_gl450_state_reset(Renoir_GL450_State& state)
 		(GLsizei)state.last_scissor_box[3]);
 }
 
+constexpr int RENOIR_GL450_SHADOW_SLOTS_SIZE = 32;
+
+struct Renoir_GL450_Shadow_Blend_Func
+{
+	GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+};
+
+inline static bool
+operator==(const Renoir_GL450_Shadow_Blend_Func& a, const Renoir_GL450_Shadow_Blend_Func& b)
+{
+	return a.src_rgb == b.src_rgb && a.dst_rgb == b.dst_rgb && a.src_alpha == b.src_alpha && a.dst_alpha == b.dst_alpha;
+}
+
+struct Renoir_GL450_Shadow_Blend_Eq
+{
+	GLenum rgb, alpha;
+};
+
+inline static bool
+operator==(const Renoir_GL450_Shadow_Blend_Eq& a, const Renoir_GL450_Shadow_Blend_Eq& b)
+{
+	return a.rgb == b.rgb && a.alpha == b.alpha;
+}
+
+struct Renoir_GL450_Shadow_Rect
+{
+	GLint x, y, w, h;
+};
+
+inline static bool
+operator==(const Renoir_GL450_Shadow_Rect& a, const Renoir_GL450_Shadow_Rect& b)
+{
+	return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h;
+}
+
+// buffer range bound to a uniform/storage slot, the offset includes the buffer's base and whole buffer binds have size 0
+struct Renoir_GL450_Shadow_Buffer_Range
+{
+	GLuint id;
+	GLintptr offset;
+	GLsizeiptr size;
+};
+
+inline static bool
+operator==(const Renoir_GL450_Shadow_Buffer_Range& a, const Renoir_GL450_Shadow_Buffer_Range& b)
+{
+	return a.id == b.id && a.offset == b.offset && a.size == b.size;
+}
+
+// vertex format of a draw, vertex buffer i is fed through attribute and binding point i,
+// slots without a vertex buffer have RENOIR_TYPE_NONE, it has no padding so it's compared with memcmp
+struct Renoir_GL450_Vertex_Format
+{
+	int vertex_buffers_count;
+	RENOIR_TYPE types[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+	int instance_step_rates[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+};
+
+struct Renoir_GL450_Vertex_Bindings
+{
+	GLuint buffers[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+	GLintptr offsets[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+	GLsizei strides[RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE];
+};
+
+inline static bool
+operator==(const Renoir_GL450_Vertex_Bindings& a, const Renoir_GL450_Vertex_Bindings& b)
+{
+	return ::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// vao which is configured once for its format, the buffer bindings are vao state so they're shadowed per vao
+struct Renoir_GL450_Vertex_Array
+{
+	Renoir_GL450_Vertex_Format format;
+	GLuint vao;
+	Renoir_GL450_Vertex_Bindings bindings;
+	GLuint element_array_buffer;
+};
+
+// persistently mapped buffer which the frames allocate from, the frames which the gpu may still read own
+// the region from their start up to the ring head
+struct Renoir_GL450_Ring
+{
+	Renoir_Handle* buffer;
+	size_t head;
+	size_t frame_starts[RENOIR_GL450_TRANSIENT_FRAMES_COUNT];
+	// the current frame didn't fit in the ring, it grows at the end of the frame
+	bool overflow;
+};
+
+// persistently mapped buffer which the gpu copies the readback data into
+struct Renoir_GL450_Staging_Buffer
+{
+	GLuint id;
+	size_t size;
+	void* mapped;
+};
+
+// shadow of the gl state which the executor sets so that only the changed state reaches the driver,
+// unknown state is all 0xFF bytes so it never matches a real value, switches are -1, 0, or 1
+struct Renoir_GL450_Shadow_State
+{
+	int8_t cull;
+	GLenum cull_face;
+	GLenum front_face;
+	int8_t scissor;
+	Renoir_GL450_Shadow_Rect scissor_box;
+	int8_t depth;
+	int8_t depth_range;
+	int8_t depth_mask;
+	int8_t blend[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE];
+	Renoir_GL450_Shadow_Blend_Func blend_func[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE];
+	Renoir_GL450_Shadow_Blend_Eq blend_eq[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE];
+	int color_mask[RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE];
+
+	GLuint program;
+	GLuint vao;
+	GLuint draw_indirect_buffer;
+	GLuint parameter_buffer;
+	GLuint dispatch_indirect_buffer;
+
+	// bindings of slots beyond the shadow size are always issued
+	GLuint textures[RENOIR_GL450_SHADOW_SLOTS_SIZE];
+	GLuint samplers[RENOIR_GL450_SHADOW_SLOTS_SIZE];
+	Renoir_GL450_Shadow_Buffer_Range uniform_buffers[RENOIR_GL450_SHADOW_SLOTS_SIZE];
+	Renoir_GL450_Shadow_Buffer_Range storage_buffers[RENOIR_GL450_SHADOW_SLOTS_SIZE];
+};
+
 struct Renoir_Leak_Info
 {
 	void* callstack[20];
 	size_t callstack_size;
 };
 
+// a frame queued to the render thread
+struct Renoir_GL450_Frame
+{
+	Renoir_Command_Stream command_stream;
+	// swapchain to present after executing the commands, it's null in case of flush
+	Renoir_Handle* swapchain;
+};
+
+// a draw along with the state commands it was recorded with, the state commands are still owned by the pass stream
+struct Renoir_GL450_Draw_Packet
+{
+	uint64_t key;
+	Renoir_Command* draw;
+	Renoir_Command* program;
+	Renoir_Command* pipeline;
+	Renoir_Command* scissor;
+	// range of the packet binds in Renoir_GL450_Draw_Sort::packets_binds
+	size_t binds_offset;
+	size_t binds_count;
+};
+
+// the state bound by the commands, either while walking the recorded stream or while emitting the sorted one
+struct Renoir_GL450_Draw_State
+{
+	Renoir_Command* program;
+	Renoir_Command* pipeline;
+	Renoir_Command* scissor;
+	mn::Buf<Renoir_Command*> binds;
+};
+
+// scratch memory of the draw sorting, it's kept in the pass to be reused across frames
+struct Renoir_GL450_Draw_Sort
+{
+	mn::Buf<Renoir_GL450_Draw_Packet> packets;
+	mn::Buf<Renoir_Command*> packets_binds;
+	Renoir_GL450_Draw_State recorded;
+	Renoir_GL450_Draw_State emitted;
+	// programs and pipelines in their first use order, the index is used in the sort key
+	mn::Buf<Renoir_Handle*> programs;
+	mn::Buf<Renoir_Handle*> pipelines;
+};
+
+inline static Renoir_GL450_Draw_Sort*
+_renoir_gl450_draw_sort_new()
+{
+	auto self = mn::alloc_zerod<Renoir_GL450_Draw_Sort>();
+	self->packets = mn::buf_new<Renoir_GL450_Draw_Packet>();
+	self->packets_binds = mn::buf_new<Renoir_Command*>();
+	self->recorded.binds = mn::buf_new<Renoir_Command*>();
+	self->emitted.binds = mn::buf_new<Renoir_Command*>();
+	self->programs = mn::buf_new<Renoir_Handle*>();
+	self->pipelines = mn::buf_new<Renoir_Handle*>();
+	return self;
+}
+
+inline static void
+_renoir_gl450_draw_sort_free(Renoir_GL450_Draw_Sort* self)
+{
+	if (self == nullptr)
+		return;
+	mn::buf_free(self->packets);
+	mn::buf_free(self->packets_binds);
+	mn::buf_free(self->recorded.binds);
+	mn::buf_free(self->emitted.binds);
+	mn::buf_free(self->programs);
+	mn::buf_free(self->pipelines);
+	mn::free(self);
+}
+
+// the render thread executes commands without holding the mutex, so the few places which touch
+// shared state while executing should lock it themselves
+static thread_local bool _renoir_gl450_on_render_thread = false;
+
 struct IRenoir
 {
 	mn::Mutex mtx;
 	Renoir_GL450_Context* ctx;
 	mn::Pool handle_pool;
-	mn::Pool command_pool;
 	Renoir_Settings settings;
 
-	// global command list
-	Renoir_Command *command_list_head;
-	Renoir_Command *command_list_tail;
+	// global command stream
+	Renoir_Command_Stream command_stream;
+	// command pages which are free to be used by any stream, they have their own mutex so that
+	// pass recording doesn't contend with the main mutex
+	mn::Mutex command_page_mtx;
+	Renoir_Command_Page* command_page_free_list;
+	// upload blocks which are free to be used by any stream, they are protected by the command page mutex
+	Renoir_Upload_Block* upload_block_free_list;
+	size_t upload_arena_size;
+	size_t upload_bytes_high_water;
+	// stats of the currently executing frame, it's moved to frame_stats on flush/swapchain_present
+	Renoir_GL450_Frame_Stats frame_stats_pending;
+	Renoir_GL450_Frame_Stats frame_stats;
 
 	// command execution context
+	// the executor holds a reference to the bound pipeline, it's null when the gl state is unknown
 	Renoir_Handle* current_pipeline;
 	Renoir_Handle* current_program;
 	Renoir_Handle* current_compute;
 	Renoir_Handle* current_pass;
+	Renoir_GL450_Shadow_State shadow;
+	// consecutive draws which only differ in their elements range are merged into a single multi draw call,
+	// the batch is issued once a draw which can't be merged or any other command is executed
+	Renoir_Command* draw_batch;
+	mn::Buf<GLint> draw_batch_firsts;
+	mn::Buf<GLsizei> draw_batch_counts;
+	mn::Buf<GLint> draw_batch_base_vertices;
+	mn::Buf<const void*> draw_batch_offsets;
+	// fences of the last RENOIR_GL450_BUFFER_SLICES_COUNT executed frames, they tell when the gpu is done
+	// reading the slices of the renamed buffers, at most settings.max_frames_in_flight of them are pending
+	GLsync frame_fences[RENOIR_GL450_BUFFER_SLICES_COUNT];
+	uint64_t frame_index;
+	uint64_t frames_completed;
+	// time slot of the next present when the frame rate is capped, it's only touched by the presenting thread
+	std::chrono::steady_clock::time_point frame_pace_deadline;
+	GLint uniform_buffer_offset_alignment;
+	// transient allocations live in this ring
+	Renoir_GL450_Ring transient_ring;
+	// texture writes are staged in this ring and uploaded from it as a pixel unpack buffer
+	Renoir_GL450_Ring unpack_ring;
+	// the versions of the renamed buffers after the first one in a frame live in this ring, the buffers which
+	// have their current version in it are moved back to their own storage at the end of the frame
+	Renoir_GL450_Ring rename_ring;
+	mn::Buf<Renoir_Handle*> spilled_buffers;
+	// staging buffers of the freed readbacks, they're only touched by the executor
+	mn::Buf<Renoir_GL450_Staging_Buffer> staging_pool;
 
 	// caches
-	GLuint vao;
+	// one vao per vertex format, draws with the same format only switch their buffers
+	mn::Buf<Renoir_GL450_Vertex_Array> vertex_arrays;
+	size_t vertex_array_last;
 	GLuint msaa_resolve_fb;
 	mn::Buf<Renoir_Handle*> sampler_cache;
+	// each cached pipeline holds a reference, and each use_pipeline command holds another one
+	mn::Buf<Renoir_Handle*> pipeline_cache;
+	// pipeline cache stats recorded since the last frame, they are protected by the mutex
+	size_t pipeline_cache_hits;
+	size_t pipeline_cache_misses;
+	size_t pipeline_cache_evictions;
 
 	// opengl state used to prevent state leaks in case of external opengl context
 	bool glewInited;
@@ -1166,11 +1625,25 @@ struct IRenoir
 
 	// leak detection
 	mn::Map<Renoir_Handle*, Renoir_Leak_Info> alive_handles;
+
+	// render thread, it owns the gl context and executes the queued frames in order,
+	// the queue is a ring buffer protected by the mutex, the frame is popped after it's presented
+	mn::Thread render_thread;
+	mn::Cond_Var render_thread_cv;
+	mn::Buf<Renoir_GL450_Frame> render_thread_queue;
+	size_t render_thread_queue_head;
+	size_t render_thread_queue_count;
+	// commands which should execute synchronously on the render thread like reads
+	Renoir_Command* render_thread_sync_command;
+	bool render_thread_exit;
 };
 
 static void
 _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command);
 
+static void
+_renoir_gl450_command_process(IRenoir* self, Renoir_Command* command);
+
 static Renoir_Handle*
 _renoir_gl450_handle_new(IRenoir* self, RENOIR_HANDLE_KIND kind)
 {
@@ -1194,67 +1667,1111 @@ _renoir_gl450_handle_new(IRenoir* self, RENOIR_HANDLE_KIND kind)
 	return handle;
 }
 
-static void
-_renoir_gl450_handle_free(IRenoir* self, Renoir_Handle* h)
+// locks the mutex if we're on the render thread, otherwise the caller should be holding it already
+inline static void
+_renoir_gl450_execution_lock(IRenoir* self)
 {
-	#ifdef DEBUG
-	if (_renoir_handle_kind_should_track(h->kind))
-	{
-		auto removed = mn::map_remove(self->alive_handles, h);
-		assert(removed && "free was called with an invalid renoir handle");
-	}
-	#endif
-	mn::pool_put(self->handle_pool, h);
+	if (_renoir_gl450_on_render_thread)
+		mn::mutex_lock(self->mtx);
 }
 
-static Renoir_Handle*
-_renoir_gl450_handle_ref(Renoir_Handle* h)
+inline static void
+_renoir_gl450_execution_unlock(IRenoir* self)
 {
-	h->rc.fetch_add(1);
-	return h;
+	if (_renoir_gl450_on_render_thread)
+		mn::mutex_unlock(self->mtx);
 }
 
-static bool
-_renoir_gl450_handle_unref(Renoir_Handle* h)
+// forgets all the shadow state, should be called when the gl state could be changed outside of the executor
+inline static void
+_renoir_gl450_shadow_invalidate(IRenoir* self)
 {
-	return h->rc.fetch_sub(1) == 1;
+	::memset(&self->shadow, 0xFF, sizeof(self->shadow));
 }
 
+// updates the shadow value and returns whether the gl call should be issued, skipped calls are counted in the frame stats
 template<typename T>
-static Renoir_Command*
-_renoir_gl450_command_new(T* self, RENOIR_COMMAND_KIND kind)
+inline static bool
+_renoir_gl450_shadow_set(IRenoir* self, T& shadow, const T& value)
 {
-	auto command = (Renoir_Command*)mn::pool_get(self->command_pool);
-	memset(command, 0, sizeof(*command));
-	command->kind = kind;
-	return command;
+	if (shadow == value)
+	{
+		self->frame_stats_pending.gl_calls_skipped += 1;
+		return false;
+	}
+	shadow = value;
+	self->frame_stats_pending.gl_state_changes += 1;
+	return true;
 }
 
-template<typename T>
-static void
-_renoir_gl450_command_free(T* self, Renoir_Command* command)
+// same as _renoir_gl450_shadow_set but for the non indexed gl calls which set all the indices at once
+template<typename T, size_t N>
+inline static bool
+_renoir_gl450_shadow_set_all(IRenoir* self, T (&shadow)[N], const T& value)
 {
-	switch(command->kind)
+	bool changed = false;
+	for (auto& it: shadow)
 	{
-	case RENOIR_COMMAND_KIND_BUFFER_NEW:
+		if (it == value)
+			continue;
+		it = value;
+		changed = true;
+	}
+
+	if (changed)
+		self->frame_stats_pending.gl_state_changes += 1;
+	else
+		self->frame_stats_pending.gl_calls_skipped += 1;
+	return changed;
+}
+
+// same as _renoir_gl450_shadow_set but for the multi bind gl calls which set a range of slots at once,
+// slots beyond the shadow size are unknown so the call is issued
+template<typename T, size_t N>
+inline static bool
+_renoir_gl450_shadow_set_range(IRenoir* self, T (&shadow)[N], int first, const T* values, int count)
+{
+	bool changed = size_t(first + count) > N;
+	for (int i = 0; i < count && size_t(first + i) < N; ++i)
 	{
-		if(command->buffer_new.owns_data)
-			mn::free(mn::Block{(void*)command->buffer_new.desc.data, command->buffer_new.desc.data_size});
-		break;
+		if (shadow[first + i] == values[i])
+			continue;
+		shadow[first + i] = values[i];
+		changed = true;
 	}
-	case RENOIR_COMMAND_KIND_TEXTURE_NEW:
+
+	if (changed)
+		self->frame_stats_pending.gl_state_changes += 1;
+	else
+		self->frame_stats_pending.gl_calls_skipped += 1;
+	return changed;
+}
+
+inline static void
+_renoir_gl450_shadow_cap(IRenoir* self, GLenum cap, int8_t& shadow, bool enabled)
+{
+	if (_renoir_gl450_shadow_set(self, shadow, int8_t(enabled)) == false)
+		return;
+
+	if (enabled)
+		glEnable(cap);
+	else
+		glDisable(cap);
+}
+
+// deleted gl names can be reused by new objects so we should forget them
+template<size_t N>
+inline static void
+_renoir_gl450_shadow_forget(GLuint (&shadow)[N], GLuint id)
+{
+	for (auto& it: shadow)
+		if (it == id)
+			it = GLuint(-1);
+}
+
+template<size_t N>
+inline static void
+_renoir_gl450_shadow_forget(Renoir_GL450_Shadow_Buffer_Range (&shadow)[N], GLuint id)
+{
+	for (auto& it: shadow)
+		if (it.id == id)
+			it.id = GLuint(-1);
+}
+
+inline static void
+_renoir_gl450_shadow_forget_buffer(IRenoir* self, GLuint id)
+{
+	auto& shadow = self->shadow;
+	if (shadow.draw_indirect_buffer == id)
+		shadow.draw_indirect_buffer = GLuint(-1);
+	if (shadow.parameter_buffer == id)
+		shadow.parameter_buffer = GLuint(-1);
+	if (shadow.dispatch_indirect_buffer == id)
+		shadow.dispatch_indirect_buffer = GLuint(-1);
+	// the vaos which aren't bound keep the deleted buffer attached, so its name shouldn't match a future buffer
+	for (auto& array: self->vertex_arrays)
+	{
+		_renoir_gl450_shadow_forget(array.bindings.buffers, id);
+		if (array.element_array_buffer == id)
+			array.element_array_buffer = GLuint(-1);
+	}
+	_renoir_gl450_shadow_forget(shadow.uniform_buffers, id);
+	_renoir_gl450_shadow_forget(shadow.storage_buffers, id);
+}
+
+// waits until the gpu completes the given number of frames
+static void
+_renoir_gl450_frames_wait(IRenoir* self, uint64_t frames_count)
+{
+	while (self->frames_completed < frames_count)
 	{
-		if(command->texture_new.owns_data)
+		auto& fence = self->frame_fences[self->frames_completed % RENOIR_GL450_BUFFER_SLICES_COUNT];
+		if (fence != nullptr)
 		{
-			for (int i = 0; i < 6; ++i)
-			{
-				if (command->texture_new.desc.data[i] == nullptr)
-					continue;
-
-				mn::free(mn::Block{(void*)command->texture_new.desc.data[i], command->texture_new.desc.data_size});
-			}
+			auto res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1));
+			if (res == GL_WAIT_FAILED)
+				mn::log_error("gl450: frame fence wait failed");
+			glDeleteSync(fence);
+			fence = nullptr;
 		}
-		break;
+		self->frames_completed += 1;
+	}
+}
+
+// offset of the data which the gpu commands use within the buffer, it should be added to every offset they use
+inline static size_t
+_renoir_gl450_buffer_offset(Renoir_Handle* h)
+{
+	if (h == nullptr)
+		return 0;
+	return h->buffer.base;
+}
+
+// moves the base of the buffer, the uniform slots which have the buffer bound still point to the old base
+// so they are rebound
+static void
+_renoir_gl450_buffer_base_set(IRenoir* self, Renoir_Handle* h, size_t base)
+{
+	auto delta = GLintptr(base) - GLintptr(h->buffer.base);
+	h->buffer.base = base;
+	if (delta == 0 || h->buffer.type != RENOIR_BUFFER_UNIFORM)
+		return;
+
+	for (GLuint i = 0; i < RENOIR_GL450_SHADOW_SLOTS_SIZE; ++i)
+	{
+		auto& range = self->shadow.uniform_buffers[i];
+		if (range.id != h->buffer.id)
+			continue;
+		range.offset += delta;
+		glBindBufferRange(GL_UNIFORM_BUFFER, i, range.id, range.offset, range.size);
+	}
+}
+
+// moves the current version of a renamed buffer to base within the given storage, the uniform slots which
+// have the previous version bound are rebound to the new one, and since the following draws use them the
+// new version counts as used
+static void
+_renoir_gl450_buffer_version_set(IRenoir* self, Renoir_Handle* h, GLuint id, void* mapped, size_t base)
+{
+	auto& buffer = h->buffer;
+	auto prev_id = buffer.id;
+	auto prev_base = GLintptr(buffer.base);
+	buffer.id = id;
+	buffer.mapped = mapped;
+	buffer.base = base;
+	buffer.version_used = false;
+	if (buffer.type != RENOIR_BUFFER_UNIFORM)
+		return;
+
+	for (GLuint i = 0; i < RENOIR_GL450_SHADOW_SLOTS_SIZE; ++i)
+	{
+		auto& range = self->shadow.uniform_buffers[i];
+		// the rename ring holds the versions of many buffers so the slots are matched by their range too
+		if (range.id != prev_id || range.offset < prev_base || range.offset >= prev_base + GLintptr(buffer.size))
+			continue;
+		range.id = id;
+		range.offset += GLintptr(base) - prev_base;
+		glBindBufferRange(GL_UNIFORM_BUFFER, i, range.id, range.offset, range.size);
+		buffer.version_used = true;
+	}
+}
+
+// creates the ring buffer with the given capacity, the frames in flight keep using the old buffer until
+// the gpu is done with it, so the whole new ring is free
+static void
+_renoir_gl450_ring_resize(IRenoir* self, Renoir_GL450_Ring& ring, size_t capacity)
+{
+	auto h = ring.buffer;
+	if (h->buffer.id != 0)
+	{
+		_renoir_gl450_shadow_forget_buffer(self, h->buffer.id);
+		glDeleteBuffers(1, &h->buffer.id);
+	}
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &h->buffer.id);
+	glNamedBufferStorage(h->buffer.id, capacity, nullptr, flags);
+	h->buffer.mapped = glMapNamedBufferRange(h->buffer.id, 0, capacity, flags);
+	h->buffer.size = capacity;
+	h->buffer.base = 0;
+
+	ring.head = 0;
+	for (auto& start: ring.frame_starts)
+		start = 0;
+	assert(_renoir_gl450_check());
+}
+
+// allocates size bytes from the ring, the regions of the frames which the gpu may still read are
+// reclaimed by waiting for their fences, it returns false if the ring can't fit the size
+static bool
+_renoir_gl450_ring_alloc(IRenoir* self, Renoir_GL450_Ring& ring, size_t size, size_t alignment, size_t& offset)
+{
+	auto capacity = ring.buffer->buffer.size;
+	while (true)
+	{
+		auto head = (ring.head + alignment - 1) / alignment * alignment;
+		// the used region is [tail, head) and it wraps around the end of the ring if head < tail
+		auto tail = ring.frame_starts[self->frames_completed % RENOIR_GL450_TRANSIENT_FRAMES_COUNT];
+		if (ring.head >= tail)
+		{
+			if (head + size <= capacity)
+			{
+				offset = head;
+				ring.head = head + size;
+				return true;
+			}
+			// the head never reaches the tail so that a full ring isn't mistaken for an empty one
+			if (size < tail)
+			{
+				offset = 0;
+				ring.head = size;
+				return true;
+			}
+		}
+		else if (head + size < tail)
+		{
+			offset = head;
+			ring.head = head + size;
+			return true;
+		}
+
+		if (self->frames_completed == self->frame_index)
+			return false;
+		_renoir_gl450_frames_wait(self, self->frames_completed + 1);
+	}
+}
+
+// moves the buffer to the next slice of its own storage, at most one slice is taken per frame so the next
+// slice was retired by an earlier frame which already has its fence
+static size_t
+_renoir_gl450_buffer_slice_take(IRenoir* self, Renoir_Handle* h)
+{
+	auto& buffer = h->buffer;
+	buffer.slice = (buffer.slice + 1) % RENOIR_GL450_BUFFER_SLICES_COUNT;
+	_renoir_gl450_frames_wait(self, buffer.slice_frames[buffer.slice]);
+	buffer.slice_frames[buffer.slice] = 0;
+	buffer.slice_frame = self->frame_index + 1;
+	return buffer.slice * buffer.slice_size;
+}
+
+// the region of the frame in the rename ring is reclaimed once the gpu is done with it while the buffers may
+// keep using their last version for many frames, so the spilled versions are moved back to the buffers' own
+// storage, this takes the slice of the new frame so its later versions go to the rename ring
+static void
+_renoir_gl450_spilled_buffers_restore(IRenoir* self)
+{
+	for (auto h: self->spilled_buffers)
+	{
+		auto& buffer = h->buffer;
+		auto base = _renoir_gl450_buffer_slice_take(self, h);
+		::memcpy((char*)buffer.storage_mapped + base, (char*)buffer.mapped + buffer.base, buffer.size);
+		buffer.spilled = false;
+		_renoir_gl450_buffer_version_set(self, h, buffer.storage_id, buffer.storage_mapped, base);
+	}
+	mn::buf_clear(self->spilled_buffers);
+}
+
+// marks the end of the executed frame with a fence, we wait for the oldest frame in flight to complete
+// which bounds the frames that the gpu is lagging behind to settings.max_frames_in_flight
+static void
+_renoir_gl450_frame_end(IRenoir* self)
+{
+	uint64_t max_frames_in_flight = self->settings.max_frames_in_flight;
+	if (self->frame_index + 1 >= max_frames_in_flight)
+		_renoir_gl450_frames_wait(self, self->frame_index + 1 - max_frames_in_flight);
+	self->frame_fences[self->frame_index % RENOIR_GL450_BUFFER_SLICES_COUNT] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	self->frame_index += 1;
+
+	for (auto ring: {&self->transient_ring, &self->unpack_ring, &self->rename_ring})
+	{
+		ring->frame_starts[self->frame_index % RENOIR_GL450_TRANSIENT_FRAMES_COUNT] = ring->head;
+		if (ring->overflow)
+		{
+			ring->overflow = false;
+			_renoir_gl450_ring_resize(self, *ring, ring->buffer->buffer.size * 2);
+		}
+	}
+	_renoir_gl450_spilled_buffers_restore(self);
+}
+
+// sleeps until the time slot of the frame when the frame rate is capped, sleep_until is a high resolution
+// absolute sleep on posix, and we wake up a bit early and spin the rest to absorb the wake up latency
+static void
+_renoir_gl450_frame_pace(IRenoir* self)
+{
+	if (self->settings.max_frame_rate <= 0)
+		return;
+
+	using clock = std::chrono::steady_clock;
+	auto frame_time = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / self->settings.max_frame_rate));
+	auto spin_time = std::chrono::microseconds(50);
+
+	auto deadline = self->frame_pace_deadline;
+	auto now = clock::now();
+	if (now < deadline)
+	{
+		if (deadline - now > spin_time)
+			std::this_thread::sleep_until(deadline - spin_time);
+		while (clock::now() < deadline)
+			;
+		now = deadline;
+	}
+
+	// a frame which missed its slot by more than a frame starts a new schedule instead of rushing
+	// the next frames to catch up
+	if (now - deadline > frame_time)
+		deadline = now;
+	self->frame_pace_deadline = deadline + frame_time;
+}
+
+// copies the pixels of a texture write into the unpack ring and binds it as the pixel unpack buffer, it returns
+// the offset of the pixels which the gl upload functions take instead of a pointer
+static const void*
+_renoir_gl450_unpack_ring_stage(IRenoir* self, const void* bytes, size_t size)
+{
+	auto& ring = self->unpack_ring;
+	auto h = ring.buffer;
+
+	size_t offset = 0;
+	if (h->buffer.id == 0 || _renoir_gl450_ring_alloc(self, ring, size, RENOIR_GL450_UPLOAD_ALIGNMENT, offset) == false)
+	{
+		// no command refers to the ring by offset after it executes so unlike the transient ring it grows right away,
+		// it should fit a few frames of this size
+		auto capacity = h->buffer.id == 0 ? RENOIR_GL450_UNPACK_RING_SIZE : h->buffer.size * 2;
+		if (capacity < size * RENOIR_GL450_TRANSIENT_FRAMES_COUNT)
+			capacity = size * RENOIR_GL450_TRANSIENT_FRAMES_COUNT;
+		_renoir_gl450_ring_resize(self, ring, capacity);
+		auto res = _renoir_gl450_ring_alloc(self, ring, size, RENOIR_GL450_UPLOAD_ALIGNMENT, offset);
+		assert(res && "unpack ring should fit the write after it grows");
+	}
+
+	::memcpy((char*)h->buffer.mapped + offset, bytes, size);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, h->buffer.id);
+	return (const void*)uintptr_t(offset);
+}
+
+// takes the smallest pooled staging buffer which fits size bytes or creates a new one
+static Renoir_GL450_Staging_Buffer
+_renoir_gl450_staging_acquire(IRenoir* self, size_t size)
+{
+	size_t best = self->staging_pool.count;
+	for (size_t i = 0; i < self->staging_pool.count; ++i)
+	{
+		if (self->staging_pool[i].size < size)
+			continue;
+		if (best == self->staging_pool.count || self->staging_pool[i].size < self->staging_pool[best].size)
+			best = i;
+	}
+
+	if (best < self->staging_pool.count)
+	{
+		auto res = self->staging_pool[best];
+		mn::buf_remove(self->staging_pool, best);
+		return res;
+	}
+
+	Renoir_GL450_Staging_Buffer res{};
+	res.size = (size + RENOIR_GL450_STAGING_ALIGNMENT - 1) / RENOIR_GL450_STAGING_ALIGNMENT * RENOIR_GL450_STAGING_ALIGNMENT;
+	GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &res.id);
+	// client storage hints the driver to keep it in cpu memory since only the cpu reads it
+	glNamedBufferStorage(res.id, res.size, nullptr, flags | GL_CLIENT_STORAGE_BIT);
+	res.mapped = glMapNamedBufferRange(res.id, 0, res.size, flags);
+	return res;
+}
+
+static void
+_renoir_gl450_staging_release(IRenoir* self, Renoir_GL450_Staging_Buffer staging)
+{
+	if (self->staging_pool.count < RENOIR_GL450_STAGING_POOL_SIZE)
+	{
+		mn::buf_push(self->staging_pool, staging);
+		return;
+	}
+
+	glUnmapNamedBuffer(staging.id);
+	glDeleteBuffers(1, &staging.id);
+}
+
+// gives the readback a staging buffer of at least size bytes and returns its id
+static GLuint
+_renoir_gl450_readback_staging_acquire(IRenoir* self, Renoir_Handle* h, size_t size)
+{
+	assert(h->readback.staging == 0 && "readbacks can only be executed once");
+
+	auto staging = _renoir_gl450_staging_acquire(self, size);
+	h->readback.staging = staging.id;
+	h->readback.staging_size = staging.size;
+	h->readback.mapped = staging.mapped;
+	return staging.id;
+}
+
+// dynamic buffers which the gpu only reads are renamed on write
+inline static bool
+_renoir_gl450_buffer_renamable(const Renoir_Buffer_Desc& desc)
+{
+	return (
+		desc.usage == RENOIR_USAGE_DYNAMIC &&
+		(desc.type == RENOIR_BUFFER_VERTEX || desc.type == RENOIR_BUFFER_INDEX || desc.type == RENOIR_BUFFER_UNIFORM)
+	);
+}
+
+// allocates a version of size bytes from the rename ring, unlike the transient ring it grows right away since
+// the spilled versions are only referred to through their buffers which are moved to the new ring
+static size_t
+_renoir_gl450_rename_ring_alloc(IRenoir* self, size_t size)
+{
+	auto& ring = self->rename_ring;
+	auto h = ring.buffer;
+
+	size_t offset = 0;
+	if (h->buffer.id != 0 && _renoir_gl450_ring_alloc(self, ring, size, RENOIR_GL450_TRANSIENT_ALIGNMENT, offset))
+		return offset;
+
+	// the commands which were issued with the old storage keep it alive until the gpu is done with it
+	auto old_id = h->buffer.id;
+	auto old_mapped = h->buffer.mapped;
+	h->buffer.id = 0;
+
+	auto capacity = old_id == 0 ? RENOIR_GL450_RENAME_RING_SIZE : h->buffer.size * 2;
+	if (capacity < size * RENOIR_GL450_TRANSIENT_FRAMES_COUNT)
+		capacity = size * RENOIR_GL450_TRANSIENT_FRAMES_COUNT;
+	_renoir_gl450_ring_resize(self, ring, capacity);
+
+	for (auto spilled: self->spilled_buffers)
+	{
+		size_t base = 0;
+		auto res = _renoir_gl450_ring_alloc(self, ring, spilled->buffer.size, RENOIR_GL450_TRANSIENT_ALIGNMENT, base);
+		assert(res && "rename ring should fit the spilled buffers after it grows");
+		::memcpy((char*)h->buffer.mapped + base, (char*)old_mapped + spilled->buffer.base, spilled->buffer.size);
+		_renoir_gl450_buffer_version_set(self, spilled, h->buffer.id, h->buffer.mapped, base);
+	}
+
+	if (old_id != 0)
+	{
+		_renoir_gl450_shadow_forget_buffer(self, old_id);
+		glDeleteBuffers(1, &old_id);
+	}
+
+	auto res = _renoir_gl450_ring_alloc(self, ring, size, RENOIR_GL450_TRANSIENT_ALIGNMENT, offset);
+	assert(res && "rename ring should fit the version after it grows");
+	return offset;
+}
+
+// writes go to the current version in place until a gpu command is issued with it, then the write creates a
+// new version so the commands which were issued before it still see the old data, the first new version of
+// a frame takes the next slice of the buffer and the later ones are allocated from the rename ring
+static void
+_renoir_gl450_buffer_write_renamed(IRenoir* self, Renoir_Handle* h, size_t offset, const void* bytes, size_t bytes_size)
+{
+	auto& buffer = h->buffer;
+	if (buffer.version_used == false)
+	{
+		::memcpy((char*)buffer.mapped + buffer.base + offset, bytes, bytes_size);
+		return;
+	}
+
+	GLuint id = 0;
+	void* mapped = nullptr;
+	size_t base = 0;
+	if (buffer.slice_frame != self->frame_index + 1)
+	{
+		assert(buffer.spilled == false && "spilled buffers should be restored at the end of the frame");
+		buffer.slice_frames[buffer.slice] = self->frame_index + 1;
+		base = _renoir_gl450_buffer_slice_take(self, h);
+		id = buffer.storage_id;
+		mapped = buffer.storage_mapped;
+	}
+	else
+	{
+		base = _renoir_gl450_rename_ring_alloc(self, buffer.size);
+		id = self->rename_ring.buffer->buffer.id;
+		mapped = self->rename_ring.buffer->buffer.mapped;
+		if (buffer.spilled == false)
+		{
+			buffer.slice_frames[buffer.slice] = self->frame_index + 1;
+			buffer.spilled = true;
+			mn::buf_push(self->spilled_buffers, h);
+		}
+	}
+
+	// the new version should hold the whole buffer so we copy the parts which the write doesn't cover, the
+	// previous version is read after the allocation since a growing rename ring moves it
+	auto prev = (char*)buffer.mapped + buffer.base;
+	auto next = (char*)mapped + base;
+	::memcpy(next, prev, offset);
+	::memcpy(next + offset, bytes, bytes_size);
+	::memcpy(next + offset + bytes_size, prev + offset + bytes_size, buffer.size - offset - bytes_size);
+	_renoir_gl450_buffer_version_set(self, h, id, mapped, base);
+}
+
+static void
+_renoir_gl450_handle_free(IRenoir* self, Renoir_Handle* h)
+{
+	_renoir_gl450_execution_lock(self);
+	mn_defer(_renoir_gl450_execution_unlock(self));
+
+	#ifdef DEBUG
+	if (_renoir_handle_kind_should_track(h->kind))
+	{
+		auto removed = mn::map_remove(self->alive_handles, h);
+		assert(removed && "free was called with an invalid renoir handle");
+	}
+	#endif
+	mn::pool_put(self->handle_pool, h);
+}
+
+static Renoir_Handle*
+_renoir_gl450_handle_ref(Renoir_Handle* h)
+{
+	h->rc.fetch_add(1);
+	return h;
+}
+
+static bool
+_renoir_gl450_handle_unref(Renoir_Handle* h)
+{
+	return h->rc.fetch_sub(1) == 1;
+}
+
+// pipelines don't own any gl objects so we free them directly instead of issuing a free command
+static void
+_renoir_gl450_pipeline_release(IRenoir* self, Renoir_Handle* h)
+{
+	assert(h->kind == RENOIR_HANDLE_KIND_PIPELINE);
+	if (_renoir_gl450_handle_unref(h))
+		_renoir_gl450_handle_free(self, h);
+}
+
+inline static char*
+_renoir_gl450_command_page_data(Renoir_Command_Page* page)
+{
+	return (char*)page + sizeof(Renoir_Command_Page);
+}
+
+static Renoir_Command_Page*
+_renoir_gl450_command_page_new(IRenoir* self)
+{
+	mn::mutex_lock(self->command_page_mtx);
+	auto page = self->command_page_free_list;
+	if (page != nullptr)
+		self->command_page_free_list = page->next;
+	mn::mutex_unlock(self->command_page_mtx);
+
+	if (page == nullptr)
+		page = (Renoir_Command_Page*)mn::alloc(RENOIR_GL450_COMMAND_PAGE_SIZE, alignof(Renoir_Command_Page)).ptr;
+	page->next = nullptr;
+	page->used = 0;
+	return page;
+}
+
+inline static void
+_renoir_gl450_command_page_list_free(Renoir_Command_Page* page)
+{
+	while (page != nullptr)
+	{
+		auto next = page->next;
+		mn::free(mn::Block{page, RENOIR_GL450_COMMAND_PAGE_SIZE});
+		page = next;
+	}
+}
+
+inline static char*
+_renoir_gl450_upload_block_data(Renoir_Upload_Block* block)
+{
+	return (char*)block + sizeof(Renoir_Upload_Block);
+}
+
+static Renoir_Upload_Block*
+_renoir_gl450_upload_block_new(IRenoir* self, size_t size)
+{
+	Renoir_Upload_Block* block = nullptr;
+
+	mn::mutex_lock(self->command_page_mtx);
+	// first fit, most of the blocks have the default size so this is usually the head of the list
+	for (auto it = &self->upload_block_free_list; *it != nullptr; it = &(*it)->next)
+	{
+		if ((*it)->capacity >= size)
+		{
+			block = *it;
+			*it = block->next;
+			break;
+		}
+	}
+	auto capacity = size > RENOIR_GL450_UPLOAD_BLOCK_SIZE ? size : RENOIR_GL450_UPLOAD_BLOCK_SIZE;
+	if (block == nullptr)
+		self->upload_arena_size += capacity;
+	mn::mutex_unlock(self->command_page_mtx);
+
+	if (block == nullptr)
+	{
+		block = (Renoir_Upload_Block*)mn::alloc(sizeof(Renoir_Upload_Block) + capacity, RENOIR_GL450_UPLOAD_ALIGNMENT).ptr;
+		block->capacity = capacity;
+	}
+	block->next = nullptr;
+	block->used = 0;
+	block->base = 0;
+	return block;
+}
+
+inline static void
+_renoir_gl450_upload_block_list_free(Renoir_Upload_Block* block)
+{
+	while (block != nullptr)
+	{
+		auto next = block->next;
+		mn::free(mn::Block{block, sizeof(Renoir_Upload_Block) + block->capacity});
+		block = next;
+	}
+}
+
+// appends the pages of the src stream to the end of dst stream, the src stream is left empty
+inline static void
+_renoir_gl450_command_stream_append(Renoir_Command_Stream& dst, Renoir_Command_Stream& src)
+{
+	if (src.head != nullptr)
+	{
+		if (dst.tail == nullptr)
+			dst.head = src.head;
+		else
+			dst.tail->next = src.head;
+		dst.tail = src.tail;
+	}
+
+	if (src.upload_head != nullptr)
+	{
+		if (dst.upload_tail == nullptr)
+			dst.upload_head = src.upload_head;
+		else
+			dst.upload_tail->next = src.upload_head;
+		dst.upload_tail = src.upload_tail;
+	}
+	src = Renoir_Command_Stream{};
+}
+
+// returns all the pages and upload blocks of the stream to the free lists in one go
+inline static void
+_renoir_gl450_command_stream_release(IRenoir* self, Renoir_Command_Stream& stream)
+{
+	// transient blocks are ordinary upload blocks once the stream has executed
+	if (stream.transient_head != nullptr)
+	{
+		stream.transient_tail->next = stream.upload_head;
+		stream.upload_head = stream.transient_head;
+		if (stream.upload_tail == nullptr)
+			stream.upload_tail = stream.transient_tail;
+		stream.transient_head = nullptr;
+		stream.transient_tail = nullptr;
+	}
+
+	if (stream.head == nullptr && stream.upload_head == nullptr)
+		return;
+
+	mn::mutex_lock(self->command_page_mtx);
+	if (stream.head != nullptr)
+	{
+		stream.tail->next = self->command_page_free_list;
+		self->command_page_free_list = stream.head;
+	}
+	if (stream.upload_head != nullptr)
+	{
+		stream.upload_tail->next = self->upload_block_free_list;
+		self->upload_block_free_list = stream.upload_head;
+	}
+	mn::mutex_unlock(self->command_page_mtx);
+	stream = Renoir_Command_Stream{};
+}
+
+// allocates write payload memory which lives as long as the stream
+static void*
+_renoir_gl450_command_stream_upload_alloc(IRenoir* self, Renoir_Command_Stream& stream, size_t size)
+{
+	size = (size + RENOIR_GL450_UPLOAD_ALIGNMENT - 1) & ~(RENOIR_GL450_UPLOAD_ALIGNMENT - 1);
+
+	auto block = stream.upload_tail;
+	if (block == nullptr || block->used + size > block->capacity)
+	{
+		block = _renoir_gl450_upload_block_new(self, size);
+
+		if (stream.upload_tail == nullptr)
+			stream.upload_head = block;
+		else
+			stream.upload_tail->next = block;
+		stream.upload_tail = block;
+	}
+
+	auto ptr = _renoir_gl450_upload_block_data(block) + block->used;
+	block->used += size;
+	return ptr;
+}
+
+// allocates memory from the stream, pages have their own mutex so it never locks the main mutex
+static void*
+_renoir_gl450_command_stream_alloc(IRenoir* self, Renoir_Command_Stream& stream, size_t size)
+{
+	assert(size + sizeof(Renoir_Command_Page) <= RENOIR_GL450_COMMAND_PAGE_SIZE);
+
+	auto page = stream.tail;
+	if (page == nullptr || page->used + size + sizeof(Renoir_Command_Page) > RENOIR_GL450_COMMAND_PAGE_SIZE)
+	{
+		page = _renoir_gl450_command_page_new(self);
+
+		if (stream.tail == nullptr)
+			stream.head = page;
+		else
+			stream.tail->next = page;
+		stream.tail = page;
+	}
+
+	auto ptr = _renoir_gl450_command_page_data(page) + page->used;
+	page->used += size;
+	return ptr;
+}
+
+// gives back the memory of the last allocation in the stream
+inline static void
+_renoir_gl450_command_stream_pop(Renoir_Command_Stream& stream, void* ptr, size_t size)
+{
+	auto page = stream.tail;
+	if (page == nullptr)
+		return;
+
+	if ((char*)ptr + size == _renoir_gl450_command_page_data(page) + page->used)
+		page->used -= size;
+}
+
+// walks the commands in the stream in order, commands which are pushed to the stream while walking it
+// will be visited as well
+template<typename TFunc>
+inline static void
+_renoir_gl450_command_stream_for_each(Renoir_Command_Stream& stream, TFunc&& func)
+{
+	for (auto page = stream.head; page != nullptr; page = page->next)
+	{
+		auto data = _renoir_gl450_command_page_data(page);
+		for (size_t offset = 0; offset < page->used;)
+		{
+			auto command = (Renoir_Command*)(data + offset);
+			offset += command->size;
+			func(command);
+		}
+	}
+}
+
+inline static Renoir_Command_Stream&
+_renoir_gl450_pass_command_stream(Renoir_Handle* h)
+{
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
+		return h->raster_pass.command_stream;
+	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+		return h->compute_pass.command_stream;
+	else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		return h->bundle.command_stream;
+	assert(false && "invalid pass");
+	return h->raster_pass.command_stream;
+}
+
+#define RENOIR_GL450_COMMAND_SIZE(NAME) (offsetof(Renoir_Command, NAME) + sizeof(Renoir_Command::NAME))
+
+// size of the command in the stream, it's only the header + the payload of this command kind
+inline static size_t
+_renoir_gl450_command_size(RENOIR_COMMAND_KIND kind)
+{
+	size_t res = 0;
+	switch(kind)
+	{
+	case RENOIR_COMMAND_KIND_INIT: res = RENOIR_GL450_COMMAND_SIZE(init); break;
+	case RENOIR_COMMAND_KIND_SWAPCHAIN_NEW: res = RENOIR_GL450_COMMAND_SIZE(swapchain_new); break;
+	case RENOIR_COMMAND_KIND_SWAPCHAIN_FREE: res = RENOIR_GL450_COMMAND_SIZE(swapchain_free); break;
+	case RENOIR_COMMAND_KIND_PASS_SWAPCHAIN_NEW: res = RENOIR_GL450_COMMAND_SIZE(pass_swapchain_new); break;
+	case RENOIR_COMMAND_KIND_PASS_OFFSCREEN_NEW: res = RENOIR_GL450_COMMAND_SIZE(pass_offscreen_new); break;
+	case RENOIR_COMMAND_KIND_PASS_COMPUTE_NEW: res = RENOIR_GL450_COMMAND_SIZE(pass_compute_new); break;
+	case RENOIR_COMMAND_KIND_PASS_FREE: res = RENOIR_GL450_COMMAND_SIZE(pass_free); break;
+	case RENOIR_COMMAND_KIND_BUFFER_NEW: res = RENOIR_GL450_COMMAND_SIZE(buffer_new); break;
+	case RENOIR_COMMAND_KIND_BUFFER_FREE: res = RENOIR_GL450_COMMAND_SIZE(buffer_free); break;
+	case RENOIR_COMMAND_KIND_TEXTURE_NEW: res = RENOIR_GL450_COMMAND_SIZE(texture_new); break;
+	case RENOIR_COMMAND_KIND_TEXTURE_FREE: res = RENOIR_GL450_COMMAND_SIZE(texture_free); break;
+	case RENOIR_COMMAND_KIND_SAMPLER_NEW: res = RENOIR_GL450_COMMAND_SIZE(sampler_new); break;
+	case RENOIR_COMMAND_KIND_SAMPLER_FREE: res = RENOIR_GL450_COMMAND_SIZE(sampler_free); break;
+	case RENOIR_COMMAND_KIND_PROGRAM_NEW: res = RENOIR_GL450_COMMAND_SIZE(program_new); break;
+	case RENOIR_COMMAND_KIND_PROGRAM_FREE: res = RENOIR_GL450_COMMAND_SIZE(program_free); break;
+	case RENOIR_COMMAND_KIND_COMPUTE_NEW: res = RENOIR_GL450_COMMAND_SIZE(compute_new); break;
+	case RENOIR_COMMAND_KIND_COMPUTE_FREE: res = RENOIR_GL450_COMMAND_SIZE(compute_free); break;
+	case RENOIR_COMMAND_KIND_TIMER_NEW: res = RENOIR_GL450_COMMAND_SIZE(timer_new); break;
+	case RENOIR_COMMAND_KIND_TIMER_FREE: res = RENOIR_GL450_COMMAND_SIZE(timer_free); break;
+	case RENOIR_COMMAND_KIND_TIMER_ELAPSED: res = RENOIR_GL450_COMMAND_SIZE(timer_elapsed); break;
+	case RENOIR_COMMAND_KIND_READBACK_FREE: res = RENOIR_GL450_COMMAND_SIZE(readback_free); break;
+	case RENOIR_COMMAND_KIND_READBACK_POLL: res = RENOIR_GL450_COMMAND_SIZE(readback_poll); break;
+	case RENOIR_COMMAND_KIND_FENCE_FREE: res = RENOIR_GL450_COMMAND_SIZE(fence_free); break;
+	case RENOIR_COMMAND_KIND_FENCE_POLL: res = RENOIR_GL450_COMMAND_SIZE(fence_poll); break;
+	case RENOIR_COMMAND_KIND_PASS_BEGIN: res = RENOIR_GL450_COMMAND_SIZE(pass_begin); break;
+	case RENOIR_COMMAND_KIND_PASS_END: res = RENOIR_GL450_COMMAND_SIZE(pass_end); break;
+	case RENOIR_COMMAND_KIND_PASS_CLEAR: res = RENOIR_GL450_COMMAND_SIZE(pass_clear); break;
+	case RENOIR_COMMAND_KIND_USE_PIPELINE: res = RENOIR_GL450_COMMAND_SIZE(use_pipeline); break;
+	case RENOIR_COMMAND_KIND_USE_PROGRAM: res = RENOIR_GL450_COMMAND_SIZE(use_program); break;
+	case RENOIR_COMMAND_KIND_USE_COMPUTE: res = RENOIR_GL450_COMMAND_SIZE(use_compute); break;
+	case RENOIR_COMMAND_KIND_SCISSOR: res = RENOIR_GL450_COMMAND_SIZE(scissor); break;
+	case RENOIR_COMMAND_KIND_BUFFER_WRITE: res = RENOIR_GL450_COMMAND_SIZE(buffer_write); break;
+	case RENOIR_COMMAND_KIND_TEXTURE_WRITE: res = RENOIR_GL450_COMMAND_SIZE(texture_write); break;
+	case RENOIR_COMMAND_KIND_BUFFER_READ: res = RENOIR_GL450_COMMAND_SIZE(buffer_read); break;
+	case RENOIR_COMMAND_KIND_TEXTURE_READ: res = RENOIR_GL450_COMMAND_SIZE(texture_read); break;
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC: res = RENOIR_GL450_COMMAND_SIZE(buffer_read_async); break;
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC: res = RENOIR_GL450_COMMAND_SIZE(texture_read_async); break;
+	case RENOIR_COMMAND_KIND_BUFFER_BIND: res = RENOIR_GL450_COMMAND_SIZE(buffer_bind); break;
+	case RENOIR_COMMAND_KIND_TEXTURE_BIND: res = RENOIR_GL450_COMMAND_SIZE(texture_bind); break;
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND: res = RENOIR_GL450_COMMAND_SIZE(textures_bind); break;
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND: res = RENOIR_GL450_COMMAND_SIZE(buffers_bind); break;
+	case RENOIR_COMMAND_KIND_DRAW: res = RENOIR_GL450_COMMAND_SIZE(draw); break;
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT: res = RENOIR_GL450_COMMAND_SIZE(draw_indirect); break;
+	case RENOIR_COMMAND_KIND_DRAW_BATCH: res = RENOIR_GL450_COMMAND_SIZE(draw_batch); break;
+	case RENOIR_COMMAND_KIND_DISPATCH: res = RENOIR_GL450_COMMAND_SIZE(dispatch); break;
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT: res = RENOIR_GL450_COMMAND_SIZE(dispatch_indirect); break;
+	case RENOIR_COMMAND_KIND_TIMER_BEGIN: res = RENOIR_GL450_COMMAND_SIZE(timer_begin); break;
+	case RENOIR_COMMAND_KIND_TIMER_END: res = RENOIR_GL450_COMMAND_SIZE(timer_end); break;
+	case RENOIR_COMMAND_KIND_FENCE_INSERT: res = RENOIR_GL450_COMMAND_SIZE(fence_insert); break;
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE: res = RENOIR_GL450_COMMAND_SIZE(bundle_execute); break;
+	case RENOIR_COMMAND_KIND_NONE:
+	default:
+		assert(false && "unreachable");
+		break;
+	}
+	return res;
+}
+
+#undef RENOIR_GL450_COMMAND_SIZE
+
+inline static Renoir_Command*
+_renoir_gl450_command_alloc(IRenoir* self, Renoir_Command_Stream& stream, RENOIR_COMMAND_KIND kind, size_t size)
+{
+	// keep the next command in the stream aligned
+	size = (size + alignof(Renoir_Command) - 1) & ~(alignof(Renoir_Command) - 1);
+	auto command = (Renoir_Command*)_renoir_gl450_command_stream_alloc(self, stream, size);
+	memset(command, 0, size);
+	command->kind = kind;
+	command->size = uint32_t(size);
+	return command;
+}
+
+// global commands, should be called while holding the mutex
+static Renoir_Command*
+_renoir_gl450_command_new(IRenoir* self, RENOIR_COMMAND_KIND kind)
+{
+	return _renoir_gl450_command_alloc(self, self->command_stream, kind, _renoir_gl450_command_size(kind));
+}
+
+// pass commands are allocated from the pass stream so it doesn't need to hold the mutex
+static Renoir_Command*
+_renoir_gl450_command_new(IRenoir* self, Renoir_Handle* pass, RENOIR_COMMAND_KIND kind)
+{
+	auto& stream = _renoir_gl450_pass_command_stream(pass);
+	return _renoir_gl450_command_alloc(self, stream, kind, _renoir_gl450_command_size(kind));
+}
+
+// draw commands are variable sized, they only encode the used vertex buffers
+static Renoir_Command*
+_renoir_gl450_command_draw_new(IRenoir* self, Renoir_Handle* pass, int vertex_buffers_count)
+{
+	auto& stream = _renoir_gl450_pass_command_stream(pass);
+	auto size = offsetof(Renoir_Command, draw.vertex_buffers) + vertex_buffers_count * sizeof(Renoir_Vertex_Desc);
+	auto command = _renoir_gl450_command_alloc(self, stream, RENOIR_COMMAND_KIND_DRAW, size);
+	command->draw.vertex_buffers_count = vertex_buffers_count;
+	return command;
+}
+
+static Renoir_Command*
+_renoir_gl450_command_draw_indirect_new(IRenoir* self, Renoir_Handle* pass, int vertex_buffers_count)
+{
+	auto& stream = _renoir_gl450_pass_command_stream(pass);
+	auto size = offsetof(Renoir_Command, draw_indirect.vertex_buffers) + vertex_buffers_count * sizeof(Renoir_Vertex_Desc);
+	auto command = _renoir_gl450_command_alloc(self, stream, RENOIR_COMMAND_KIND_DRAW_INDIRECT, size);
+	command->draw_indirect.vertex_buffers_count = vertex_buffers_count;
+	return command;
+}
+
+static Renoir_Command*
+_renoir_gl450_command_draw_batch_new(IRenoir* self, Renoir_Handle* pass, int vertex_buffers_count)
+{
+	auto& stream = _renoir_gl450_pass_command_stream(pass);
+	auto size = offsetof(Renoir_Command, draw_batch.vertex_buffers) + vertex_buffers_count * sizeof(Renoir_Vertex_Desc);
+	auto command = _renoir_gl450_command_alloc(self, stream, RENOIR_COMMAND_KIND_DRAW_BATCH, size);
+	command->draw_batch.vertex_buffers_count = vertex_buffers_count;
+	return command;
+}
+
+static Renoir_Command*
+_renoir_gl450_command_textures_bind_new(IRenoir* self, Renoir_Handle* pass, int count)
+{
+	auto& stream = _renoir_gl450_pass_command_stream(pass);
+	auto size = offsetof(Renoir_Command, textures_bind.bindings) + count * sizeof(Renoir_GL450_Texture_Binding);
+	auto command = _renoir_gl450_command_alloc(self, stream, RENOIR_COMMAND_KIND_TEXTURES_BIND, size);
+	command->textures_bind.count = count;
+	return command;
+}
+
+static Renoir_Command*
+_renoir_gl450_command_buffers_bind_new(IRenoir* self, Renoir_Handle* pass, int count)
+{
+	auto& stream = _renoir_gl450_pass_command_stream(pass);
+	auto size = offsetof(Renoir_Command, buffers_bind.handles) + count * sizeof(Renoir_Handle*);
+	auto command = _renoir_gl450_command_alloc(self, stream, RENOIR_COMMAND_KIND_BUFFERS_BIND, size);
+	command->buffers_bind.count = count;
+	return command;
+}
+
+// multi binds reference a texture and a sampler per slot
+constexpr size_t RENOIR_GL450_COMMAND_HANDLES_SIZE = 2 * RENOIR_CONSTANT_MULTI_BIND_SIZE;
+static_assert(RENOIR_GL450_COMMAND_HANDLES_SIZE >= RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE + 3, "draw indirect handles don't fit");
+
+// handles used by the command, bundles hold a reference to them so they stay alive as long as the bundle
+inline static size_t
+_renoir_gl450_command_handles(Renoir_Command* command, Renoir_Handle** handles)
+{
+	size_t count = 0;
+	switch(command->kind)
+	{
+	case RENOIR_COMMAND_KIND_USE_PROGRAM:
+		handles[count++] = command->use_program.program;
+		break;
+	case RENOIR_COMMAND_KIND_BUFFER_WRITE:
+		handles[count++] = command->buffer_write.handle;
+		break;
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC:
+		handles[count++] = command->buffer_read_async.buffer;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC:
+		handles[count++] = command->texture_read_async.texture;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURE_WRITE:
+		handles[count++] = command->texture_write.handle;
+		break;
+	case RENOIR_COMMAND_KIND_BUFFER_BIND:
+		handles[count++] = command->buffer_bind.handle;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURE_BIND:
+		handles[count++] = command->texture_bind.handle;
+		if (command->texture_bind.sampler)
+			handles[count++] = command->texture_bind.sampler;
+		break;
+	case RENOIR_COMMAND_KIND_DRAW:
+		for (int i = 0; i < command->draw.vertex_buffers_count; ++i)
+			if (auto h = (Renoir_Handle*)command->draw.vertex_buffers[i].buffer.handle)
+				handles[count++] = h;
+		if (auto h = (Renoir_Handle*)command->draw.index_buffer.handle)
+			handles[count++] = h;
+		break;
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT:
+		for (int i = 0; i < command->draw_indirect.vertex_buffers_count; ++i)
+			if (auto h = (Renoir_Handle*)command->draw_indirect.vertex_buffers[i].buffer.handle)
+				handles[count++] = h;
+		if (auto h = (Renoir_Handle*)command->draw_indirect.index_buffer.handle)
+			handles[count++] = h;
+		handles[count++] = command->draw_indirect.buffer;
+		if (command->draw_indirect.count_buffer)
+			handles[count++] = command->draw_indirect.count_buffer;
+		break;
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND:
+		for (int i = 0; i < command->textures_bind.count; ++i)
+		{
+			handles[count++] = command->textures_bind.bindings[i].texture;
+			handles[count++] = command->textures_bind.bindings[i].sampler;
+		}
+		break;
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND:
+		for (int i = 0; i < command->buffers_bind.count; ++i)
+			handles[count++] = command->buffers_bind.handles[i];
+		break;
+	case RENOIR_COMMAND_KIND_DRAW_BATCH:
+		for (int i = 0; i < command->draw_batch.vertex_buffers_count; ++i)
+			if (auto h = (Renoir_Handle*)command->draw_batch.vertex_buffers[i].buffer.handle)
+				handles[count++] = h;
+		if (auto h = (Renoir_Handle*)command->draw_batch.index_buffer.handle)
+			handles[count++] = h;
+		break;
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT:
+		handles[count++] = command->dispatch_indirect.buffer;
+		break;
+	default:
+		// do nothing
+		break;
+	}
+	return count;
+}
+
+// issues the free command which releases a reference to the handle, should be called while holding the mutex
+// or from the render thread
+static void
+_renoir_gl450_handle_release(IRenoir* self, Renoir_Handle* h)
+{
+	_renoir_gl450_execution_lock(self);
+	mn_defer(_renoir_gl450_execution_unlock(self));
+
+	Renoir_Command* command = nullptr;
+	switch(h->kind)
+	{
+	case RENOIR_HANDLE_KIND_BUFFER:
+		command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_FREE);
+		command->buffer_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_TEXTURE:
+		command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
+		command->texture_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_SAMPLER:
+		command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_SAMPLER_FREE);
+		command->sampler_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_PROGRAM:
+		command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PROGRAM_FREE);
+		command->program_free.handle = h;
+		break;
+	case RENOIR_HANDLE_KIND_BUNDLE:
+		command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_FREE);
+		command->pass_free.handle = h;
+		break;
+	default:
+		assert(false && "unreachable");
+		return;
+	}
+	_renoir_gl450_command_process(self, command);
+}
+
+// frees the data owned by the command, the command memory itself is owned by its stream
+static void
+_renoir_gl450_command_free(IRenoir* self, Renoir_Command* command)
+{
+	switch(command->kind)
+	{
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE:
+	{
+		// release the reference which the command took on the bundle
+		_renoir_gl450_handle_release(self, command->bundle_execute.handle);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_USE_PIPELINE:
+	{
+		// release the reference which the command took on the cached pipeline
+		_renoir_gl450_pipeline_release(self, command->use_pipeline.handle);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_BUFFER_NEW:
+	{
+		if(command->buffer_new.owns_data)
+			mn::free(mn::Block{(void*)command->buffer_new.desc.data, command->buffer_new.desc.data_size});
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TEXTURE_NEW:
+	{
+		if(command->texture_new.owns_data)
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				if (command->texture_new.desc.data[i] == nullptr)
+					continue;
+
+				mn::free(mn::Block{(void*)command->texture_new.desc.data[i], command->texture_new.desc.data_size});
+			}
+		}
+		break;
 	}
 	case RENOIR_COMMAND_KIND_PROGRAM_NEW:
 	{
@@ -1275,16 +2792,6 @@ _renoir_gl450_command_free(T* self, Renoir_Command* command)
 		}
 		break;
 	}
-	case RENOIR_COMMAND_KIND_BUFFER_WRITE:
-	{
-		mn::free(mn::Block{(void*)command->buffer_write.bytes, command->buffer_write.bytes_size});
-		break;
-	}
-	case RENOIR_COMMAND_KIND_TEXTURE_WRITE:
-	{
-		mn::free(mn::Block{(void*)command->texture_write.desc.bytes, command->texture_write.desc.bytes_size});
-		break;
-	}
 	case RENOIR_COMMAND_KIND_NONE:
 	case RENOIR_COMMAND_KIND_INIT:
 	case RENOIR_COMMAND_KIND_SWAPCHAIN_NEW:
@@ -1301,61 +2808,331 @@ _renoir_gl450_command_free(T* self, Renoir_Command* command)
 	case RENOIR_COMMAND_KIND_TIMER_NEW:
 	case RENOIR_COMMAND_KIND_TIMER_FREE:
 	case RENOIR_COMMAND_KIND_TIMER_ELAPSED:
+	case RENOIR_COMMAND_KIND_READBACK_FREE:
+	case RENOIR_COMMAND_KIND_READBACK_POLL:
+	case RENOIR_COMMAND_KIND_FENCE_FREE:
+	case RENOIR_COMMAND_KIND_FENCE_POLL:
 	case RENOIR_COMMAND_KIND_PASS_BEGIN:
 	case RENOIR_COMMAND_KIND_PASS_END:
 	case RENOIR_COMMAND_KIND_PASS_CLEAR:
-	case RENOIR_COMMAND_KIND_USE_PIPELINE:
 	case RENOIR_COMMAND_KIND_USE_PROGRAM:
 	case RENOIR_COMMAND_KIND_USE_COMPUTE:
 	case RENOIR_COMMAND_KIND_SCISSOR:
+	// write payloads live in the upload blocks of the stream
+	case RENOIR_COMMAND_KIND_BUFFER_WRITE:
+	case RENOIR_COMMAND_KIND_TEXTURE_WRITE:
 	case RENOIR_COMMAND_KIND_BUFFER_READ:
 	case RENOIR_COMMAND_KIND_TEXTURE_READ:
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC:
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC:
 	case RENOIR_COMMAND_KIND_BUFFER_BIND:
 	case RENOIR_COMMAND_KIND_TEXTURE_BIND:
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND:
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND:
 	case RENOIR_COMMAND_KIND_DRAW:
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT:
+	case RENOIR_COMMAND_KIND_DRAW_BATCH:
 	case RENOIR_COMMAND_KIND_DISPATCH:
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT:
 	case RENOIR_COMMAND_KIND_TIMER_BEGIN:
 	case RENOIR_COMMAND_KIND_TIMER_END:
+	case RENOIR_COMMAND_KIND_FENCE_INSERT:
 	default:
 		// do nothing
 		break;
 	}
-	mn::pool_put(self->command_pool, command);
 }
 
-template<typename T>
 static void
-_renoir_gl450_command_push(T* self, Renoir_Command* command)
+_renoir_gl450_command_process(IRenoir* self, Renoir_Command* command)
 {
-	if(self->command_list_tail == nullptr)
+	// in case of deferred api calls the command is already in the global command stream
+	if (self->settings.defer_api_calls == false)
 	{
-		self->command_list_tail = command;
-		self->command_list_head = command;
-		return;
+		_renoir_gl450_command_execute(self, command);
+		_renoir_gl450_command_free(self, command);
+		_renoir_gl450_command_stream_pop(self->command_stream, command, command->size);
+	}
+}
+
+// returns the vao of the vertex format, it's created and configured on first use
+static Renoir_GL450_Vertex_Array*
+_renoir_gl450_vertex_array_get(IRenoir* self, const Renoir_GL450_Vertex_Format& format)
+{
+	// consecutive draws usually share the format, so the last used vao is checked first
+	if (self->vertex_array_last < self->vertex_arrays.count &&
+		::memcmp(&self->vertex_arrays[self->vertex_array_last].format, &format, sizeof(format)) == 0)
+	{
+		return &self->vertex_arrays[self->vertex_array_last];
+	}
+
+	for (size_t i = 0; i < self->vertex_arrays.count; ++i)
+	{
+		if (::memcmp(&self->vertex_arrays[i].format, &format, sizeof(format)) == 0)
+		{
+			self->vertex_array_last = i;
+			return &self->vertex_arrays[i];
+		}
+	}
+
+	Renoir_GL450_Vertex_Array array{};
+	array.format = format;
+	glCreateVertexArrays(1, &array.vao);
+	for (int i = 0; i < format.vertex_buffers_count; ++i)
+	{
+		if (format.types[i] == RENOIR_TYPE_NONE)
+			continue;
+
+		glEnableVertexArrayAttrib(array.vao, i);
+		glVertexArrayAttribFormat(
+			array.vao,
+			i,
+			_renoir_type_to_gl_element_count(format.types[i]),
+			_renoir_type_to_gl(format.types[i]),
+			_renoir_type_normalized(format.types[i]),
+			0
+		);
+		glVertexArrayAttribBinding(array.vao, i, i);
+		glVertexArrayBindingDivisor(array.vao, i, format.instance_step_rates[i]);
 	}
+	assert(_renoir_gl450_check());
+	// the bindings are unknown until the first draw sets them
+	::memset(&array.bindings, 0xFF, sizeof(array.bindings));
+	array.element_array_buffer = GLuint(-1);
 
-	self->command_list_tail->next = command;
-	command->prev = self->command_list_tail;
-	self->command_list_tail = command;
+	self->vertex_array_last = self->vertex_arrays.count;
+	mn::buf_push(self->vertex_arrays, array);
+	return &self->vertex_arrays[self->vertex_array_last];
 }
 
+// binds the vao of the draw's vertex format and its vertex and index buffers, draws which share the format
+// and the buffers issue no gl calls at all
 static void
-_renoir_gl450_command_process(IRenoir* self, Renoir_Command* command)
+_renoir_gl450_draw_buffers_bind(IRenoir* self, Renoir_Vertex_Desc* vertex_buffers, int vertex_buffers_count, Renoir_Buffer index_buffer)
 {
-	if (self->settings.defer_api_calls)
+	Renoir_GL450_Vertex_Format format{};
+	Renoir_GL450_Vertex_Bindings bindings{};
+	format.vertex_buffers_count = vertex_buffers_count;
+	for (int i = 0; i < vertex_buffers_count; ++i)
+	{
+		auto& vertex = vertex_buffers[i];
+		if (vertex.buffer.handle == nullptr)
+			continue;
+
+		auto h = (Renoir_Handle*)vertex.buffer.handle;
+		h->buffer.version_used = true;
+		format.types[i] = vertex.type;
+		format.instance_step_rates[i] = vertex.instance_step_rate;
+		bindings.buffers[i] = h->buffer.id;
+		bindings.offsets[i] = GLintptr(vertex.offset + _renoir_gl450_buffer_offset(h));
+		// calculate the default stride for the vertex buffer
+		bindings.strides[i] = GLsizei(vertex.stride != 0 ? vertex.stride : _renoir_type_to_size(vertex.type));
+	}
+
+	auto array = _renoir_gl450_vertex_array_get(self, format);
+	if (_renoir_gl450_shadow_set(self, self->shadow.vao, array->vao))
+		glBindVertexArray(array->vao);
+
+	if (vertex_buffers_count > 0 && _renoir_gl450_shadow_set(self, array->bindings, bindings))
+		glVertexArrayVertexBuffers(array->vao, 0, vertex_buffers_count, bindings.buffers, bindings.offsets, bindings.strides);
+
+	if (index_buffer.handle != nullptr)
+	{
+		auto h = (Renoir_Handle*)index_buffer.handle;
+		h->buffer.version_used = true;
+		if (_renoir_gl450_shadow_set(self, array->element_array_buffer, h->buffer.id))
+			glVertexArrayElementBuffer(array->vao, h->buffer.id);
+	}
+}
+
+// vertex descs have trailing padding after instance_step_rate so they're compared field by field instead of memcmp
+inline static bool
+_renoir_gl450_vertex_descs_equal(const Renoir_Vertex_Desc* a, const Renoir_Vertex_Desc* b, int count)
+{
+	for (int i = 0; i < count; ++i)
+	{
+		if (a[i].buffer.handle != b[i].buffer.handle ||
+			a[i].type != b[i].type ||
+			a[i].stride != b[i].stride ||
+			a[i].offset != b[i].offset ||
+			a[i].instance_step_rate != b[i].instance_step_rate)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// whether the draw can be merged with the draws of the current batch, they should use the same vertex and index buffers
+inline static bool
+_renoir_gl450_draw_batch_mergeable(IRenoir* self, Renoir_Command* command)
+{
+	if (self->draw_batch == nullptr)
+		return false;
+
+	auto& a = self->draw_batch->draw;
+	auto& b = command->draw;
+	return (
+		b.instances_count <= 1 &&
+		b.base_instance == 0 &&
+		a.primitive == b.primitive &&
+		a.index_buffer.handle == b.index_buffer.handle &&
+		a.index_type == b.index_type &&
+		a.index_offset == b.index_offset &&
+		a.vertex_buffers_count == b.vertex_buffers_count &&
+		_renoir_gl450_vertex_descs_equal(a.vertex_buffers, b.vertex_buffers, a.vertex_buffers_count)
+	);
+}
+
+// issues the draws gathered in the draw batch arrays with as few gl calls as possible and clears them,
+// the vertex and index buffers should already be bound
+static void
+_renoir_gl450_draw_batch_issue(IRenoir* self, RENOIR_PRIMITIVE primitive, Renoir_Buffer index_buffer, RENOIR_TYPE index_type, size_t index_offset)
+{
+	auto draws_count = GLsizei(self->draw_batch_counts.count);
+	if (draws_count == 0)
+		return;
+
+	auto gl_primitive = _renoir_primitive_to_gl(primitive);
+	if (index_buffer.handle != nullptr)
 	{
-		_renoir_gl450_command_push(self, command);
+		if (index_type == RENOIR_TYPE_NONE)
+			index_type = RENOIR_TYPE_UINT16;
+		auto gl_index_type = _renoir_type_to_gl(index_type);
+		auto gl_index_type_size = _renoir_type_to_size(index_type);
+		index_offset += _renoir_gl450_buffer_offset((Renoir_Handle*)index_buffer.handle);
+
+		if (draws_count == 1)
+		{
+			glDrawElementsBaseVertex(
+				gl_primitive,
+				self->draw_batch_counts[0],
+				gl_index_type,
+				(void*)(index_offset + self->draw_batch_firsts[0] * gl_index_type_size),
+				self->draw_batch_base_vertices[0]
+			);
+		}
+		else
+		{
+			mn::buf_clear(self->draw_batch_offsets);
+			for (auto first: self->draw_batch_firsts)
+				mn::buf_push(self->draw_batch_offsets, (const void*)(index_offset + first * gl_index_type_size));
+			// meshes packed into shared buffers differ in their base vertex, so one call covers all of them
+			glMultiDrawElementsBaseVertex(
+				gl_primitive,
+				self->draw_batch_counts.ptr,
+				gl_index_type,
+				(void**)self->draw_batch_offsets.ptr,
+				draws_count,
+				self->draw_batch_base_vertices.ptr
+			);
+		}
 	}
 	else
 	{
+		if (draws_count == 1)
+			glDrawArrays(gl_primitive, self->draw_batch_firsts[0], self->draw_batch_counts[0]);
+		else
+			glMultiDrawArrays(gl_primitive, self->draw_batch_firsts.ptr, self->draw_batch_counts.ptr, draws_count);
+	}
+	assert(_renoir_gl450_check());
+
+	self->frame_stats_pending.draws_merged += draws_count - 1;
+	mn::buf_clear(self->draw_batch_firsts);
+	mn::buf_clear(self->draw_batch_counts);
+	mn::buf_clear(self->draw_batch_base_vertices);
+}
+
+// issues the pending draws, the vertex and index buffers are already bound by the first draw of the batch
+static void
+_renoir_gl450_draw_batch_flush(IRenoir* self)
+{
+	if (self->draw_batch == nullptr)
+		return;
+
+	auto& desc = self->draw_batch->draw;
+	_renoir_gl450_draw_batch_issue(self, desc.primitive, desc.index_buffer, desc.index_type, desc.index_offset);
+	self->draw_batch = nullptr;
+}
+
+// copies the transient allocations of the frame into the ring and moves the ring base to them
+static void
+_renoir_gl450_transient_upload(IRenoir* self, Renoir_Command_Stream& stream)
+{
+	auto ring = self->transient_ring.buffer;
+	auto size = stream.transient_tail->base + stream.transient_tail->used;
+
+	size_t offset = 0;
+	if (ring->buffer.id == 0 || _renoir_gl450_ring_alloc(self, self->transient_ring, size, RENOIR_GL450_TRANSIENT_ALIGNMENT, offset) == false)
+	{
+		// the ring should fit a few frames of this size
+		auto capacity = ring->buffer.id == 0 ? self->settings.transient_buffer_size : ring->buffer.size * 2;
+		if (capacity < size * RENOIR_GL450_TRANSIENT_FRAMES_COUNT)
+			capacity = size * RENOIR_GL450_TRANSIENT_FRAMES_COUNT;
+		_renoir_gl450_ring_resize(self, self->transient_ring, capacity);
+		auto res = _renoir_gl450_ring_alloc(self, self->transient_ring, size, RENOIR_GL450_TRANSIENT_ALIGNMENT, offset);
+		assert(res && "transient ring should fit the frame after it grows");
+	}
+
+	for (auto block = stream.transient_head; block != nullptr; block = block->next)
+	{
+		::memcpy((char*)ring->buffer.mapped + offset + block->base, _renoir_gl450_upload_block_data(block), block->used);
+		self->frame_stats_pending.upload_bytes += block->used;
+	}
+	_renoir_gl450_buffer_base_set(self, ring, offset);
+}
+
+// executes all the commands in the stream and frees their data, should be called while holding the mutex
+// or from the render thread
+static void
+_renoir_gl450_command_stream_execute(IRenoir* self, Renoir_Command_Stream& stream)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	if (stream.transient_head != nullptr)
+		_renoir_gl450_transient_upload(self, stream);
+	_renoir_gl450_command_stream_for_each(stream, [self](Renoir_Command* command) {
 		_renoir_gl450_command_execute(self, command);
 		_renoir_gl450_command_free(self, command);
-	}
+		self->frame_stats_pending.command_count += 1;
+		self->frame_stats_pending.command_bytes += command->size;
+	});
+	_renoir_gl450_draw_batch_flush(self);
+	auto end = std::chrono::high_resolution_clock::now();
+	self->frame_stats_pending.execute_time_in_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+	for (auto block = stream.upload_head; block != nullptr; block = block->next)
+		self->frame_stats_pending.upload_bytes += block->used;
+}
+
+// moves the pending stats to the last frame stats, should be called while holding the mutex
+static void
+_renoir_gl450_frame_stats_end(IRenoir* self)
+{
+	if (self->frame_stats_pending.upload_bytes > self->upload_bytes_high_water)
+		self->upload_bytes_high_water = self->frame_stats_pending.upload_bytes;
+
+	self->frame_stats = self->frame_stats_pending;
+	self->frame_stats.upload_bytes_high_water = self->upload_bytes_high_water;
+	mn::mutex_lock(self->command_page_mtx);
+	self->frame_stats.upload_arena_size = self->upload_arena_size;
+	mn::mutex_unlock(self->command_page_mtx);
+	self->frame_stats_pending = Renoir_GL450_Frame_Stats{};
+
+	self->frame_stats.pipeline_cache_hits = self->pipeline_cache_hits;
+	self->frame_stats.pipeline_cache_misses = self->pipeline_cache_misses;
+	self->frame_stats.pipeline_cache_evictions = self->pipeline_cache_evictions;
+	self->pipeline_cache_hits = 0;
+	self->pipeline_cache_misses = 0;
+	self->pipeline_cache_evictions = 0;
 }
 
 static void
 _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 {
+	// the pending draws should be issued before any other command changes the state they use
+	if (command->kind != RENOIR_COMMAND_KIND_DRAW)
+		_renoir_gl450_draw_batch_flush(self);
+
 	switch(command->kind)
 	{
 	case RENOIR_COMMAND_KIND_INIT:
@@ -1385,8 +3162,11 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		glDebugMessageCallback(_renoir_gl450_error_log, nullptr);
 		#endif
 
-		glCreateVertexArrays(1, &self->vao);
 		glCreateFramebuffers(1, &self->msaa_resolve_fb);
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &self->uniform_buffer_offset_alignment);
+		if (size_t(self->uniform_buffer_offset_alignment) > RENOIR_GL450_TRANSIENT_ALIGNMENT)
+			mn::log_warning("gl450: uniform buffer offset alignment {} isn't supported by transient uniforms", self->uniform_buffer_offset_alignment);
+		_renoir_gl450_shadow_invalidate(self);
 		assert(_renoir_gl450_check());
 		break;
 	}
@@ -1546,8 +3326,11 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 
 		if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
 		{
-			for(auto it = h->raster_pass.command_list_head; it != NULL; it = it->next)
-				_renoir_gl450_command_free(self, command);
+			_renoir_gl450_command_stream_for_each(h->raster_pass.command_stream, [self](Renoir_Command* it) {
+				_renoir_gl450_command_free(self, it);
+			});
+			_renoir_gl450_command_stream_release(self, h->raster_pass.command_stream);
+			_renoir_gl450_draw_sort_free(h->raster_pass.draw_sort);
 
 			// free all the bound textures if it's a framebuffer pass
 			if (h->raster_pass.fb != 0)
@@ -1559,18 +3342,14 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 						continue;
 
 					// issue command to free the color texture
-					auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
-					command->texture_free.handle = color;
-					_renoir_gl450_command_process(self, command);
+					_renoir_gl450_handle_release(self, color);
 				}
 
 				auto depth = (Renoir_Handle*)h->raster_pass.offscreen.depth_stencil.texture.handle;
 				if (depth)
 				{
 					// issue command to free the depth texture
-					auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
-					command->texture_free.handle = depth;
-					_renoir_gl450_command_process(self, command);
+					_renoir_gl450_handle_release(self, depth);
 				}
 
 				glDeleteFramebuffers(1, &h->raster_pass.fb);
@@ -1578,8 +3357,25 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		}
 		else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
 		{
-			for(auto it = h->compute_pass.command_list_head; it != NULL; it = it->next)
-				_renoir_gl450_command_free(self, command);
+			_renoir_gl450_command_stream_for_each(h->compute_pass.command_stream, [self](Renoir_Command* it) {
+				_renoir_gl450_command_free(self, it);
+			});
+			_renoir_gl450_command_stream_release(self, h->compute_pass.command_stream);
+		}
+		else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		{
+			_renoir_gl450_command_stream_for_each(h->bundle.command_stream, [self, h](Renoir_Command* it) {
+				// release the handles which the bundle kept alive
+				if (h->bundle.recorded)
+				{
+					Renoir_Handle* handles[RENOIR_GL450_COMMAND_HANDLES_SIZE];
+					auto handles_count = _renoir_gl450_command_handles(it, handles);
+					for (size_t i = 0; i < handles_count; ++i)
+						_renoir_gl450_handle_release(self, handles[i]);
+				}
+				_renoir_gl450_command_free(self, it);
+			});
+			_renoir_gl450_command_stream_release(self, h->bundle.command_stream);
 		}
 		else
 		{
@@ -1603,11 +3399,28 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 			);
 		}
 
-		auto gl_usage = _renoir_usage_to_gl(desc.usage);
-
 		renoir_gl450_context_bind(self->ctx);
 		glCreateBuffers(1, &h->buffer.id);
-		glNamedBufferData(h->buffer.id, desc.data_size, desc.data, gl_usage);
+		if (_renoir_gl450_buffer_renamable(desc))
+		{
+			// slices should start at offsets which the uniform buffer bindings accept
+			auto alignment = size_t(self->uniform_buffer_offset_alignment > 0 ? self->uniform_buffer_offset_alignment : 256);
+			h->buffer.renamed = true;
+			h->buffer.slice_size = (desc.data_size + alignment - 1) / alignment * alignment;
+
+			auto storage_size = h->buffer.slice_size * RENOIR_GL450_BUFFER_SLICES_COUNT;
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glNamedBufferStorage(h->buffer.id, storage_size, nullptr, flags | GL_DYNAMIC_STORAGE_BIT);
+			h->buffer.mapped = glMapNamedBufferRange(h->buffer.id, 0, storage_size, flags);
+			h->buffer.storage_id = h->buffer.id;
+			h->buffer.storage_mapped = h->buffer.mapped;
+			if (desc.data)
+				::memcpy(h->buffer.mapped, desc.data, desc.data_size);
+		}
+		else
+		{
+			glNamedBufferStorage(h->buffer.id, desc.data_size, desc.data, _renoir_buffer_storage_flags_to_gl(desc.usage, desc.access));
+		}
 		assert(_renoir_gl450_check());
 		break;
 	}
@@ -1616,7 +3429,21 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->buffer_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
-		glDeleteBuffers(1, &h->buffer.id);
+		// the current version of a spilled buffer is in the rename ring which outlives it
+		if (h->buffer.spilled)
+		{
+			for (size_t i = 0; i < self->spilled_buffers.count; ++i)
+			{
+				if (self->spilled_buffers[i] == h)
+				{
+					mn::buf_remove(self->spilled_buffers, i);
+					break;
+				}
+			}
+		}
+		auto id = h->buffer.renamed ? h->buffer.storage_id : h->buffer.id;
+		_renoir_gl450_shadow_forget_buffer(self, id);
+		glDeleteBuffers(1, &id);
 		_renoir_gl450_handle_free(self, h);
 		assert(_renoir_gl450_check());
 		break;
@@ -1772,6 +3599,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->texture_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
+		_renoir_gl450_shadow_forget(self->shadow.textures, h->texture.id);
 		glDeleteTextures(1, &h->texture.id);
 		for (int i = 0; i < 6; ++i)
 		{
@@ -1819,6 +3647,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->sampler_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
+		_renoir_gl450_shadow_forget(self->shadow.samplers, h->sampler.id);
 		glDeleteSamplers(1, &h->sampler.id);
 		_renoir_gl450_handle_free(self, h);
 		assert(_renoir_gl450_check());
@@ -1910,6 +3739,8 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->program_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
+		if (self->shadow.program == h->program.id)
+			self->shadow.program = GLuint(-1);
 		glDeleteProgram(h->program.id);
 		_renoir_gl450_handle_free(self, h);
 		assert(_renoir_gl450_check());
@@ -1960,6 +3791,8 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->compute_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
+		if (self->shadow.program == h->compute.id)
+			self->shadow.program = GLuint(-1);
 		glDeleteProgram(h->compute.id);
 		_renoir_gl450_handle_free(self, h);
 		assert(_renoir_gl450_check());
@@ -1977,28 +3810,106 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->timer_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
-		glDeleteQueries(2, h->timer.timepoints);
-		_renoir_gl450_handle_free(self, h);
+		glDeleteQueries(2, h->timer.timepoints);
+		_renoir_gl450_handle_free(self, h);
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TIMER_ELAPSED:
+	{
+		auto h = command->timer_elapsed.handle;
+		assert(h->timer.state == RENOIR_TIMER_STATE_READ_SCHEDULED);
+		GLint result_available = 0;
+		glGetQueryObjectiv(h->timer.timepoints[1], GL_QUERY_RESULT_AVAILABLE, &result_available);
+		if (result_available)
+		{
+			GLuint64 timepoint[2];
+			glGetQueryObjectui64v(h->timer.timepoints[0], GL_QUERY_RESULT, &timepoint[0]);
+			glGetQueryObjectui64v(h->timer.timepoints[1], GL_QUERY_RESULT, &timepoint[1]);
+			h->timer.elapsed_time_in_nanos = timepoint[1] - timepoint[0];
+			h->timer.state = RENOIR_TIMER_STATE_READY;
+		}
+		else
+		{
+			h->timer.state = RENOIR_TIMER_STATE_END;
+		}
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_READBACK_FREE:
+	{
+		auto h = command->readback_free.handle;
+		if (_renoir_gl450_handle_unref(h) == false)
+			break;
+		if (h->readback.fence)
+			glDeleteSync(h->readback.fence);
+		if (h->readback.staging)
+			_renoir_gl450_staging_release(self, Renoir_GL450_Staging_Buffer{h->readback.staging, h->readback.staging_size, h->readback.mapped});
+		_renoir_gl450_handle_free(self, h);
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_FENCE_FREE:
+	{
+		auto h = command->fence_free.handle;
+		if (_renoir_gl450_handle_unref(h) == false)
+			break;
+		if (h->fence.sync)
+			glDeleteSync(h->fence.sync);
+		_renoir_gl450_handle_free(self, h);
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_FENCE_POLL:
+	{
+		auto h = command->fence_poll.handle;
+		h->fence.poll_scheduled = false;
+		// the last executed insert is already signaled or nothing was inserted yet
+		if (h->fence.sync == nullptr)
+			break;
+
+		auto timeout = command->fence_poll.timeout_in_nanos;
+		auto res = glClientWaitSync(h->fence.sync, timeout > 0 ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeout);
+		if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED)
+		{
+			glDeleteSync(h->fence.sync);
+			h->fence.sync = nullptr;
+			h->fence.signaled_generation = h->fence.sync_generation;
+		}
+		else if (res == GL_WAIT_FAILED)
+		{
+			mn::log_error("gl450: fence wait failed");
+		}
 		assert(_renoir_gl450_check());
 		break;
 	}
-	case RENOIR_COMMAND_KIND_TIMER_ELAPSED:
+	case RENOIR_COMMAND_KIND_READBACK_POLL:
 	{
-		auto h = command->timer_elapsed.handle;
-		assert(h->timer.state == RENOIR_TIMER_STATE_READ_SCHEDULED);
-		GLint result_available = 0;
-		glGetQueryObjectiv(h->timer.timepoints[1], GL_QUERY_RESULT_AVAILABLE, &result_available);
-		if (result_available)
+		auto h = command->readback_poll.handle;
+		// a blocking poll could have finished the readback before this one executed
+		if (h->readback.state == RENOIR_READBACK_STATE_READY)
+			break;
+
+		h->readback.state = RENOIR_READBACK_STATE_PENDING;
+		// the copy didn't execute yet
+		if (h->readback.fence == nullptr)
+			break;
+
+		GLenum res = GL_TIMEOUT_EXPIRED;
+		if (command->readback_poll.wait)
+			res = glClientWaitSync(h->readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(-1));
+		else
+			res = glClientWaitSync(h->readback.fence, 0, 0);
+
+		if (res == GL_ALREADY_SIGNALED || res == GL_CONDITION_SATISFIED)
 		{
-			GLuint64 timepoint[2];
-			glGetQueryObjectui64v(h->timer.timepoints[0], GL_QUERY_RESULT, &timepoint[0]);
-			glGetQueryObjectui64v(h->timer.timepoints[1], GL_QUERY_RESULT, &timepoint[1]);
-			h->timer.elapsed_time_in_nanos = timepoint[1] - timepoint[0];
-			h->timer.state = RENOIR_TIMER_STATE_READY;
+			glDeleteSync(h->readback.fence);
+			h->readback.fence = nullptr;
+			h->readback.state = RENOIR_READBACK_STATE_READY;
 		}
-		else
+		else if (res == GL_WAIT_FAILED)
 		{
-			h->timer.state = RENOIR_TIMER_STATE_END;
+			mn::log_error("gl450: readback fence wait failed");
 		}
 		assert(_renoir_gl450_check());
 		break;
@@ -2014,7 +3925,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 				renoir_gl450_context_window_bind(self->ctx, swapchain);
 				glBindFramebuffer(GL_FRAMEBUFFER, NULL);
 				glViewport(0, 0, swapchain->swapchain.width, swapchain->swapchain.height);
-				glDisable(GL_SCISSOR_TEST);
+				_renoir_gl450_shadow_cap(self, GL_SCISSOR_TEST, self->shadow.scissor, false);
 				self->current_pass = h;
 			}
 			// this is an off screen
@@ -2022,7 +3933,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 			{
 				glBindFramebuffer(GL_FRAMEBUFFER, h->raster_pass.fb);
 				glViewport(0, 0, h->raster_pass.width, h->raster_pass.height);
-				glDisable(GL_SCISSOR_TEST);
+				_renoir_gl450_shadow_cap(self, GL_SCISSOR_TEST, self->shadow.scissor, false);
 				self->current_pass = h;
 			}
 			else
@@ -2049,8 +3960,8 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
 		{
 			// Note(Moustapha): this is because of opengl weird specs, scissor box will affect the blit
-			auto scissor_enabled = glIsEnabled(GL_SCISSOR_TEST);
-			glDisable(GL_SCISSOR_TEST);
+			bool scissor_enabled = self->shadow.scissor == -1 ? glIsEnabled(GL_SCISSOR_TEST) : self->shadow.scissor == 1;
+			_renoir_gl450_shadow_cap(self, GL_SCISSOR_TEST, self->shadow.scissor, false);
 
 			// if this is an off screen view with msaa we'll need to issue a read command to move the data
 			// from renderbuffer to the texture
@@ -2127,10 +4038,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 				glNamedFramebufferTexture(self->msaa_resolve_fb, GL_DEPTH_STENCIL_ATTACHMENT, 0, 0);
 			}
 
-			if (scissor_enabled)
-				glEnable(GL_SCISSOR_TEST);
-			else
-				glDisable(GL_SCISSOR_TEST);
+			_renoir_gl450_shadow_cap(self, GL_SCISSOR_TEST, self->shadow.scissor, scissor_enabled);
 		}
 		else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
 		{
@@ -2141,8 +4049,12 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 			assert(false && "invalid pass");
 		}
 		self->current_pass = nullptr;
-		self->current_pipeline->pipeline.desc = Renoir_Pipeline_Desc{};
-		_renoir_gl450_pipeline_desc_defaults(&self->current_pipeline->pipeline.desc);
+		// the next pass begins with scissor disabled so we can't skip its first use_pipeline
+		if (self->current_pipeline)
+		{
+			_renoir_gl450_pipeline_release(self, self->current_pipeline);
+			self->current_pipeline = nullptr;
+		}
 		assert(_renoir_gl450_check());
 		break;
 	}
@@ -2199,127 +4111,124 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 	}
 	case RENOIR_COMMAND_KIND_USE_PIPELINE:
 	{
-		self->current_pipeline->pipeline.desc = command->use_pipeline.pipeline_desc;
-		auto h = self->current_pipeline;
+		auto h = command->use_pipeline.handle;
+		// pipelines are cached so the same desc will always map to the same handle
+		if (h == self->current_pipeline)
+			break;
 
-		if (h->pipeline.desc.rasterizer.cull == RENOIR_SWITCH_ENABLE)
+		// only the state which differs from the currently bound pipeline reaches gl, the shadow state takes care of that
+		auto& shadow = self->shadow;
+		auto& desc = h->pipeline.desc;
+
+		if (desc.rasterizer.cull == RENOIR_SWITCH_ENABLE)
 		{
-			auto gl_face = _renoir_face_to_gl(h->pipeline.desc.rasterizer.cull_face);
-			auto gl_orientation = _renoir_orientation_to_gl(h->pipeline.desc.rasterizer.cull_front);
-			glEnable(GL_CULL_FACE);
-			glCullFace(gl_face);
-			glFrontFace(gl_orientation);
+			_renoir_gl450_shadow_cap(self, GL_CULL_FACE, shadow.cull, true);
+			if (_renoir_gl450_shadow_set(self, shadow.cull_face, h->pipeline.gl_cull_face))
+				glCullFace(h->pipeline.gl_cull_face);
+			if (_renoir_gl450_shadow_set(self, shadow.front_face, h->pipeline.gl_cull_front))
+				glFrontFace(h->pipeline.gl_cull_front);
 		}
 		else
 		{
-			glDisable(GL_CULL_FACE);
+			_renoir_gl450_shadow_cap(self, GL_CULL_FACE, shadow.cull, false);
 		}
 
-		switch (h->pipeline.desc.rasterizer.scissor)
-		{
-		case RENOIR_SWITCH_ENABLE:
-			glEnable(GL_SCISSOR_TEST);
-			break;
-		case RENOIR_SWITCH_DISABLE:
-			glDisable(GL_SCISSOR_TEST);
-			break;
-		default:
-			assert(false && "unreachable");
-			break;
-		}
+		_renoir_gl450_shadow_cap(self, GL_SCISSOR_TEST, shadow.scissor, desc.rasterizer.scissor == RENOIR_SWITCH_ENABLE);
 
-		if (h->pipeline.desc.depth_stencil.depth == RENOIR_SWITCH_ENABLE)
+		if (desc.depth_stencil.depth == RENOIR_SWITCH_ENABLE)
 		{
-			glEnable(GL_DEPTH_TEST);
-			glDepthRange(0.0, 1.0);
+			_renoir_gl450_shadow_cap(self, GL_DEPTH_TEST, shadow.depth, true);
+			if (_renoir_gl450_shadow_set(self, shadow.depth_range, int8_t(1)))
+				glDepthRange(0.0, 1.0);
 		}
 		else
 		{
-			glDisable(GL_DEPTH_TEST);
+			_renoir_gl450_shadow_cap(self, GL_DEPTH_TEST, shadow.depth, false);
 		}
 
-		if (h->pipeline.desc.depth_stencil.depth_write_mask == RENOIR_SWITCH_ENABLE)
-		{
-			glDepthMask(GL_TRUE);
-		}
-		else
-		{
-			glDepthMask(GL_FALSE);
-		}
+		auto depth_mask = int8_t(desc.depth_stencil.depth_write_mask == RENOIR_SWITCH_ENABLE);
+		if (_renoir_gl450_shadow_set(self, shadow.depth_mask, depth_mask))
+			glDepthMask(depth_mask ? GL_TRUE : GL_FALSE);
 
+		auto independent_blend = desc.independent_blend == RENOIR_SWITCH_ENABLE;
 		for (int i = 0; i < RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE; ++i)
 		{
-			if (h->pipeline.desc.blend[i].enabled == RENOIR_SWITCH_ENABLE)
+			if (desc.blend[i].enabled == RENOIR_SWITCH_ENABLE)
 			{
-				auto gl_src_rgb = _renoir_blend_to_gl(h->pipeline.desc.blend[i].src_rgb);
-				auto gl_dst_rgb = _renoir_blend_to_gl(h->pipeline.desc.blend[i].dst_rgb);
-				auto gl_src_alpha = _renoir_blend_to_gl(h->pipeline.desc.blend[i].src_alpha);
-				auto gl_dst_alpha = _renoir_blend_to_gl(h->pipeline.desc.blend[i].dst_alpha);
-				auto gl_blend_eq_rgb = _renoir_blend_eq_to_gl(h->pipeline.desc.blend[i].eq_rgb);
-				auto gl_blend_eq_alpha = _renoir_blend_eq_to_gl(h->pipeline.desc.blend[i].eq_alpha);
-				if (h->pipeline.desc.independent_blend == RENOIR_SWITCH_ENABLE)
+				auto gl_func_src = h->pipeline.gl_blend_func[i];
+				auto gl_eq_src = h->pipeline.gl_blend_eq[i];
+				Renoir_GL450_Shadow_Blend_Func gl_func{gl_func_src[0], gl_func_src[1], gl_func_src[2], gl_func_src[3]};
+				Renoir_GL450_Shadow_Blend_Eq gl_eq{gl_eq_src[0], gl_eq_src[1]};
+				if (independent_blend)
 				{
-					glEnablei(GL_BLEND, i);
-					glBlendFuncSeparatei(i, gl_src_rgb, gl_dst_rgb, gl_src_alpha, gl_dst_alpha);
-					glBlendEquationSeparatei(i, gl_blend_eq_rgb, gl_blend_eq_alpha);
+					if (_renoir_gl450_shadow_set(self, shadow.blend[i], int8_t(1)))
+						glEnablei(GL_BLEND, i);
+					if (_renoir_gl450_shadow_set(self, shadow.blend_func[i], gl_func))
+						glBlendFuncSeparatei(i, gl_func.src_rgb, gl_func.dst_rgb, gl_func.src_alpha, gl_func.dst_alpha);
+					if (_renoir_gl450_shadow_set(self, shadow.blend_eq[i], gl_eq))
+						glBlendEquationSeparatei(i, gl_eq.rgb, gl_eq.alpha);
 				}
 				else
 				{
-					glEnable(GL_BLEND);
-					glBlendFuncSeparate(gl_src_rgb, gl_dst_rgb, gl_src_alpha, gl_dst_alpha);
-					glBlendEquationSeparate(gl_blend_eq_rgb, gl_blend_eq_alpha);
+					if (_renoir_gl450_shadow_set_all(self, shadow.blend, int8_t(1)))
+						glEnable(GL_BLEND);
+					if (_renoir_gl450_shadow_set_all(self, shadow.blend_func, gl_func))
+						glBlendFuncSeparate(gl_func.src_rgb, gl_func.dst_rgb, gl_func.src_alpha, gl_func.dst_alpha);
+					if (_renoir_gl450_shadow_set_all(self, shadow.blend_eq, gl_eq))
+						glBlendEquationSeparate(gl_eq.rgb, gl_eq.alpha);
 				}
 			}
 			else
 			{
-				if (h->pipeline.desc.independent_blend == RENOIR_SWITCH_ENABLE)
+				if (independent_blend)
 				{
-					glDisablei(GL_BLEND, i);
+					if (_renoir_gl450_shadow_set(self, shadow.blend[i], int8_t(0)))
+						glDisablei(GL_BLEND, i);
 				}
 				else
 				{
-					glDisable(GL_BLEND);
+					if (_renoir_gl450_shadow_set_all(self, shadow.blend, int8_t(0)))
+						glDisable(GL_BLEND);
 				}
 			}
 
-			if (h->pipeline.desc.independent_blend == RENOIR_SWITCH_ENABLE)
+			auto color_mask = h->pipeline.color_mask[i];
+			if (independent_blend)
 			{
-				if (h->pipeline.desc.blend[i].color_mask == RENOIR_COLOR_MASK_NONE)
-				{
-					glColorMaski(i, false, false, false, false);
-				}
-				else
+				if (_renoir_gl450_shadow_set(self, shadow.color_mask[i], color_mask))
 				{
 					glColorMaski(
 						i,
-						(h->pipeline.desc.blend[i].color_mask & RENOIR_COLOR_MASK_RED) != 0,
-						(h->pipeline.desc.blend[i].color_mask & RENOIR_COLOR_MASK_GREEN) != 0,
-						(h->pipeline.desc.blend[i].color_mask & RENOIR_COLOR_MASK_BLUE) != 0,
-						(h->pipeline.desc.blend[i].color_mask & RENOIR_COLOR_MASK_ALPHA) != 0
+						(color_mask & RENOIR_COLOR_MASK_RED) != 0,
+						(color_mask & RENOIR_COLOR_MASK_GREEN) != 0,
+						(color_mask & RENOIR_COLOR_MASK_BLUE) != 0,
+						(color_mask & RENOIR_COLOR_MASK_ALPHA) != 0
 					);
 				}
 			}
 			else
 			{
-				if (h->pipeline.desc.blend[i].color_mask == RENOIR_COLOR_MASK_NONE)
-				{
-					glColorMask(false, false, false, false);
-				}
-				else
+				if (_renoir_gl450_shadow_set_all(self, shadow.color_mask, color_mask))
 				{
 					glColorMask(
-						(h->pipeline.desc.blend[i].color_mask& RENOIR_COLOR_MASK_RED) != 0,
-						(h->pipeline.desc.blend[i].color_mask& RENOIR_COLOR_MASK_GREEN) != 0,
-						(h->pipeline.desc.blend[i].color_mask& RENOIR_COLOR_MASK_BLUE) != 0,
-						(h->pipeline.desc.blend[i].color_mask& RENOIR_COLOR_MASK_ALPHA) != 0
+						(color_mask & RENOIR_COLOR_MASK_RED) != 0,
+						(color_mask & RENOIR_COLOR_MASK_GREEN) != 0,
+						(color_mask & RENOIR_COLOR_MASK_BLUE) != 0,
+						(color_mask & RENOIR_COLOR_MASK_ALPHA) != 0
 					);
 				}
 			}
 
-			if (h->pipeline.desc.independent_blend == RENOIR_SWITCH_DISABLE)
+			if (independent_blend == false)
 				break;
 		}
 
+		// the executor keeps the bound pipeline alive so that the handle comparison above stays valid
+		_renoir_gl450_handle_ref(h);
+		if (self->current_pipeline)
+			_renoir_gl450_pipeline_release(self, self->current_pipeline);
+		self->current_pipeline = h;
+
 		assert(_renoir_gl450_check());
 		break;
 	}
@@ -2328,7 +4237,8 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->use_program.program;
 		self->current_program = h;
 		self->current_compute = nullptr;
-		glUseProgram(self->current_program->program.id);
+		if (_renoir_gl450_shadow_set(self, self->shadow.program, h->program.id))
+			glUseProgram(h->program.id);
 		assert(_renoir_gl450_check());
 		break;
 	}
@@ -2337,19 +4247,39 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto h = command->use_compute.compute;
 		self->current_compute = h;
 		self->current_program = nullptr;
-		glUseProgram(self->current_compute->compute.id);
+		if (_renoir_gl450_shadow_set(self, self->shadow.program, h->compute.id))
+			glUseProgram(h->compute.id);
 		assert(_renoir_gl450_check());
 		break;
 	}
 	case RENOIR_COMMAND_KIND_SCISSOR:
 	{
-		glScissor(command->scissor.x, command->scissor.y, command->scissor.w, command->scissor.h);
+		Renoir_GL450_Shadow_Rect box{command->scissor.x, command->scissor.y, command->scissor.w, command->scissor.h};
+		if (_renoir_gl450_shadow_set(self, self->shadow.scissor_box, box))
+			glScissor(box.x, box.y, box.w, box.h);
 		assert(_renoir_gl450_check());
 		break;
 	}
 	case RENOIR_COMMAND_KIND_BUFFER_WRITE:
 	{
 		auto h = command->buffer_write.handle;
+		assert(h->buffer.transient == false && "transient memory is written through its pointer");
+		if (h->buffer.renamed)
+		{
+			_renoir_gl450_buffer_write_renamed(
+				self,
+				h,
+				command->buffer_write.offset,
+				command->buffer_write.bytes,
+				command->buffer_write.bytes_size
+			);
+			assert(_renoir_gl450_check());
+			break;
+		}
+		// writes which replace the whole buffer let the driver orphan the old storage instead of waiting for the
+		// gpu to finish reading it
+		if (command->buffer_write.offset == 0 && command->buffer_write.bytes_size == h->buffer.size)
+			glInvalidateBufferData(h->buffer.id);
 		glNamedBufferSubData(
 			h->buffer.id,
 			command->buffer_write.offset,
@@ -2365,6 +4295,11 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		auto gl_format = _renoir_pixelformat_to_gl(h->texture.desc.pixel_format);
 		auto gl_type = _renoir_pixelformat_to_type_gl(h->texture.desc.pixel_format);
 
+		// the gl functions read the pixels from the unpack ring instead of client memory so the upload is done
+		// by the gpu instead of a synchronous driver copy
+		auto pixels = _renoir_gl450_unpack_ring_stage(self, command->texture_write.desc.bytes, command->texture_write.desc.bytes_size);
+		mn_defer(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
 		// change alignment to match pixel data
 		GLint original_pack_alignment = 0;
 		glGetIntegerv(GL_UNPACK_ALIGNMENT, &original_pack_alignment);
@@ -2385,7 +4320,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 				command->texture_write.desc.width,
 				gl_format,
 				gl_type,
-				command->texture_write.desc.bytes
+				pixels
 			);
 			if (h->texture.desc.mipmaps > 1)
 				glGenerateTextureMipmap(h->texture.id);
@@ -2404,7 +4339,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 					command->texture_write.desc.height,
 					gl_format,
 					gl_type,
-					command->texture_write.desc.bytes
+					pixels
 				);
 				if (h->texture.desc.mipmaps > 1)
 					glGenerateTextureMipmap(h->texture.id);
@@ -2423,7 +4358,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 					1,
 					gl_format,
 					gl_type,
-					command->texture_write.desc.bytes
+					pixels
 				);
 				if (h->texture.desc.mipmaps > 1)
 					glGenerateTextureMipmap(h->texture.id);
@@ -2443,7 +4378,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 				command->texture_write.desc.depth,
 				gl_format,
 				gl_type,
-				command->texture_write.desc.bytes
+				pixels
 			);
 			if (h->texture.desc.mipmaps > 1)
 				glGenerateTextureMipmap(h->texture.id);
@@ -2454,6 +4389,13 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 	case RENOIR_COMMAND_KIND_BUFFER_READ:
 	{
 		auto h = command->buffer_read.handle;
+		// renamed buffers are only written through their mapping so the mapped slice is already up to date
+		if (h->buffer.renamed)
+		{
+			auto ptr = (char*)h->buffer.mapped + _renoir_gl450_buffer_offset(h) + command->buffer_read.offset;
+			::memcpy(command->buffer_read.bytes, ptr, command->buffer_read.bytes_size);
+			break;
+		}
 		void* ptr = glMapNamedBufferRange(
 			h->buffer.id,
 			command->buffer_read.offset,
@@ -2559,19 +4501,93 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		assert(_renoir_gl450_check());
 		break;
 	}
+	case RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC:
+	{
+		auto h = command->buffer_read_async.handle;
+		auto hbuffer = command->buffer_read_async.buffer;
+		hbuffer->buffer.version_used = true;
+
+		glCopyNamedBufferSubData(
+			hbuffer->buffer.id,
+			_renoir_gl450_readback_staging_acquire(self, h, command->buffer_read_async.size),
+			_renoir_gl450_buffer_offset(hbuffer) + command->buffer_read_async.offset,
+			0,
+			command->buffer_read_async.size
+		);
+		h->readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC:
+	{
+		auto h = command->texture_read_async.handle;
+		auto htexture = command->texture_read_async.texture;
+		auto& desc = command->texture_read_async.desc;
+		auto pixel_format = htexture->texture.desc.pixel_format;
+
+		// the texture is packed into the staging buffer instead of client memory so the call doesn't wait for the gpu
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, _renoir_gl450_readback_staging_acquire(self, h, command->texture_read_async.size));
+
+		GLint original_pack_alignment = 0;
+		glGetIntegerv(GL_PACK_ALIGNMENT, &original_pack_alignment);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glPixelStorei(GL_PACK_ROW_LENGTH, GLint(desc.row_pitch / _renoir_pixelformat_to_size(pixel_format)));
+
+		glGetTextureSubImage(
+			htexture->texture.id,
+			desc.level,
+			desc.x,
+			desc.y,
+			desc.z,
+			desc.width,
+			desc.height,
+			desc.depth,
+			_renoir_pixelformat_to_gl(pixel_format),
+			_renoir_pixelformat_to_type_gl(pixel_format),
+			GLsizei(command->texture_read_async.size),
+			nullptr
+		);
+
+		glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_PACK_ALIGNMENT, original_pack_alignment);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		h->readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		assert(_renoir_gl450_check());
+		break;
+	}
 	case RENOIR_COMMAND_KIND_BUFFER_BIND:
 	{
 		auto h = command->buffer_bind.handle;
-		assert(h->buffer.type == RENOIR_BUFFER_UNIFORM || h->buffer.type == RENOIR_BUFFER_COMPUTE);
-		auto gl_type = _renoir_buffer_type_to_gl(h->buffer.type);
-		glBindBufferBase(gl_type, command->buffer_bind.slot, h->buffer.id);
+		assert(h->buffer.type == RENOIR_BUFFER_UNIFORM || h->buffer.type == RENOIR_BUFFER_COMPUTE || h->buffer.type == RENOIR_BUFFER_INDIRECT);
+		h->buffer.version_used = true;
+		// indirect buffers are bound as storage buffers so that compute shaders can write the arguments
+		auto gl_type = h->buffer.type == RENOIR_BUFFER_UNIFORM ? GL_UNIFORM_BUFFER : GL_SHADER_STORAGE_BUFFER;
+		auto slot = command->buffer_bind.slot;
+		auto& shadow = h->buffer.type == RENOIR_BUFFER_UNIFORM ? self->shadow.uniform_buffers : self->shadow.storage_buffers;
+		Renoir_GL450_Shadow_Buffer_Range range{};
+		range.id = h->buffer.id;
+		range.offset = GLintptr(_renoir_gl450_buffer_offset(h) + command->buffer_bind.offset);
+		range.size = GLsizeiptr(command->buffer_bind.size);
+		// renamed buffers move within their storage so they're bound as a range even if the whole buffer is used,
+		// the transient ring is always bound with an explicit range
+		assert((range.size > 0 || h->buffer.transient == false) && "transient memory should be bound with buffer_bind_range");
+		if (range.size == 0 && h->buffer.renamed)
+			range.size = GLsizeiptr(h->buffer.size);
+		if (slot >= RENOIR_GL450_SHADOW_SLOTS_SIZE || _renoir_gl450_shadow_set(self, shadow[slot], range))
+		{
+			if (range.size == 0)
+				glBindBufferBase(gl_type, slot, range.id);
+			else
+				glBindBufferRange(gl_type, slot, range.id, range.offset, range.size);
+		}
 		assert(_renoir_gl450_check());
 		break;
 	}
 	case RENOIR_COMMAND_KIND_TEXTURE_BIND:
 	{
 		auto h = command->texture_bind.handle;
-		glActiveTexture(GL_TEXTURE0 + command->texture_bind.slot);
+		auto slot = command->texture_bind.slot;
 		if (command->texture_bind.sampler == nullptr)
 		{
 			auto gl_format = _renoir_pixelformat_to_gl_compute(h->texture.desc.pixel_format);
@@ -2581,7 +4597,7 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 				layered = GL_TRUE;
 
 			glBindImageTexture(
-				command->texture_bind.slot,
+				slot,
 				h->texture.id,
 				0,
 				layered,
@@ -2592,107 +4608,197 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		}
 		else
 		{
-			if (h->texture.desc.size.height == 0 && h->texture.desc.size.depth == 0)
-			{
-				// 1D texture
-				glBindTexture(GL_TEXTURE_1D, h->texture.id);
-			}
-			else if (h->texture.desc.size.height > 0 && h->texture.desc.size.depth == 0)
-			{
-				if (h->texture.desc.cube_map == false)
-				{
-					// 2D texture
-					glBindTexture(GL_TEXTURE_2D, h->texture.id);
-				}
-				else
-				{
-					glBindTexture(GL_TEXTURE_CUBE_MAP, h->texture.id);
-				}
-			}
-			else if (h->texture.desc.size.height > 0 && h->texture.desc.size.depth > 0)
-			{
-				// 3D texture
-				glBindTexture(GL_TEXTURE_3D, h->texture.id);
-			}
+			// binds the texture to the unit using its own target (1D, 2D, cube map, or 3D) without touching the active texture
+			auto sampler_id = command->texture_bind.sampler->sampler.id;
+			if (slot >= RENOIR_GL450_SHADOW_SLOTS_SIZE || _renoir_gl450_shadow_set(self, self->shadow.textures[slot], h->texture.id))
+				glBindTextureUnit(slot, h->texture.id);
 			// bind the used sampler
-			glBindSampler(command->texture_bind.slot, command->texture_bind.sampler->sampler.id);
+			if (slot >= RENOIR_GL450_SHADOW_SLOTS_SIZE || _renoir_gl450_shadow_set(self, self->shadow.samplers[slot], sampler_id))
+				glBindSampler(slot, sampler_id);
+		}
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TEXTURES_BIND:
+	{
+		auto& desc = command->textures_bind;
+		GLuint textures[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		GLuint samplers[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		for (int i = 0; i < desc.count; ++i)
+		{
+			textures[i] = desc.bindings[i].texture->texture.id;
+			samplers[i] = desc.bindings[i].sampler->sampler.id;
+		}
+		if (_renoir_gl450_shadow_set_range(self, self->shadow.textures, desc.first_slot, textures, desc.count))
+			glBindTextures(desc.first_slot, desc.count, textures);
+		if (_renoir_gl450_shadow_set_range(self, self->shadow.samplers, desc.first_slot, samplers, desc.count))
+			glBindSamplers(desc.first_slot, desc.count, samplers);
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_BUFFERS_BIND:
+	{
+		auto& desc = command->buffers_bind;
+		GLuint buffers[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		GLintptr offsets[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		GLsizeiptr sizes[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		Renoir_GL450_Shadow_Buffer_Range ranges[RENOIR_CONSTANT_MULTI_BIND_SIZE];
+		for (int i = 0; i < desc.count; ++i)
+		{
+			desc.handles[i]->buffer.version_used = true;
+			buffers[i] = desc.handles[i]->buffer.id;
+			offsets[i] = GLintptr(_renoir_gl450_buffer_offset(desc.handles[i]));
+			sizes[i] = GLsizeiptr(desc.handles[i]->buffer.size);
+			ranges[i] = Renoir_GL450_Shadow_Buffer_Range{buffers[i], offsets[i], sizes[i]};
 		}
+		if (_renoir_gl450_shadow_set_range(self, self->shadow.uniform_buffers, desc.first_slot, ranges, desc.count))
+			glBindBuffersRange(GL_UNIFORM_BUFFER, desc.first_slot, desc.count, buffers, offsets, sizes);
 		assert(_renoir_gl450_check());
 		break;
 	}
 	case RENOIR_COMMAND_KIND_DRAW:
 	{
-		assert(self->current_pipeline && self->current_program && "you should use a program and a pipeline before drawing");
-
-		auto& desc = command->draw.desc;
-		glBindVertexArray(self->vao);
+		assert(self->current_program && "you should use a program before drawing");
 
-		for (size_t i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+		auto& desc = command->draw;
+		if (_renoir_gl450_draw_batch_mergeable(self, command))
 		{
-			auto& vertex = desc.vertex_buffers[i];
-			if (vertex.buffer.handle == nullptr)
-				continue;
-
-			// calculate the default stride for the vertex buffer
-			if (vertex.stride == 0)
-				vertex.stride = _renoir_type_to_size(vertex.type);
-
-			auto h = (Renoir_Handle*)vertex.buffer.handle;
-
-			glBindBuffer(GL_ARRAY_BUFFER, h->buffer.id);
-
-			GLint gl_size = _renoir_type_to_gl_element_count(vertex.type);
-			GLenum gl_type = _renoir_type_to_gl(vertex.type);
-			bool gl_normalized = _renoir_type_normalized(vertex.type);
-			glVertexAttribPointer(
-				GLuint(i),
-				gl_size,
-				gl_type,
-				gl_normalized,
-				vertex.stride,
-				(void*)vertex.offset
-			);
-			glEnableVertexAttribArray(i);
+			mn::buf_push(self->draw_batch_firsts, GLint(desc.base_element));
+			mn::buf_push(self->draw_batch_counts, GLsizei(desc.elements_count));
+			mn::buf_push(self->draw_batch_base_vertices, GLint(desc.base_vertex));
+			break;
 		}
+		_renoir_gl450_draw_batch_flush(self);
+
+		_renoir_gl450_draw_buffers_bind(self, desc.vertex_buffers, desc.vertex_buffers_count, desc.index_buffer);
 
 		auto gl_primitive = _renoir_primitive_to_gl(desc.primitive);
-		if (desc.index_buffer.handle != nullptr)
+		// instanced draws are issued directly, the rest start a new batch which the following draws can merge into
+		if (desc.instances_count > 1 || desc.base_instance != 0)
 		{
-			if (desc.index_type == RENOIR_TYPE_NONE)
-				desc.index_type = RENOIR_TYPE_UINT16;
+			auto instances_count = desc.instances_count > 1 ? desc.instances_count : 1;
+			if (desc.index_buffer.handle != nullptr)
+			{
+				auto index_type = desc.index_type == RENOIR_TYPE_NONE ? RENOIR_TYPE_UINT16 : desc.index_type;
+				glDrawElementsInstancedBaseVertexBaseInstance(
+					gl_primitive,
+					desc.elements_count,
+					_renoir_type_to_gl(index_type),
+					(void*)(_renoir_gl450_buffer_offset((Renoir_Handle*)desc.index_buffer.handle) + desc.index_offset + desc.base_element * _renoir_type_to_size(index_type)),
+					instances_count,
+					desc.base_vertex,
+					GLuint(desc.base_instance)
+				);
+			}
+			else
+			{
+				glDrawArraysInstancedBaseInstance(gl_primitive, desc.base_element, desc.elements_count, instances_count, GLuint(desc.base_instance));
+			}
+			assert(_renoir_gl450_check());
+		}
+		else
+		{
+			self->draw_batch = command;
+			mn::buf_push(self->draw_batch_firsts, GLint(desc.base_element));
+			mn::buf_push(self->draw_batch_counts, GLsizei(desc.elements_count));
+			mn::buf_push(self->draw_batch_base_vertices, GLint(desc.base_vertex));
+		}
+		break;
+	}
+	case RENOIR_COMMAND_KIND_DRAW_BATCH:
+	{
+		assert(self->current_program && "you should use a program before drawing");
 
-			auto gl_index_type = _renoir_type_to_gl(desc.index_type);
-			auto gl_index_type_size = _renoir_type_to_size(desc.index_type);
+		auto& desc = command->draw_batch;
+		_renoir_gl450_draw_buffers_bind(self, desc.vertex_buffers, desc.vertex_buffers_count, desc.index_buffer);
 
-			auto h = (Renoir_Handle*)desc.index_buffer.handle;
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, h->buffer.id);
+		auto gl_primitive = _renoir_primitive_to_gl(desc.primitive);
+		auto index_type = desc.index_type == RENOIR_TYPE_NONE ? RENOIR_TYPE_UINT16 : desc.index_type;
+		for (size_t i = 0; i < desc.ranges_count; ++i)
+		{
+			const auto& range = desc.ranges[i];
+			if (range.instances_count <= 1 && range.base_instance == 0)
+			{
+				mn::buf_push(self->draw_batch_firsts, GLint(range.base_element));
+				mn::buf_push(self->draw_batch_counts, GLsizei(range.elements_count));
+				mn::buf_push(self->draw_batch_base_vertices, GLint(range.base_vertex));
+				continue;
+			}
 
-			if (desc.instances_count > 1)
+			// instanced ranges are issued directly, the ranges before them are issued first to keep the order
+			_renoir_gl450_draw_batch_issue(self, desc.primitive, desc.index_buffer, desc.index_type, desc.index_offset);
+			if (desc.index_buffer.handle != nullptr)
 			{
-				glDrawElementsInstanced(
+				glDrawElementsInstancedBaseVertexBaseInstance(
 					gl_primitive,
-					desc.elements_count,
-					gl_index_type,
-					(void*)(desc.base_element * gl_index_type_size),
-					desc.instances_count
+					range.elements_count,
+					_renoir_type_to_gl(index_type),
+					(void*)(_renoir_gl450_buffer_offset((Renoir_Handle*)desc.index_buffer.handle) + desc.index_offset + range.base_element * _renoir_type_to_size(index_type)),
+					range.instances_count > 1 ? range.instances_count : 1,
+					range.base_vertex,
+					GLuint(range.base_instance)
 				);
 			}
 			else
 			{
-				glDrawElements(
+				glDrawArraysInstancedBaseInstance(
 					gl_primitive,
-					desc.elements_count,
-					gl_index_type,
-					(void*)(desc.base_element * gl_index_type_size)
+					range.base_element,
+					range.elements_count,
+					range.instances_count > 1 ? range.instances_count : 1,
+					GLuint(range.base_instance)
 				);
 			}
+			assert(_renoir_gl450_check());
+		}
+		_renoir_gl450_draw_batch_issue(self, desc.primitive, desc.index_buffer, desc.index_type, desc.index_offset);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_DRAW_INDIRECT:
+	{
+		assert(self->current_program && "you should use a program before drawing");
+
+		auto& desc = command->draw_indirect;
+		// the first index of the indirect arguments is relative to the start of the index buffer
+		assert(
+			(desc.index_buffer.handle == nullptr || _renoir_gl450_buffer_offset((Renoir_Handle*)desc.index_buffer.handle) == 0) &&
+			"indirect draws can't use a dynamic or transient index buffer"
+		);
+		_renoir_gl450_draw_buffers_bind(self, desc.vertex_buffers, desc.vertex_buffers_count, desc.index_buffer);
+
+		auto& shadow = self->shadow;
+		if (_renoir_gl450_shadow_set(self, shadow.draw_indirect_buffer, desc.buffer->buffer.id))
+			glBindBuffer(GL_DRAW_INDIRECT_BUFFER, desc.buffer->buffer.id);
+
+		if (desc.count_buffer)
+		{
+			if (GLEW_ARB_indirect_parameters == false)
+			{
+				mn::log_error("gl450: multi_draw_indirect_count requires GL_ARB_indirect_parameters");
+				break;
+			}
+
+			if (_renoir_gl450_shadow_set(self, shadow.parameter_buffer, desc.count_buffer->buffer.id))
+				glBindBuffer(GL_PARAMETER_BUFFER_ARB, desc.count_buffer->buffer.id);
+		}
+
+		auto gl_primitive = _renoir_primitive_to_gl(desc.primitive);
+		if (desc.index_buffer.handle != nullptr)
+		{
+			auto gl_index_type = _renoir_type_to_gl(desc.index_type);
+			auto stride = desc.stride != 0 ? desc.stride : sizeof(Renoir_Draw_Indexed_Indirect_Args);
+			if (desc.count_buffer)
+				glMultiDrawElementsIndirectCountARB(gl_primitive, gl_index_type, (void*)desc.offset, GLintptr(desc.count_offset), desc.draws_count, GLsizei(stride));
+			else
+				glMultiDrawElementsIndirect(gl_primitive, gl_index_type, (void*)desc.offset, desc.draws_count, GLsizei(stride));
 		}
 		else
 		{
-			if (desc.instances_count > 1)
-				glDrawArraysInstanced(gl_primitive, desc.base_element, desc.elements_count, desc.instances_count);
+			auto stride = desc.stride != 0 ? desc.stride : sizeof(Renoir_Draw_Indirect_Args);
+			if (desc.count_buffer)
+				glMultiDrawArraysIndirectCountARB(gl_primitive, (void*)desc.offset, GLintptr(desc.count_offset), desc.draws_count, GLsizei(stride));
 			else
-				glDrawArrays(gl_primitive, desc.base_element, desc.elements_count);
+				glMultiDrawArraysIndirect(gl_primitive, (void*)desc.offset, desc.draws_count, GLsizei(stride));
 		}
 		assert(_renoir_gl450_check());
 		break;
@@ -2706,6 +4812,18 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		assert(_renoir_gl450_check());
 		break;
 	}
+	case RENOIR_COMMAND_KIND_DISPATCH_INDIRECT:
+	{
+		assert(self->current_compute && "you should use a compute before dispatching it");
+		auto hbuffer = command->dispatch_indirect.buffer;
+		if (_renoir_gl450_shadow_set(self, self->shadow.dispatch_indirect_buffer, hbuffer->buffer.id))
+			glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, hbuffer->buffer.id);
+		glDispatchComputeIndirect(GLintptr(command->dispatch_indirect.offset));
+		// same as dispatch, this barrier also makes the writes visible to later indirect commands
+		glMemoryBarrier(GL_ALL_BARRIER_BITS);
+		assert(_renoir_gl450_check());
+		break;
+	}
 	case RENOIR_COMMAND_KIND_TIMER_BEGIN:
 	{
 		auto h = command->timer_begin.handle;
@@ -2720,6 +4838,26 @@ _renoir_gl450_command_execute(IRenoir* self, Renoir_Command* command)
 		assert(_renoir_gl450_check());
 		break;
 	}
+	case RENOIR_COMMAND_KIND_FENCE_INSERT:
+	{
+		auto h = command->fence_insert.handle;
+		// the new insert supersedes the old one
+		if (h->fence.sync)
+			glDeleteSync(h->fence.sync);
+		h->fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		h->fence.sync_generation = command->fence_insert.generation;
+		assert(_renoir_gl450_check());
+		break;
+	}
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE:
+	{
+		// replay the bundle commands, they are owned by the bundle so we don't free them here
+		auto h = command->bundle_execute.handle;
+		_renoir_gl450_command_stream_for_each(h->bundle.command_stream, [self](Renoir_Command* it) {
+			_renoir_gl450_command_execute(self, it);
+		});
+		break;
+	}
 	default:
 		assert(false && "unreachable");
 		break;
@@ -2822,6 +4960,147 @@ _renoir_gl450_sampler_get(IRenoir* self, Renoir_Sampler_Desc desc)
 	return sampler;
 }
 
+// zeroes the fields which don't affect the gl state so that equivalent descs compare and hash the same
+inline static Renoir_Pipeline_Desc
+_renoir_gl450_pipeline_desc_normalize(const Renoir_Pipeline_Desc& desc)
+{
+	Renoir_Pipeline_Desc res{};
+	res.rasterizer.cull = desc.rasterizer.cull;
+	if (desc.rasterizer.cull == RENOIR_SWITCH_ENABLE)
+	{
+		res.rasterizer.cull_face = desc.rasterizer.cull_face;
+		res.rasterizer.cull_front = desc.rasterizer.cull_front;
+	}
+	res.rasterizer.scissor = desc.rasterizer.scissor;
+	res.depth_stencil = desc.depth_stencil;
+	res.independent_blend = desc.independent_blend;
+
+	for (int i = 0; i < RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE; ++i)
+	{
+		if (desc.blend[i].enabled == RENOIR_SWITCH_ENABLE)
+			res.blend[i] = desc.blend[i];
+		else
+			res.blend[i].enabled = desc.blend[i].enabled;
+		res.blend[i].color_mask = desc.blend[i].color_mask == RENOIR_COLOR_MASK_NONE ? 0 : (desc.blend[i].color_mask & RENOIR_COLOR_MASK_ALL);
+
+		if (desc.independent_blend == RENOIR_SWITCH_DISABLE)
+			break;
+	}
+	return res;
+}
+
+// fnv-1a over the normalized desc, it has no padding since all of its fields are enums/ints
+inline static uint64_t
+_renoir_gl450_pipeline_desc_hash(const Renoir_Pipeline_Desc& desc)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	auto bytes = (const uint8_t*)&desc;
+	for (size_t i = 0; i < sizeof(desc); ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+inline static Renoir_Handle*
+_renoir_gl450_pipeline_new(IRenoir* self, const Renoir_Pipeline_Desc& desc, uint64_t hash)
+{
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_PIPELINE);
+	h->pipeline.desc = desc;
+	h->pipeline.hash = hash;
+	if (desc.rasterizer.cull == RENOIR_SWITCH_ENABLE)
+	{
+		h->pipeline.gl_cull_face = _renoir_face_to_gl(desc.rasterizer.cull_face);
+		h->pipeline.gl_cull_front = _renoir_orientation_to_gl(desc.rasterizer.cull_front);
+	}
+	for (int i = 0; i < RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE; ++i)
+	{
+		auto& blend = desc.blend[i];
+		h->pipeline.color_mask[i] = blend.color_mask;
+		if (blend.enabled == RENOIR_SWITCH_ENABLE)
+		{
+			h->pipeline.gl_blend_func[i][0] = _renoir_blend_to_gl(blend.src_rgb);
+			h->pipeline.gl_blend_func[i][1] = _renoir_blend_to_gl(blend.dst_rgb);
+			h->pipeline.gl_blend_func[i][2] = _renoir_blend_to_gl(blend.src_alpha);
+			h->pipeline.gl_blend_func[i][3] = _renoir_blend_to_gl(blend.dst_alpha);
+			h->pipeline.gl_blend_eq[i][0] = _renoir_blend_eq_to_gl(blend.eq_rgb);
+			h->pipeline.gl_blend_eq[i][1] = _renoir_blend_eq_to_gl(blend.eq_alpha);
+		}
+
+		if (desc.independent_blend == RENOIR_SWITCH_DISABLE)
+			break;
+	}
+	return h;
+}
+
+// same lru policy as the sampler cache, but the entries are compared by hash first, should be called while holding the mutex
+inline static Renoir_Handle*
+_renoir_gl450_pipeline_get(IRenoir* self, const Renoir_Pipeline_Desc& pipeline_desc)
+{
+	auto desc = _renoir_gl450_pipeline_desc_normalize(pipeline_desc);
+	auto hash = _renoir_gl450_pipeline_desc_hash(desc);
+
+	size_t best_ix = self->pipeline_cache.count;
+	size_t first_empty_ix = self->pipeline_cache.count;
+	for (size_t i = 0; i < self->pipeline_cache.count; ++i)
+	{
+		auto hpipeline = self->pipeline_cache[i];
+		if (hpipeline == nullptr)
+		{
+			if (first_empty_ix == self->pipeline_cache.count)
+				first_empty_ix = i;
+			continue;
+		}
+
+		if (hpipeline->pipeline.hash == hash && ::memcmp(&hpipeline->pipeline.desc, &desc, sizeof(desc)) == 0)
+		{
+			best_ix = i;
+			break;
+		}
+	}
+
+	// we found what we were looking for
+	if (best_ix < self->pipeline_cache.count)
+	{
+		auto res = self->pipeline_cache[best_ix];
+		// reorder the cache
+		for (size_t i = 0; i < best_ix; ++i)
+		{
+			auto index = best_ix - i - 1;
+			self->pipeline_cache[index + 1] = self->pipeline_cache[index];
+		}
+		self->pipeline_cache[0] = res;
+		self->pipeline_cache_hits += 1;
+		return res;
+	}
+
+	// we didn't find a matching pipeline, so create new one
+	self->pipeline_cache_misses += 1;
+	size_t pipeline_ix = first_empty_ix;
+
+	// we didn't find an empty slot for the new pipeline so we'll have to make one for it
+	if (pipeline_ix == self->pipeline_cache.count)
+	{
+		auto to_be_evicted = mn::buf_top(self->pipeline_cache);
+		for (size_t i = 0; i + 1 < self->pipeline_cache.count; ++i)
+		{
+			auto index = self->pipeline_cache.count - i - 1;
+			self->pipeline_cache[index] = self->pipeline_cache[index - 1];
+		}
+		// recorded commands which use the evicted pipeline keep it alive until they're freed
+		_renoir_gl450_pipeline_release(self, to_be_evicted);
+		self->pipeline_cache_evictions += 1;
+		mn::log_warning("gl450: pipeline evicted");
+		pipeline_ix = 0;
+	}
+
+	// create the new pipeline and put it at the head of the cache
+	auto pipeline = _renoir_gl450_pipeline_new(self, desc, hash);
+	self->pipeline_cache[pipeline_ix] = pipeline;
+	return pipeline;
+}
+
 inline static void
 _renoir_gl450_handle_leak_free(IRenoir* self, Renoir_Command* command)
 {
@@ -2842,6 +5121,8 @@ _renoir_gl450_handle_leak_free(IRenoir* self, Renoir_Command* command)
 			break;
 		if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
 		{
+			_renoir_gl450_draw_sort_free(h->raster_pass.draw_sort);
+
 			// free all the bound textures if it's a framebuffer pass
 			if (h->raster_pass.swapchain == nullptr)
 			{
@@ -2852,21 +5133,39 @@ _renoir_gl450_handle_leak_free(IRenoir* self, Renoir_Command* command)
 						continue;
 
 					// issue command to free the color texture
-					auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
-					command->texture_free.handle = color;
-					_renoir_gl450_handle_leak_free(self, command);
+					Renoir_Command command{};
+					command.kind = RENOIR_COMMAND_KIND_TEXTURE_FREE;
+					command.texture_free.handle = color;
+					_renoir_gl450_handle_leak_free(self, &command);
 				}
 
 				auto depth = (Renoir_Handle*)h->raster_pass.offscreen.depth_stencil.texture.handle;
 				if (depth)
 				{
 					// issue command to free the depth texture
-					auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
-					command->texture_free.handle = depth;
-					_renoir_gl450_handle_leak_free(self, command);
+					Renoir_Command command{};
+					command.kind = RENOIR_COMMAND_KIND_TEXTURE_FREE;
+					command.texture_free.handle = depth;
+					_renoir_gl450_handle_leak_free(self, &command);
 				}
 			}
 		}
+		else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		{
+			_renoir_gl450_command_stream_for_each(h->bundle.command_stream, [self, h](Renoir_Command* it) {
+				// release the handles which the bundle kept alive
+				if (h->bundle.recorded)
+				{
+					Renoir_Handle* handles[RENOIR_GL450_COMMAND_HANDLES_SIZE];
+					auto handles_count = _renoir_gl450_command_handles(it, handles);
+					for (size_t i = 0; i < handles_count; ++i)
+						if (_renoir_gl450_handle_unref(handles[i]))
+							_renoir_gl450_handle_free(self, handles[i]);
+				}
+				_renoir_gl450_handle_leak_free(self, it);
+			});
+			_renoir_gl450_command_stream_release(self, h->bundle.command_stream);
+		}
 		_renoir_gl450_handle_free(self, h);
 		break;
 	}
@@ -2902,23 +5201,132 @@ _renoir_gl450_handle_leak_free(IRenoir* self, Renoir_Command* command)
 		_renoir_gl450_handle_free(self, h);
 		break;
 	}
-	case RENOIR_COMMAND_KIND_COMPUTE_FREE:
+	case RENOIR_COMMAND_KIND_COMPUTE_FREE:
+	{
+		auto h = command->compute_free.handle;
+		if (_renoir_gl450_handle_unref(h) == false)
+			break;
+		_renoir_gl450_handle_free(self, h);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_TIMER_FREE:
+	{
+		auto h = command->timer_free.handle;
+		if (_renoir_gl450_handle_unref(h) == false)
+			break;
+		_renoir_gl450_handle_free(self, h);
+		break;
+	}
+	case RENOIR_COMMAND_KIND_READBACK_FREE:
 	{
-		auto h = command->compute_free.handle;
+		auto h = command->readback_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
 		_renoir_gl450_handle_free(self, h);
 		break;
 	}
-	case RENOIR_COMMAND_KIND_TIMER_FREE:
+	case RENOIR_COMMAND_KIND_FENCE_FREE:
 	{
-		auto h = command->timer_free.handle;
+		auto h = command->fence_free.handle;
 		if (_renoir_gl450_handle_unref(h) == false)
 			break;
 		_renoir_gl450_handle_free(self, h);
 		break;
 	}
+	case RENOIR_COMMAND_KIND_BUNDLE_EXECUTE:
+	{
+		// release the reference which the command took on the bundle
+		Renoir_Command command_free{};
+		command_free.kind = RENOIR_COMMAND_KIND_PASS_FREE;
+		command_free.pass_free.handle = command->bundle_execute.handle;
+		_renoir_gl450_handle_leak_free(self, &command_free);
+		break;
+	}
+	}
+}
+
+static void
+_renoir_gl450_render_thread_main(void* arg)
+{
+	auto self = (IRenoir*)arg;
+	_renoir_gl450_on_render_thread = true;
+
+	mn::mutex_lock(self->mtx);
+	while (true)
+	{
+		while (self->render_thread_queue_count == 0 && self->render_thread_sync_command == nullptr && self->render_thread_exit == false)
+			mn::cond_var_wait(self->render_thread_cv, self->mtx);
+
+		if (self->render_thread_queue_count > 0)
+		{
+			auto frame = self->render_thread_queue[self->render_thread_queue_head];
+
+			// execute the frame without holding the mutex so that the recording of the next frame can proceed
+			mn::mutex_unlock(self->mtx);
+			_renoir_gl450_command_stream_execute(self, frame.command_stream);
+			_renoir_gl450_command_stream_release(self, frame.command_stream);
+			if (frame.swapchain)
+				renoir_gl450_context_window_present(self->ctx, frame.swapchain);
+			// the frame fence may wait on the gpu so it's done before taking the mutex
+			_renoir_gl450_frame_end(self);
+			mn::mutex_lock(self->mtx);
+
+			_renoir_gl450_frame_stats_end(self);
+			self->render_thread_queue_head = (self->render_thread_queue_head + 1) % self->render_thread_queue.count;
+			self->render_thread_queue_count -= 1;
+			mn::cond_var_notify_all(self->render_thread_cv);
+		}
+		// sync commands are only executed after all the queued frames, so they see the result of all the previous frames
+		else if (self->render_thread_sync_command != nullptr)
+		{
+			auto command = self->render_thread_sync_command;
+			mn::mutex_unlock(self->mtx);
+			_renoir_gl450_command_execute(self, command);
+			mn::mutex_lock(self->mtx);
+
+			self->render_thread_sync_command = nullptr;
+			mn::cond_var_notify_all(self->render_thread_cv);
+		}
+		else if (self->render_thread_exit)
+		{
+			break;
+		}
 	}
+	mn::mutex_unlock(self->mtx);
+
+	// the context is freed on the thread which calls dispose
+	renoir_gl450_context_unbind(self->ctx);
+}
+
+// queues the global command stream to the render thread, it only blocks if the queue is full,
+// should be called while holding the mutex
+static void
+_renoir_gl450_render_thread_push(IRenoir* self, Renoir_Handle* swapchain)
+{
+	while (self->render_thread_queue_count == self->render_thread_queue.count)
+		mn::cond_var_wait(self->render_thread_cv, self->mtx);
+
+	auto index = (self->render_thread_queue_head + self->render_thread_queue_count) % self->render_thread_queue.count;
+	self->render_thread_queue[index].command_stream = self->command_stream;
+	self->render_thread_queue[index].swapchain = swapchain;
+	self->render_thread_queue_count += 1;
+	self->command_stream = Renoir_Command_Stream{};
+	mn::cond_var_notify_all(self->render_thread_cv);
+}
+
+// executes the command on the render thread and waits for it, should be called while holding the mutex
+static void
+_renoir_gl450_render_thread_execute_sync(IRenoir* self, Renoir_Command* command)
+{
+	// only one sync command can be in flight
+	while (self->render_thread_sync_command != nullptr)
+		mn::cond_var_wait(self->render_thread_cv, self->mtx);
+
+	self->render_thread_sync_command = command;
+	mn::cond_var_notify_all(self->render_thread_cv);
+
+	while (self->render_thread_sync_command == command)
+		mn::cond_var_wait(self->render_thread_cv, self->mtx);
 }
 
 // API
@@ -2932,28 +5340,82 @@ _renoir_gl450_init(Renoir* api, Renoir_Settings settings, void* display)
 		settings.sampler_cache_size = RENOIR_CONSTANT_DEFAULT_SAMPLER_CACHE_SIZE;
 	if (settings.pipeline_cache_size <= 0)
 		settings.pipeline_cache_size = RENOIR_CONSTANT_DEFAULT_PIPELINE_CACHE_SIZE;
+	if (settings.render_thread_queue_size <= 0)
+		settings.render_thread_queue_size = RENOIR_CONSTANT_DEFAULT_RENDER_THREAD_QUEUE_SIZE;
+	if (settings.transient_buffer_size == 0)
+		settings.transient_buffer_size = RENOIR_CONSTANT_DEFAULT_TRANSIENT_BUFFER_SIZE;
+	// the frame fences ring only holds RENOIR_GL450_BUFFER_SLICES_COUNT frames
+	static_assert(RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT <= RENOIR_GL450_BUFFER_SLICES_COUNT, "frames in flight should fit in the frame fences");
+	if (settings.max_frames_in_flight <= 0)
+		settings.max_frames_in_flight = RENOIR_CONSTANT_DEFAULT_MAX_FRAMES_IN_FLIGHT;
+	if (settings.max_frames_in_flight > RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT)
+		settings.max_frames_in_flight = RENOIR_CONSTANT_MAX_FRAMES_IN_FLIGHT;
+
+	if (settings.render_thread)
+	{
+		if (settings.external_context)
+		{
+			mn::log_warning("render thread is not supported with external context, it will be disabled");
+			settings.render_thread = false;
+		}
+		else
+		{
+			// the render thread executes the deferred commands
+			settings.defer_api_calls = true;
+		}
+	}
 
 	auto ctx = renoir_gl450_context_new(&settings, display);
 	if (ctx == nullptr && settings.external_context == false)
 		return false;
 
+	// the context is created current on this thread, so we release it to be bound on the render thread
+	if (settings.render_thread)
+		renoir_gl450_context_unbind(ctx);
+
 	auto self = mn::alloc_zerod<IRenoir>();
 	self->mtx = mn::mutex_new("renoir gl450");
+	self->command_page_mtx = mn::mutex_new("renoir gl450 command pages");
 	self->handle_pool = mn::pool_new(sizeof(Renoir_Handle), 128);
-	self->command_pool = mn::pool_new(sizeof(Renoir_Command), 128);
 	self->settings = settings;
 	self->ctx = ctx;
 	self->sampler_cache = mn::buf_new<Renoir_Handle*>();
+	self->vertex_arrays = mn::buf_new<Renoir_GL450_Vertex_Array>();
+	self->draw_batch_firsts = mn::buf_new<GLint>();
+	self->draw_batch_counts = mn::buf_new<GLsizei>();
+	self->draw_batch_base_vertices = mn::buf_new<GLint>();
+	self->draw_batch_offsets = mn::buf_new<const void*>();
+	self->staging_pool = mn::buf_new<Renoir_GL450_Staging_Buffer>();
 	self->alive_handles = mn::map_new<Renoir_Handle*, Renoir_Leak_Info>();
 	mn::buf_resize_fill(self->sampler_cache, self->settings.sampler_cache_size, nullptr);
-
-	self->current_pipeline = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_PIPELINE);
-	self->current_pipeline->pipeline.desc = Renoir_Pipeline_Desc{};
-	_renoir_gl450_pipeline_desc_defaults(&self->current_pipeline->pipeline.desc);
+	self->pipeline_cache = mn::buf_new<Renoir_Handle*>();
+	mn::buf_resize_fill(self->pipeline_cache, self->settings.pipeline_cache_size, nullptr);
+
+	// the gl buffer of the transient ring is created by the executor when it's first used
+	self->transient_ring.buffer = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_BUFFER);
+	self->transient_ring.buffer->buffer.type = RENOIR_BUFFER_UNIFORM;
+	self->transient_ring.buffer->buffer.usage = RENOIR_USAGE_DYNAMIC;
+	self->transient_ring.buffer->buffer.access = RENOIR_ACCESS_WRITE;
+	self->transient_ring.buffer->buffer.transient = true;
+	self->unpack_ring.buffer = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_BUFFER);
+	self->unpack_ring.buffer->buffer.usage = RENOIR_USAGE_DYNAMIC;
+	self->unpack_ring.buffer->buffer.access = RENOIR_ACCESS_WRITE;
+	self->rename_ring.buffer = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_BUFFER);
+	self->rename_ring.buffer->buffer.usage = RENOIR_USAGE_DYNAMIC;
+	self->rename_ring.buffer->buffer.access = RENOIR_ACCESS_WRITE;
+	self->spilled_buffers = mn::buf_new<Renoir_Handle*>();
 
 	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_INIT);
 	_renoir_gl450_command_process(self, command);
 
+	if (self->settings.render_thread)
+	{
+		self->render_thread_cv = mn::cond_var_new();
+		self->render_thread_queue = mn::buf_new<Renoir_GL450_Frame>();
+		mn::buf_resize_fill(self->render_thread_queue, self->settings.render_thread_queue_size, Renoir_GL450_Frame{});
+		self->render_thread = mn::thread_new(_renoir_gl450_render_thread_main, self, "renoir gl450 render thread");
+	}
+
 	api->ctx = self;
 
 	return true;
@@ -2963,9 +5425,28 @@ static void
 _renoir_gl450_dispose(Renoir* api)
 {
 	auto self = api->ctx;
+
+	// the render thread executes all the queued frames before it exits
+	if (self->settings.render_thread)
+	{
+		mn::mutex_lock(self->mtx);
+		self->render_thread_exit = true;
+		mn::cond_var_notify_all(self->render_thread_cv);
+		mn::mutex_unlock(self->mtx);
+
+		mn::thread_join(self->render_thread);
+		mn::thread_free(self->render_thread);
+		mn::cond_var_free(self->render_thread_cv);
+		mn::buf_free(self->render_thread_queue);
+	}
+
 	// process these commands for frees to give correct leak report
-	for (auto it = self->command_list_head; it != nullptr; it = it->next)
+	_renoir_gl450_command_stream_for_each(self->command_stream, [self](Renoir_Command* it) {
 		_renoir_gl450_handle_leak_free(self, it);
+	});
+	_renoir_gl450_handle_free(self, self->transient_ring.buffer);
+	_renoir_gl450_handle_free(self, self->unpack_ring.buffer);
+	_renoir_gl450_handle_free(self, self->rename_ring.buffer);
 	#if RENOIR_LEAK
 		for(auto[handle, info]: self->alive_handles)
 		{
@@ -2980,10 +5461,23 @@ _renoir_gl450_dispose(Renoir* api)
 			::fprintf(stderr, "renoir leak count: %zu, for callstack turn on 'RENOIR_LEAK' flag\n", self->alive_handles.count);
 	#endif
 	mn::mutex_free(self->mtx);
+	mn::mutex_free(self->command_page_mtx);
 	renoir_gl450_context_free(self->ctx);
 	mn::pool_free(self->handle_pool);
-	mn::pool_free(self->command_pool);
+	_renoir_gl450_command_page_list_free(self->command_stream.head);
+	_renoir_gl450_command_page_list_free(self->command_page_free_list);
+	_renoir_gl450_upload_block_list_free(self->command_stream.upload_head);
+	_renoir_gl450_upload_block_list_free(self->command_stream.transient_head);
+	_renoir_gl450_upload_block_list_free(self->upload_block_free_list);
 	mn::buf_free(self->sampler_cache);
+	mn::buf_free(self->pipeline_cache);
+	mn::buf_free(self->vertex_arrays);
+	mn::buf_free(self->draw_batch_firsts);
+	mn::buf_free(self->draw_batch_counts);
+	mn::buf_free(self->draw_batch_base_vertices);
+	mn::buf_free(self->draw_batch_offsets);
+	mn::buf_free(self->staging_pool);
+	mn::buf_free(self->spilled_buffers);
 	mn::map_free(self->alive_handles);
 	mn::free(self);
 }
@@ -3015,6 +5509,12 @@ _renoir_gl450_flush(Renoir* api, void*, void*)
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
+	if (self->settings.render_thread)
+	{
+		_renoir_gl450_render_thread_push(self, nullptr);
+		return;
+	}
+
 	if (auto error = glGetError(); error != GL_NO_ERROR)
 	{
 		mn::log_error("external opengl context has error {:#x}", error);
@@ -3023,19 +5523,19 @@ _renoir_gl450_flush(Renoir* api, void*, void*)
 	if (self->glewInited)
 		_renoir_gl450_state_capture(self->state);
 
+	// the gl state could've been changed by the user of the external context since last flush
+	_renoir_gl450_shadow_invalidate(self);
+
 	// process commands
-	for(auto it = self->command_list_head; it != nullptr; it = it->next)
-	{
-		_renoir_gl450_command_execute(self, it);
-		_renoir_gl450_command_free(self, it);
-	}
+	_renoir_gl450_command_stream_execute(self, self->command_stream);
 
 	assert(_renoir_gl450_check());
 
 	_renoir_gl450_state_reset(self->state);
 
-	self->command_list_head = nullptr;
-	self->command_list_tail = nullptr;
+	_renoir_gl450_command_stream_release(self, self->command_stream);
+	_renoir_gl450_frame_end(self);
+	_renoir_gl450_frame_stats_end(self);
 }
 
 static Renoir_Swapchain
@@ -3090,20 +5590,27 @@ _renoir_gl450_swapchain_present(Renoir* api, Renoir_Swapchain swapchain)
 	auto h = (Renoir_Handle*)swapchain.handle;
 	assert(h != nullptr);
 
+	// pacing sleeps without holding the mutex so that the render thread can pop its frames meanwhile
+	_renoir_gl450_frame_pace(self);
+
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	// process commands
-	for(auto it = self->command_list_head; it != nullptr; it = it->next)
+	if (self->settings.render_thread)
 	{
-		_renoir_gl450_command_execute(self, it);
-		_renoir_gl450_command_free(self, it);
+		_renoir_gl450_render_thread_push(self, h);
+		return;
 	}
 
-	self->command_list_head = nullptr;
-	self->command_list_tail = nullptr;
+	// process commands
+	_renoir_gl450_command_stream_execute(self, self->command_stream);
+	_renoir_gl450_command_stream_release(self, self->command_stream);
 
+	// the frame fence is inserted after the swap so that waiting on it also bounds the queued presents,
+	// like the render thread does
 	renoir_gl450_context_window_present(self->ctx, h);
+	_renoir_gl450_frame_end(self);
+	_renoir_gl450_frame_stats_end(self);
 }
 
 static Renoir_Buffer
@@ -3132,566 +5639,1029 @@ _renoir_gl450_buffer_new(Renoir* api, Renoir_Buffer_Desc desc)
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_BUFFER);
-	h->buffer.access = desc.access;
-	h->buffer.type = desc.type;
-	h->buffer.usage = desc.usage;
-	h->buffer.size = desc.data_size;
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_BUFFER);
+	h->buffer.access = desc.access;
+	h->buffer.type = desc.type;
+	h->buffer.usage = desc.usage;
+	h->buffer.size = desc.data_size;
+
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_NEW);
+	command->buffer_new.handle = h;
+	command->buffer_new.desc = desc;
+	if (self->settings.defer_api_calls)
+	{
+		if (desc.data)
+		{
+			command->buffer_new.desc.data = mn::alloc(desc.data_size, alignof(char)).ptr;
+			::memcpy(command->buffer_new.desc.data, desc.data, desc.data_size);
+			command->buffer_new.owns_data = true;
+		}
+	}
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Buffer{h};
+}
+
+static void
+_renoir_gl450_buffer_free(Renoir* api, Renoir_Buffer buffer)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)buffer.handle;
+	assert(h != nullptr);
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_FREE);
+	command->buffer_free.handle = h;
+	_renoir_gl450_command_process(self, command);
+}
+
+static size_t
+_renoir_gl450_buffer_size(Renoir* api, Renoir_Buffer buffer)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)buffer.handle;
+	assert(h != nullptr && h->kind == RENOIR_HANDLE_KIND_BUFFER);
+
+	return h->buffer.size;
+}
+
+static Renoir_Texture
+_renoir_gl450_texture_new(Renoir* api, Renoir_Texture_Desc desc)
+{
+	assert(desc.size.width > 0 && "a texture must have at least width");
+
+	if (desc.usage == RENOIR_USAGE_NONE)
+		desc.usage = RENOIR_USAGE_STATIC;
+
+	if (desc.mipmaps == 0)
+		desc.mipmaps = 1;
+
+	if (desc.usage == RENOIR_USAGE_DYNAMIC && desc.access == RENOIR_ACCESS_NONE)
+	{
+		assert(false && "a dynamic texture with cpu access set to none is a static texture");
+	}
+
+	if (desc.render_target == false && desc.usage == RENOIR_USAGE_STATIC && desc.data == nullptr)
+	{
+		assert(false && "a static texture should have data to initialize it");
+	}
+
+	if (desc.cube_map)
+	{
+		assert(desc.size.width == desc.size.height && "width should equal height in cube map texture");
+	}
+
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_TEXTURE);
+	h->texture.desc = desc;
+	::memset(h->texture.desc.data, 0, sizeof(h->texture.desc.data));
+	h->texture.desc.data_size = 0;
+
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_NEW);
+	command->texture_new.handle = h;
+	command->texture_new.desc = desc;
+	if (self->settings.defer_api_calls)
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			if (desc.data[i] == nullptr)
+				continue;
+
+			command->texture_new.desc.data[i] = mn::alloc(desc.data_size, alignof(char)).ptr;
+			::memcpy(command->texture_new.desc.data[i], desc.data[i], desc.data_size);
+			command->texture_new.owns_data = true;
+		}
+	}
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Texture{h};
+}
+
+static void
+_renoir_gl450_texture_free(Renoir* api, Renoir_Texture texture)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)texture.handle;
+	assert(h != nullptr);
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
+	command->texture_free.handle = h;
+	_renoir_gl450_command_process(self, command);
+}
+
+static void*
+_renoir_gl450_texture_native_handle(Renoir* api, Renoir_Texture texture)
+{
+	auto h = (Renoir_Handle*)texture.handle;
+	assert(h != nullptr);
+	return (void*)h->texture.id;
+}
+
+static Renoir_Size
+_renoir_gl450_texture_size(Renoir* api, Renoir_Texture texture)
+{
+	auto h = (Renoir_Handle*)texture.handle;
+	assert(h != nullptr && h->kind == RENOIR_HANDLE_KIND_TEXTURE);
+	return h->texture.desc.size;
+}
+
+static Renoir_Texture_Desc
+_renoir_gl450_texture_desc(Renoir* api, Renoir_Texture texture)
+{
+	auto h = (Renoir_Handle*)texture.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_TEXTURE);
+	return h->texture.desc;
+}
+
+static Renoir_Program
+_renoir_gl450_program_new(Renoir* api, Renoir_Program_Desc desc)
+{
+	assert(desc.vertex.bytes != nullptr && desc.pixel.bytes != nullptr);
+	if (desc.vertex.size == 0)
+		desc.vertex.size = ::strlen(desc.vertex.bytes);
+	if (desc.pixel.size == 0)
+		desc.pixel.size = ::strlen(desc.pixel.bytes);
+	if (desc.geometry.bytes != nullptr && desc.geometry.size == 0)
+		desc.geometry.size = ::strlen(desc.geometry.bytes);
+
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_PROGRAM);
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PROGRAM_NEW);
+	command->program_new.handle = h;
+	command->program_new.desc = desc;
+	if (self->settings.defer_api_calls)
+	{
+		command->program_new.desc.vertex.bytes = (char*)mn::alloc(command->program_new.desc.vertex.size, alignof(char)).ptr;
+		::memcpy((char*)command->program_new.desc.vertex.bytes, desc.vertex.bytes, desc.vertex.size);
+
+		command->program_new.desc.pixel.bytes = (char*)mn::alloc(command->program_new.desc.pixel.size, alignof(char)).ptr;
+		::memcpy((char*)command->program_new.desc.pixel.bytes, desc.pixel.bytes, desc.pixel.size);
+
+		if (command->program_new.desc.geometry.bytes != nullptr)
+		{
+			command->program_new.desc.geometry.bytes = (char*)mn::alloc(command->program_new.desc.geometry.size, alignof(char)).ptr;
+			::memcpy((char*)command->program_new.desc.geometry.bytes, desc.geometry.bytes, desc.geometry.size);
+		}
+
+		command->program_new.owns_data = true;
+	}
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Program{h};
+}
+
+static void
+_renoir_gl450_program_free(Renoir* api, Renoir_Program program)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)program.handle;
+	assert(h != nullptr);
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PROGRAM_FREE);
+	command->program_free.handle = h;
+	_renoir_gl450_command_process(self, command);
+}
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_NEW);
-	command->buffer_new.handle = h;
-	command->buffer_new.desc = desc;
+static Renoir_Compute
+_renoir_gl450_compute_new(Renoir* api, Renoir_Compute_Desc desc)
+{
+	assert(desc.compute.bytes != nullptr);
+	if (desc.compute.size == 0)
+		desc.compute.size = ::strlen(desc.compute.bytes);
+
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_COMPUTE);
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_COMPUTE_NEW);
+	command->compute_new.handle = h;
+	command->compute_new.desc = desc;
 	if (self->settings.defer_api_calls)
 	{
-		if (desc.data)
-		{
-			command->buffer_new.desc.data = mn::alloc(desc.data_size, alignof(char)).ptr;
-			::memcpy(command->buffer_new.desc.data, desc.data, desc.data_size);
-			command->buffer_new.owns_data = true;
-		}
+		command->compute_new.desc.compute.bytes = (char*)mn::alloc(command->compute_new.desc.compute.size, alignof(char)).ptr;
+		::memcpy((char*)command->compute_new.desc.compute.bytes, desc.compute.bytes, desc.compute.size);
+
+		command->compute_new.owns_data = true;
 	}
 	_renoir_gl450_command_process(self, command);
-	return Renoir_Buffer{h};
+	return Renoir_Compute{h};
 }
 
 static void
-_renoir_gl450_buffer_free(Renoir* api, Renoir_Buffer buffer)
+_renoir_gl450_compute_free(Renoir* api, Renoir_Compute compute)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)buffer.handle;
+	auto h = (Renoir_Handle*)compute.handle;
 	assert(h != nullptr);
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_FREE);
-	command->buffer_free.handle = h;
+
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_COMPUTE_FREE);
+	command->compute_free.handle = h;
 	_renoir_gl450_command_process(self, command);
 }
 
-static size_t
-_renoir_gl450_buffer_size(Renoir* api, Renoir_Buffer buffer)
+static Renoir_Pass
+_renoir_gl450_pass_swapchain_new(Renoir* api, Renoir_Swapchain swapchain)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)buffer.handle;
-	assert(h != nullptr && h->kind == RENOIR_HANDLE_KIND_BUFFER);
 
-	return h->buffer.size;
-}
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
 
-static Renoir_Texture
-_renoir_gl450_texture_new(Renoir* api, Renoir_Texture_Desc desc)
-{
-	assert(desc.size.width > 0 && "a texture must have at least width");
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_RASTER_PASS);
+	h->raster_pass.swapchain = (Renoir_Handle*)swapchain.handle;
 
-	if (desc.usage == RENOIR_USAGE_NONE)
-		desc.usage = RENOIR_USAGE_STATIC;
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_SWAPCHAIN_NEW);
+	command->pass_swapchain_new.handle = h;
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Pass{h};
+}
 
-	if (desc.mipmaps == 0)
-		desc.mipmaps = 1;
+static Renoir_Pass
+_renoir_gl450_pass_offscreen_new(Renoir* api, Renoir_Pass_Offscreen_Desc desc)
+{
+	auto self = api->ctx;
 
-	if (desc.usage == RENOIR_USAGE_DYNAMIC && desc.access == RENOIR_ACCESS_NONE)
+	// check that all sizes match
+	int width = -1, height = -1;
+	for (int i = 0; i < RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE; ++i)
 	{
-		assert(false && "a dynamic texture with cpu access set to none is a static texture");
-	}
+		auto color = (Renoir_Handle*)desc.color[i].texture.handle;
+		if (color == nullptr)
+			continue;
 
-	if (desc.render_target == false && desc.usage == RENOIR_USAGE_STATIC && desc.data == nullptr)
-	{
-		assert(false && "a static texture should have data to initialize it");
+		// first time getting the width/height
+		if (width == -1 && height == -1)
+		{
+			width = color->texture.desc.size.width * ::powf(0.5f, desc.color[i].level);
+			height = color->texture.desc.size.height * ::powf(0.5f, desc.color[i].level);
+		}
+		else
+		{
+			assert(color->texture.desc.size.width * ::powf(0.5f, desc.color[i].level) == width);
+			assert(color->texture.desc.size.height * ::powf(0.5f, desc.color[i].level) == height);
+		}
 	}
 
-	if (desc.cube_map)
+	auto depth = (Renoir_Handle*)desc.depth_stencil.texture.handle;
+	if (depth)
 	{
-		assert(desc.size.width == desc.size.height && "width should equal height in cube map texture");
+		// first time getting the width/height
+		if (width == -1 && height == -1)
+		{
+			width = depth->texture.desc.size.width * ::powf(0.5f, desc.depth_stencil.level);
+			height = depth->texture.desc.size.height * ::powf(0.5f, desc.depth_stencil.level);
+		}
+		else
+		{
+			assert(depth->texture.desc.size.width * ::powf(0.5f, desc.depth_stencil.level) == width);
+			assert(depth->texture.desc.size.height * ::powf(0.5f, desc.depth_stencil.level) == height);
+		}
 	}
 
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_RASTER_PASS);
+	h->raster_pass.offscreen = desc;
+	h->raster_pass.width = width;
+	h->raster_pass.height = height;
+
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_OFFSCREEN_NEW);
+	command->pass_offscreen_new.handle = h;
+	command->pass_offscreen_new.desc = desc;
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Pass{h};
+}
+
+static Renoir_Pass
+_renoir_gl450_pass_compute_new(Renoir* api)
+{
 	auto self = api->ctx;
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_TEXTURE);
-	h->texture.desc = desc;
-	::memset(h->texture.desc.data, 0, sizeof(h->texture.desc.data));
-	h->texture.desc.data_size = 0;
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_COMPUTE_PASS);
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_COMPUTE_NEW);
+	command->pass_compute_new.handle = h;
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Pass{h};
+}
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_NEW);
-	command->texture_new.handle = h;
-	command->texture_new.desc = desc;
-	if (self->settings.defer_api_calls)
-	{
-		for (int i = 0; i < 6; ++i)
-		{
-			if (desc.data[i] == nullptr)
-				continue;
+static Renoir_Pass
+_renoir_gl450_pass_bundle_new(Renoir* api)
+{
+	auto self = api->ctx;
 
-			command->texture_new.desc.data[i] = mn::alloc(desc.data_size, alignof(char)).ptr;
-			::memcpy(command->texture_new.desc.data[i], desc.data[i], desc.data_size);
-			command->texture_new.owns_data = true;
-		}
-	}
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Texture{h};
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	// bundles have no gl resources so there's no need to issue a command
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_BUNDLE);
+	return Renoir_Pass{h};
 }
 
 static void
-_renoir_gl450_texture_free(Renoir* api, Renoir_Texture texture)
+_renoir_gl450_pass_free(Renoir* api, Renoir_Pass pass)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)texture.handle;
-	assert(h != nullptr);
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_FREE);
-	command->texture_free.handle = h;
+
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_FREE);
+	command->pass_free.handle = h;
 	_renoir_gl450_command_process(self, command);
 }
 
-static void*
-_renoir_gl450_texture_native_handle(Renoir* api, Renoir_Texture texture)
+static Renoir_Size
+_renoir_gl450_pass_size(Renoir* api, Renoir_Pass pass)
 {
-	auto h = (Renoir_Handle*)texture.handle;
+	Renoir_Size res{};
+	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
-	return (void*)h->texture.id;
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+
+	// if this is an on screen/window
+	if (auto swapchain = h->raster_pass.swapchain)
+	{
+		res.width = swapchain->swapchain.width;
+		res.height = swapchain->swapchain.height;
+	}
+	// this must be an offscreen pass then
+	else
+	{
+		res.width = h->raster_pass.width;
+		res.height = h->raster_pass.height;
+	}
+	return res;
 }
 
-static Renoir_Size
-_renoir_gl450_texture_size(Renoir* api, Renoir_Texture texture)
+static Renoir_Pass_Offscreen_Desc
+_renoir_gl450_pass_offscreen_desc(Renoir* api, Renoir_Pass pass)
 {
-	auto h = (Renoir_Handle*)texture.handle;
-	assert(h != nullptr && h->kind == RENOIR_HANDLE_KIND_TEXTURE);
-	return h->texture.desc.size;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	return h->raster_pass.offscreen;
 }
 
-static Renoir_Texture_Desc
-_renoir_gl450_texture_desc(Renoir* api, Renoir_Texture texture)
+static void
+_renoir_gl450_pass_draw_sort(Renoir*, Renoir_Pass pass, bool enabled)
 {
-	auto h = (Renoir_Handle*)texture.handle;
+	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
-	assert(h->kind == RENOIR_HANDLE_KIND_TEXTURE);
-	return h->texture.desc;
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+
+	if (enabled && h->raster_pass.draw_sort == nullptr)
+	{
+		h->raster_pass.draw_sort = _renoir_gl450_draw_sort_new();
+	}
+	else if (enabled == false && h->raster_pass.draw_sort != nullptr)
+	{
+		_renoir_gl450_draw_sort_free(h->raster_pass.draw_sort);
+		h->raster_pass.draw_sort = nullptr;
+	}
 }
 
-static Renoir_Program
-_renoir_gl450_program_new(Renoir* api, Renoir_Program_Desc desc)
+static Renoir_Timer
+_renoir_gl450_timer_new(Renoir* api)
 {
-	assert(desc.vertex.bytes != nullptr && desc.pixel.bytes != nullptr);
-	if (desc.vertex.size == 0)
-		desc.vertex.size = ::strlen(desc.vertex.bytes);
-	if (desc.pixel.size == 0)
-		desc.pixel.size = ::strlen(desc.pixel.bytes);
-	if (desc.geometry.bytes != nullptr && desc.geometry.size == 0)
-		desc.geometry.size = ::strlen(desc.geometry.bytes);
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_TIMER);
+
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_NEW);
+	command->timer_new.handle = h;
+	_renoir_gl450_command_process(self, command);
+	return Renoir_Timer{h};
+}
 
+static void
+_renoir_gl450_timer_free(struct Renoir* api, Renoir_Timer timer)
+{
 	auto self = api->ctx;
+	auto h = (Renoir_Handle*)timer.handle;
+	assert(h != nullptr);
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_PROGRAM);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PROGRAM_NEW);
-	command->program_new.handle = h;
-	command->program_new.desc = desc;
-	if (self->settings.defer_api_calls)
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_FREE);
+	command->timer_free.handle = h;
+	_renoir_gl450_command_process(self, command);
+}
+
+static bool
+_renoir_gl450_timer_elapsed(struct Renoir* api, Renoir_Timer timer, uint64_t* elapsed_time_in_nanos)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)timer.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_TIMER);
+
+	if (h->timer.state == RENOIR_TIMER_STATE_READY)
 	{
-		command->program_new.desc.vertex.bytes = (char*)mn::alloc(command->program_new.desc.vertex.size, alignof(char)).ptr;
-		::memcpy((char*)command->program_new.desc.vertex.bytes, desc.vertex.bytes, desc.vertex.size);
+		if (elapsed_time_in_nanos) *elapsed_time_in_nanos = h->timer.elapsed_time_in_nanos;
+		h->timer.state = RENOIR_TIMER_STATE_NONE;
+		return true;
+	}
+	else if (h->timer.state == RENOIR_TIMER_STATE_END)
+	{
+		mn::mutex_lock(self->mtx);
+		auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_ELAPSED);
+		h->timer.state = RENOIR_TIMER_STATE_READ_SCHEDULED;
+		command->timer_elapsed.handle = h;
+		_renoir_gl450_command_process(self, command);
+		mn::mutex_unlock(self->mtx);
 
-		command->program_new.desc.pixel.bytes = (char*)mn::alloc(command->program_new.desc.pixel.size, alignof(char)).ptr;
-		::memcpy((char*)command->program_new.desc.pixel.bytes, desc.pixel.bytes, desc.pixel.size);
+		return false;
+	}
 
-		if (command->program_new.desc.geometry.bytes != nullptr)
+	return false;
+}
+
+static bool
+_renoir_gl450_readback_poll(struct Renoir* api, Renoir_Readback readback, bool wait, const void** data)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)readback.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_READBACK);
+
+	if (h->readback.state != RENOIR_READBACK_STATE_READY)
+	{
+		if (wait)
 		{
-			command->program_new.desc.geometry.bytes = (char*)mn::alloc(command->program_new.desc.geometry.size, alignof(char)).ptr;
-			::memcpy((char*)command->program_new.desc.geometry.bytes, desc.geometry.bytes, desc.geometry.size);
+			// blocking polls are executed right away like buffer_read
+			Renoir_Command command{};
+			command.kind = RENOIR_COMMAND_KIND_READBACK_POLL;
+			command.readback_poll.handle = h;
+			command.readback_poll.wait = true;
+
+			mn::mutex_lock(self->mtx);
+			if (self->settings.render_thread)
+				_renoir_gl450_render_thread_execute_sync(self, &command);
+			else
+				_renoir_gl450_command_execute(self, &command);
+			mn::mutex_unlock(self->mtx);
+		}
+		else if (h->readback.state == RENOIR_READBACK_STATE_PENDING)
+		{
+			mn::mutex_lock(self->mtx);
+			auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_READBACK_POLL);
+			h->readback.state = RENOIR_READBACK_STATE_POLL_SCHEDULED;
+			command->readback_poll.handle = h;
+			_renoir_gl450_command_process(self, command);
+			mn::mutex_unlock(self->mtx);
 		}
+	}
 
-		command->program_new.owns_data = true;
+	if (h->readback.state == RENOIR_READBACK_STATE_READY)
+	{
+		if (data) *data = h->readback.mapped;
+		return true;
 	}
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Program{h};
+
+	return false;
 }
 
 static void
-_renoir_gl450_program_free(Renoir* api, Renoir_Program program)
+_renoir_gl450_readback_free(struct Renoir* api, Renoir_Readback readback)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)program.handle;
+	auto h = (Renoir_Handle*)readback.handle;
 	assert(h != nullptr);
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PROGRAM_FREE);
-	command->program_free.handle = h;
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_READBACK_FREE);
+	command->readback_free.handle = h;
 	_renoir_gl450_command_process(self, command);
 }
 
-static Renoir_Compute
-_renoir_gl450_compute_new(Renoir* api, Renoir_Compute_Desc desc)
+static Renoir_Fence
+_renoir_gl450_fence_new(struct Renoir* api)
 {
-	assert(desc.compute.bytes != nullptr);
-	if (desc.compute.size == 0)
-		desc.compute.size = ::strlen(desc.compute.bytes);
-
 	auto self = api->ctx;
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_COMPUTE);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_COMPUTE_NEW);
-	command->compute_new.handle = h;
-	command->compute_new.desc = desc;
-	if (self->settings.defer_api_calls)
-	{
-		command->compute_new.desc.compute.bytes = (char*)mn::alloc(command->compute_new.desc.compute.size, alignof(char)).ptr;
-		::memcpy((char*)command->compute_new.desc.compute.bytes, desc.compute.bytes, desc.compute.size);
-
-		command->compute_new.owns_data = true;
-	}
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Compute{h};
+	// the sync is created by the insert so there's nothing to execute here
+	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_FENCE);
+	return Renoir_Fence{h};
 }
 
 static void
-_renoir_gl450_compute_free(Renoir* api, Renoir_Compute compute)
+_renoir_gl450_fence_free(struct Renoir* api, Renoir_Fence fence)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)compute.handle;
+	auto h = (Renoir_Handle*)fence.handle;
 	assert(h != nullptr);
 
 	mn::mutex_lock(self->mtx);
 	mn_defer(mn::mutex_unlock(self->mtx));
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_COMPUTE_FREE);
-	command->compute_free.handle = h;
+	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_FENCE_FREE);
+	command->fence_free.handle = h;
 	_renoir_gl450_command_process(self, command);
 }
 
-static Renoir_Pass
-_renoir_gl450_pass_swapchain_new(Renoir* api, Renoir_Swapchain swapchain)
+inline static bool
+_renoir_gl450_fence_is_signaled(Renoir_Handle* h)
+{
+	return h->fence.inserted_generation > 0 && h->fence.signaled_generation == h->fence.inserted_generation;
+}
+
+static bool
+_renoir_gl450_fence_signaled(struct Renoir* api, Renoir_Fence fence)
 {
 	auto self = api->ctx;
+	auto h = (Renoir_Handle*)fence.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_FENCE);
 
-	mn::mutex_lock(self->mtx);
-	mn_defer(mn::mutex_unlock(self->mtx));
+	// a fence which was never inserted isn't signaled
+	if (h->fence.inserted_generation == 0)
+		return false;
+	if (_renoir_gl450_fence_is_signaled(h))
+		return true;
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_RASTER_PASS);
-	h->raster_pass.swapchain = (Renoir_Handle*)swapchain.handle;
+	// polls are scheduled like timer_elapsed, in immediate mode it executes right away
+	if (h->fence.poll_scheduled == false)
+	{
+		mn::mutex_lock(self->mtx);
+		auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_FENCE_POLL);
+		h->fence.poll_scheduled = true;
+		command->fence_poll.handle = h;
+		_renoir_gl450_command_process(self, command);
+		mn::mutex_unlock(self->mtx);
+	}
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_SWAPCHAIN_NEW);
-	command->pass_swapchain_new.handle = h;
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Pass{h};
+	return _renoir_gl450_fence_is_signaled(h);
 }
 
-static Renoir_Pass
-_renoir_gl450_pass_offscreen_new(Renoir* api, Renoir_Pass_Offscreen_Desc desc)
+static bool
+_renoir_gl450_fence_wait(struct Renoir* api, Renoir_Fence fence, uint64_t timeout_in_nanos)
 {
 	auto self = api->ctx;
+	auto h = (Renoir_Handle*)fence.handle;
+	assert(h != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_FENCE);
 
-	// check that all sizes match
-	int width = -1, height = -1;
-	for (int i = 0; i < RENOIR_CONSTANT_COLOR_ATTACHMENT_SIZE; ++i)
-	{
-		auto color = (Renoir_Handle*)desc.color[i].texture.handle;
-		if (color == nullptr)
-			continue;
+	// a fence which was never inserted isn't signaled
+	if (h->fence.inserted_generation == 0)
+		return false;
+	if (_renoir_gl450_fence_is_signaled(h))
+		return true;
 
-		// first time getting the width/height
-		if (width == -1 && height == -1)
+	// waits are executed right away like buffer_read
+	Renoir_Command command{};
+	command.kind = RENOIR_COMMAND_KIND_FENCE_POLL;
+	command.fence_poll.handle = h;
+	command.fence_poll.timeout_in_nanos = timeout_in_nanos;
+
+	mn::mutex_lock(self->mtx);
+	if (self->settings.render_thread)
+		_renoir_gl450_render_thread_execute_sync(self, &command);
+	else
+		_renoir_gl450_command_execute(self, &command);
+	mn::mutex_unlock(self->mtx);
+
+	return _renoir_gl450_fence_is_signaled(h);
+}
+
+// Graphics Commands
+static void
+_renoir_gl450_pass_begin(Renoir* api, Renoir_Pass pass)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
+	{
+		// this pass was began before without ending it, so we discard the old commands
+		if (h->raster_pass.command_stream.head != nullptr)
 		{
-			width = color->texture.desc.size.width * ::powf(0.5f, desc.color[i].level);
-			height = color->texture.desc.size.height * ::powf(0.5f, desc.color[i].level);
+			mn::mutex_lock(self->mtx);
+			_renoir_gl450_command_stream_for_each(h->raster_pass.command_stream, [self](Renoir_Command* it) {
+				_renoir_gl450_command_free(self, it);
+			});
+			_renoir_gl450_command_stream_release(self, h->raster_pass.command_stream);
+			mn::mutex_unlock(self->mtx);
 		}
-		else
+
+		auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_PASS_BEGIN);
+		command->pass_begin.handle = h;
+	}
+	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+	{
+		// this pass was began before without ending it, so we discard the old commands
+		if (h->compute_pass.command_stream.head != nullptr)
 		{
-			assert(color->texture.desc.size.width * ::powf(0.5f, desc.color[i].level) == width);
-			assert(color->texture.desc.size.height * ::powf(0.5f, desc.color[i].level) == height);
+			mn::mutex_lock(self->mtx);
+			_renoir_gl450_command_stream_for_each(h->compute_pass.command_stream, [self](Renoir_Command* it) {
+				_renoir_gl450_command_free(self, it);
+			});
+			_renoir_gl450_command_stream_release(self, h->compute_pass.command_stream);
+			mn::mutex_unlock(self->mtx);
 		}
+
+		auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_PASS_BEGIN);
+		command->pass_begin.handle = h;
 	}
+	else if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+	{
+		// bundles don't have pass begin/end commands because they execute inside other passes
+		assert(h->bundle.recorded == false && "bundles can only be recorded once");
+	}
+	else
+	{
+		assert(false && "invalid pass");
+	}
+}
 
-	auto depth = (Renoir_Handle*)desc.depth_stencil.texture.handle;
-	if (depth)
+// submits the recorded commands of the pass, should be called while holding the mutex
+static void
+_renoir_gl450_pass_submit_commands(IRenoir* self, Renoir_Handle* h)
+{
+	// bundles are not submitted, they are executed inside other passes using bundle_execute
+	if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
+		return;
+
+	auto& stream = _renoir_gl450_pass_command_stream(h);
+	if (stream.head == nullptr)
+		return;
+
+	// push the commands to the end of command stream, if the user requested to defer api calls
+	if (self->settings.defer_api_calls)
 	{
-		// first time getting the width/height
-		if (width == -1 && height == -1)
+		// the pass pages will be released with the global commands after they execute
+		_renoir_gl450_command_stream_append(self->command_stream, stream);
+	}
+	// other than this just process the command
+	else
+	{
+		_renoir_gl450_command_stream_execute(self, stream);
+		_renoir_gl450_command_stream_release(self, stream);
+	}
+}
+
+inline static void
+_renoir_gl450_draw_state_reset(Renoir_GL450_Draw_State& state)
+{
+	state.program = nullptr;
+	state.pipeline = nullptr;
+	state.scissor = nullptr;
+	mn::buf_clear(state.binds);
+}
+
+// commands are zeroed on allocation so they can be compared bytewise
+inline static bool
+_renoir_gl450_command_equal(Renoir_Command* a, Renoir_Command* b)
+{
+	if (a == b)
+		return true;
+	if (a == nullptr || b == nullptr)
+		return false;
+	return a->size == b->size && ::memcmp(a, b, a->size) == 0;
+}
+
+// binds with the same kind, shader, and slot override each other
+inline static size_t
+_renoir_gl450_draw_state_bind_find(Renoir_GL450_Draw_State& state, Renoir_Command* command)
+{
+	for (size_t i = 0; i < state.binds.count; ++i)
+	{
+		auto it = state.binds[i];
+		if (it->kind != command->kind)
+			continue;
+
+		if (command->kind == RENOIR_COMMAND_KIND_BUFFER_BIND)
 		{
-			width = depth->texture.desc.size.width * ::powf(0.5f, desc.depth_stencil.level);
-			height = depth->texture.desc.size.height * ::powf(0.5f, desc.depth_stencil.level);
+			if (it->buffer_bind.shader == command->buffer_bind.shader && it->buffer_bind.slot == command->buffer_bind.slot)
+				return i;
 		}
 		else
 		{
-			assert(depth->texture.desc.size.width * ::powf(0.5f, desc.depth_stencil.level) == width);
-			assert(depth->texture.desc.size.height * ::powf(0.5f, desc.depth_stencil.level) == height);
+			if (it->texture_bind.shader == command->texture_bind.shader && it->texture_bind.slot == command->texture_bind.slot)
+				return i;
 		}
 	}
+	return state.binds.count;
+}
 
-	mn::mutex_lock(self->mtx);
-	mn_defer(mn::mutex_unlock(self->mtx));
+inline static void
+_renoir_gl450_draw_state_bind(Renoir_GL450_Draw_State& state, Renoir_Command* command)
+{
+	auto ix = _renoir_gl450_draw_state_bind_find(state, command);
+	if (ix < state.binds.count)
+		state.binds[ix] = command;
+	else
+		mn::buf_push(state.binds, command);
+}
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_RASTER_PASS);
-	h->raster_pass.offscreen = desc;
-	h->raster_pass.width = width;
-	h->raster_pass.height = height;
+// copies the command to the stream, the copy takes its own reference to the handles the command owns
+inline static void
+_renoir_gl450_command_copy(IRenoir* self, Renoir_Command_Stream& stream, Renoir_Command* command)
+{
+	auto res = (Renoir_Command*)_renoir_gl450_command_stream_alloc(self, stream, command->size);
+	::memcpy(res, command, command->size);
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_OFFSCREEN_NEW);
-	command->pass_offscreen_new.handle = h;
-	command->pass_offscreen_new.desc = desc;
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Pass{h};
+	if (command->kind == RENOIR_COMMAND_KIND_USE_PIPELINE)
+		_renoir_gl450_handle_ref(command->use_pipeline.handle);
+	else if (command->kind == RENOIR_COMMAND_KIND_BUNDLE_EXECUTE)
+		_renoir_gl450_handle_ref(command->bundle_execute.handle);
 }
 
-static Renoir_Pass
-_renoir_gl450_pass_compute_new(Renoir* api)
+// copies the state commands which differ from the already emitted state
+inline static void
+_renoir_gl450_draw_sort_emit_state(IRenoir* self, Renoir_GL450_Draw_Sort* sort, Renoir_Command_Stream& stream, Renoir_Command* program, Renoir_Command* pipeline, Renoir_Command* scissor, Renoir_Command** binds, size_t binds_count)
 {
-	auto self = api->ctx;
+	auto& emitted = sort->emitted;
+	if (program && _renoir_gl450_command_equal(emitted.program, program) == false)
+	{
+		_renoir_gl450_command_copy(self, stream, program);
+		emitted.program = program;
+	}
 
-	mn::mutex_lock(self->mtx);
-	mn_defer(mn::mutex_unlock(self->mtx));
+	if (pipeline && _renoir_gl450_command_equal(emitted.pipeline, pipeline) == false)
+	{
+		_renoir_gl450_command_copy(self, stream, pipeline);
+		emitted.pipeline = pipeline;
+	}
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_COMPUTE_PASS);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_COMPUTE_NEW);
-	command->pass_compute_new.handle = h;
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Pass{h};
+	if (scissor && _renoir_gl450_command_equal(emitted.scissor, scissor) == false)
+	{
+		_renoir_gl450_command_copy(self, stream, scissor);
+		emitted.scissor = scissor;
+	}
+
+	for (size_t i = 0; i < binds_count; ++i)
+	{
+		auto ix = _renoir_gl450_draw_state_bind_find(emitted, binds[i]);
+		if (ix < emitted.binds.count && _renoir_gl450_command_equal(emitted.binds[ix], binds[i]))
+			continue;
+
+		_renoir_gl450_command_copy(self, stream, binds[i]);
+		_renoir_gl450_draw_state_bind(emitted, binds[i]);
+	}
+}
+
+inline static void
+_renoir_gl450_draw_sort_emit_packet(IRenoir* self, Renoir_GL450_Draw_Sort* sort, Renoir_Command_Stream& stream, const Renoir_GL450_Draw_Packet& packet)
+{
+	_renoir_gl450_draw_sort_emit_state(
+		self,
+		sort,
+		stream,
+		packet.program,
+		packet.pipeline,
+		packet.scissor,
+		sort->packets_binds.ptr + packet.binds_offset,
+		packet.binds_count
+	);
+	_renoir_gl450_command_copy(self, stream, packet.draw);
 }
 
-static void
-_renoir_gl450_pass_free(Renoir* api, Renoir_Pass pass)
+// sorts the pending packets and emits them, this is called before each command which the draws can't cross
+inline static void
+_renoir_gl450_draw_sort_flush(IRenoir* self, Renoir_GL450_Draw_Sort* sort, Renoir_Command_Stream& stream)
 {
-	auto self = api->ctx;
+	std::stable_sort(sort->packets.ptr, sort->packets.ptr + sort->packets.count, [](const Renoir_GL450_Draw_Packet& a, const Renoir_GL450_Draw_Packet& b) {
+		return a.key < b.key;
+	});
 
-	mn::mutex_lock(self->mtx);
-	mn_defer(mn::mutex_unlock(self->mtx));
+	for (const auto& packet: sort->packets)
+		_renoir_gl450_draw_sort_emit_packet(self, sort, stream, packet);
 
-	auto h = (Renoir_Handle*)pass.handle;
-	assert(h != nullptr);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_FREE);
-	command->pass_free.handle = h;
-	_renoir_gl450_command_process(self, command);
+	mn::buf_clear(sort->packets);
+	mn::buf_clear(sort->packets_binds);
 }
 
-static Renoir_Size
-_renoir_gl450_pass_size(Renoir* api, Renoir_Pass pass)
+// emits the command in its recorded position, the draws don't cross it and it sees the same state it was recorded with
+inline static void
+_renoir_gl450_draw_sort_emit_in_place(IRenoir* self, Renoir_GL450_Draw_Sort* sort, Renoir_Command_Stream& stream, Renoir_Command* command)
 {
-	Renoir_Size res{};
-	auto h = (Renoir_Handle*)pass.handle;
-	assert(h != nullptr);
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	auto& recorded = sort->recorded;
+	_renoir_gl450_draw_sort_flush(self, sort, stream);
+	_renoir_gl450_draw_sort_emit_state(
+		self,
+		sort,
+		stream,
+		recorded.program,
+		recorded.pipeline,
+		recorded.scissor,
+		recorded.binds.ptr,
+		recorded.binds.count
+	);
+	_renoir_gl450_command_copy(self, stream, command);
 
-	// if this is an on screen/window
-	if (auto swapchain = h->raster_pass.swapchain)
-	{
-		res.width = swapchain->swapchain.width;
-		res.height = swapchain->swapchain.height;
-	}
-	// this must be an offscreen pass then
-	else
+	// bundles change the bound state so we no longer know it
+	if (command->kind == RENOIR_COMMAND_KIND_BUNDLE_EXECUTE)
 	{
-		res.width = h->raster_pass.width;
-		res.height = h->raster_pass.height;
+		_renoir_gl450_draw_state_reset(recorded);
+		_renoir_gl450_draw_state_reset(sort->emitted);
 	}
-	return res;
 }
 
-static Renoir_Pass_Offscreen_Desc
-_renoir_gl450_pass_offscreen_desc(Renoir* api, Renoir_Pass pass)
+inline static uint64_t
+_renoir_gl450_draw_sort_index(mn::Buf<Renoir_Handle*>& handles, Renoir_Handle* h)
 {
-	auto h = (Renoir_Handle*)pass.handle;
-	assert(h != nullptr);
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
-	return h->raster_pass.offscreen;
+	for (size_t i = 0; i < handles.count; ++i)
+		if (handles[i] == h)
+			return i;
+	mn::buf_push(handles, h);
+	return handles.count - 1;
 }
 
-static Renoir_Timer
-_renoir_gl450_timer_new(Renoir* api)
+// the key is 16 bits of each of program, pipeline, textures, and depth from the most to the least significant
+inline static uint64_t
+_renoir_gl450_draw_sort_key(Renoir_GL450_Draw_Sort* sort, const Renoir_GL450_Draw_Packet& packet)
 {
-	auto self = api->ctx;
+	uint64_t program = _renoir_gl450_draw_sort_index(sort->programs, packet.program->use_program.program);
+	uint64_t pipeline = _renoir_gl450_draw_sort_index(sort->pipelines, packet.pipeline->use_pipeline.handle);
 
-	mn::mutex_lock(self->mtx);
-	mn_defer(mn::mutex_unlock(self->mtx));
+	uint64_t textures = 14695981039346656037ULL;
+	for (size_t i = 0; i < packet.binds_count; ++i)
+	{
+		auto bind = sort->packets_binds[packet.binds_offset + i];
+		if (bind->kind != RENOIR_COMMAND_KIND_TEXTURE_BIND)
+			continue;
+		textures ^= uint64_t(bind->texture_bind.handle);
+		textures *= 1099511628211ULL;
+	}
 
-	auto h = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_TIMER);
+	// flip the float bits so that they sort as unsigned ints
+	uint32_t depth = 0;
+	::memcpy(&depth, &packet.draw->draw.sort_depth, sizeof(depth));
+	depth = (depth & 0x80000000) ? ~depth : (depth | 0x80000000);
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_NEW);
-	command->timer_new.handle = h;
-	_renoir_gl450_command_process(self, command);
-	return Renoir_Timer{h};
+	return (
+		((program & 0xFFFF) << 48) |
+		((pipeline & 0xFFFF) << 32) |
+		((textures & 0xFFFF) << 16) |
+		uint64_t(depth >> 16)
+	);
 }
 
+// rewrites the raster pass stream with its draws sorted, state commands are copied in front of the draws
+// which need them, other commands are kept in place and the draws don't cross them
 static void
-_renoir_gl450_timer_free(struct Renoir* api, Renoir_Timer timer)
+_renoir_gl450_pass_draw_sort_commands(IRenoir* self, Renoir_Handle* h)
 {
-	auto self = api->ctx;
-	auto h = (Renoir_Handle*)timer.handle;
-	assert(h != nullptr);
+	auto sort = h->raster_pass.draw_sort;
+	auto& src = h->raster_pass.command_stream;
+
+	// the write payloads are referenced by the commands so they're moved to the sorted stream as is
+	Renoir_Command_Stream dst{};
+	dst.upload_head = src.upload_head;
+	dst.upload_tail = src.upload_tail;
+	src.upload_head = nullptr;
+	src.upload_tail = nullptr;
+
+	_renoir_gl450_draw_state_reset(sort->recorded);
+	_renoir_gl450_draw_state_reset(sort->emitted);
+	mn::buf_clear(sort->programs);
+	mn::buf_clear(sort->pipelines);
+
+	_renoir_gl450_command_stream_for_each(src, [self, sort, &dst](Renoir_Command* it) {
+		auto& recorded = sort->recorded;
+		switch (it->kind)
+		{
+		case RENOIR_COMMAND_KIND_USE_PROGRAM:
+			recorded.program = it;
+			break;
+		case RENOIR_COMMAND_KIND_USE_PIPELINE:
+			recorded.pipeline = it;
+			break;
+		case RENOIR_COMMAND_KIND_SCISSOR:
+			recorded.scissor = it;
+			break;
+		case RENOIR_COMMAND_KIND_BUFFER_BIND:
+		case RENOIR_COMMAND_KIND_TEXTURE_BIND:
+			_renoir_gl450_draw_state_bind(recorded, it);
+			break;
+		case RENOIR_COMMAND_KIND_DRAW:
+		{
+			// draws which use the state left by a previous pass or bundle can't be moved either
+			if (it->draw.sort_ordered == false && recorded.program != nullptr && recorded.pipeline != nullptr)
+			{
+				Renoir_GL450_Draw_Packet packet{};
+				packet.draw = it;
+				packet.program = recorded.program;
+				packet.pipeline = recorded.pipeline;
+				packet.scissor = recorded.scissor;
+				packet.binds_offset = sort->packets_binds.count;
+				packet.binds_count = recorded.binds.count;
+				for (auto bind: recorded.binds)
+					mn::buf_push(sort->packets_binds, bind);
+				packet.key = _renoir_gl450_draw_sort_key(sort, packet);
+				mn::buf_push(sort->packets, packet);
+			}
+			else
+			{
+				_renoir_gl450_draw_sort_emit_in_place(self, sort, dst, it);
+			}
+			break;
+		}
+		default:
+			_renoir_gl450_draw_sort_emit_in_place(self, sort, dst, it);
+			break;
+		}
+	});
+	_renoir_gl450_draw_sort_flush(self, sort, dst);
 
+	// the copies hold their own references so we free the recorded commands, this might issue free commands
 	mn::mutex_lock(self->mtx);
-	mn_defer(mn::mutex_unlock(self->mtx));
+	_renoir_gl450_command_stream_for_each(src, [self](Renoir_Command* it) {
+		_renoir_gl450_command_free(self, it);
+	});
+	_renoir_gl450_command_stream_release(self, src);
+	mn::mutex_unlock(self->mtx);
 
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_FREE);
-	command->timer_free.handle = h;
-	_renoir_gl450_command_process(self, command);
+	src = dst;
 }
 
-static bool
-_renoir_gl450_timer_elapsed(struct Renoir* api, Renoir_Timer timer, uint64_t* elapsed_time_in_nanos)
+static void
+_renoir_gl450_pass_record_end(Renoir* api, Renoir_Pass pass)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)timer.handle;
+	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
-	assert(h->kind == RENOIR_HANDLE_KIND_TIMER);
 
-	if (h->timer.state == RENOIR_TIMER_STATE_READY)
+	// the bundle is now immutable, so we take a reference to all the handles it uses to keep it valid until it's freed
+	if (h->kind == RENOIR_HANDLE_KIND_BUNDLE)
 	{
-		if (elapsed_time_in_nanos) *elapsed_time_in_nanos = h->timer.elapsed_time_in_nanos;
-		h->timer.state = RENOIR_TIMER_STATE_NONE;
-		return true;
+		assert(h->bundle.recorded == false && "bundles can only be recorded once");
+		_renoir_gl450_command_stream_for_each(h->bundle.command_stream, [](Renoir_Command* it) {
+			Renoir_Handle* handles[RENOIR_GL450_COMMAND_HANDLES_SIZE];
+			auto handles_count = _renoir_gl450_command_handles(it, handles);
+			for (size_t i = 0; i < handles_count; ++i)
+				_renoir_gl450_handle_ref(handles[i]);
+		});
+		h->bundle.recorded = true;
+		return;
 	}
-	else if (h->timer.state == RENOIR_TIMER_STATE_END)
-	{
-		mn::mutex_lock(self->mtx);
-		auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_ELAPSED);
-		h->timer.state = RENOIR_TIMER_STATE_READ_SCHEDULED;
-		mn::mutex_unlock(self->mtx);
 
-		command->timer_elapsed.handle = h;
-		_renoir_gl450_command_process(self, command);
+	auto& stream = _renoir_gl450_pass_command_stream(h);
+	if (stream.head == nullptr)
+		return;
 
-		return false;
-	}
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS && h->raster_pass.draw_sort != nullptr)
+		_renoir_gl450_pass_draw_sort_commands(self, h);
 
-	return false;
+	// push the pass end command, the pass stream is only touched by the recording thread so no need to lock
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_PASS_END);
+	command->pass_end.handle = h;
 }
 
-// Graphics Commands
 static void
-_renoir_gl450_pass_begin(Renoir* api, Renoir_Pass pass)
+_renoir_gl450_pass_submit(Renoir* api, Renoir_Pass* passes, size_t passes_count)
 {
 	auto self = api->ctx;
-	auto h = (Renoir_Handle*)pass.handle;
-	assert(h != nullptr);
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
-	{
-		h->raster_pass.command_list_head = nullptr;
-		h->raster_pass.command_list_tail = nullptr;
-
-		mn::mutex_lock(self->mtx);
-		mn_defer(mn::mutex_unlock(self->mtx));
-
-		auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_BEGIN);
-		command->pass_begin.handle = h;
-		_renoir_gl450_command_push(&h->raster_pass, command);
-	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
-	{
-		h->compute_pass.command_list_head = nullptr;
-		h->compute_pass.command_list_tail = nullptr;
 
-		mn::mutex_lock(self->mtx);
-		mn_defer(mn::mutex_unlock(self->mtx));
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
 
-		auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_BEGIN);
-		command->pass_begin.handle = h;
-		_renoir_gl450_command_push(&h->compute_pass, command);
-	}
-	else
+	// passes are submitted in the given order regardless of the order in which they finished recording
+	for (size_t i = 0; i < passes_count; ++i)
 	{
-		assert(false && "invalid pass");
+		auto h = (Renoir_Handle*)passes[i].handle;
+		assert(h != nullptr);
+		_renoir_gl450_pass_submit_commands(self, h);
 	}
 }
 
 static void
 _renoir_gl450_pass_end(Renoir* api, Renoir_Pass pass)
 {
-	auto self = api->ctx;
-	auto h = (Renoir_Handle*)pass.handle;
-	assert(h != nullptr);
-
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
-	{
-		if (h->raster_pass.command_list_head != nullptr)
-		{
-			mn::mutex_lock(self->mtx);
-
-			// push the pass end command
-			auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_END);
-			command->pass_end.handle = h;
-			_renoir_gl450_command_push(&h->raster_pass, command);
-
-			// push the commands to the end of command list, if the user requested to defer api calls
-			if (self->settings.defer_api_calls)
-			{
-				if (self->command_list_tail == nullptr)
-				{
-					self->command_list_head = h->raster_pass.command_list_head;
-					self->command_list_tail = h->raster_pass.command_list_tail;
-				}
-				else
-				{
-					self->command_list_tail->next = h->raster_pass.command_list_head;
-					self->command_list_tail = h->raster_pass.command_list_tail;
-				}
-			}
-			// other than this just process the command
-			else
-			{
-				for(auto it = h->raster_pass.command_list_head; it != nullptr; it = it->next)
-				{
-					_renoir_gl450_command_execute(self, it);
-					_renoir_gl450_command_free(self, it);
-				}
-			}
-			mn::mutex_unlock(self->mtx);
-		}
-		h->raster_pass.command_list_head = nullptr;
-		h->raster_pass.command_list_tail = nullptr;
-	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
-	{
-		if (h->compute_pass.command_list_head != nullptr)
-		{
-			mn::mutex_lock(self->mtx);
-
-			// push the pass end command
-			auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_END);
-			command->pass_end.handle = h;
-			_renoir_gl450_command_push(&h->compute_pass, command);
-
-			// push the commands to the end of command list, if the user requested to defer api calls
-			if (self->settings.defer_api_calls)
-			{
-				if (self->command_list_tail == nullptr)
-				{
-					self->command_list_head = h->compute_pass.command_list_head;
-					self->command_list_tail = h->compute_pass.command_list_tail;
-				}
-				else
-				{
-					self->command_list_tail->next = h->compute_pass.command_list_head;
-					self->command_list_tail = h->compute_pass.command_list_tail;
-				}
-			}
-			// other than this just process the command
-			else
-			{
-				for(auto it = h->compute_pass.command_list_head; it != nullptr; it = it->next)
-				{
-					_renoir_gl450_command_execute(self, it);
-					_renoir_gl450_command_free(self, it);
-				}
-			}
-			mn::mutex_unlock(self->mtx);
-		}
-		h->compute_pass.command_list_head = nullptr;
-		h->compute_pass.command_list_tail = nullptr;
-	}
-	else
-	{
-		assert(false && "invalid pass");
-	}
+	_renoir_gl450_pass_record_end(api, pass);
+	_renoir_gl450_pass_submit(api, &pass, 1);
 }
 
 static void
@@ -3701,17 +6671,14 @@ _renoir_gl450_clear(Renoir* api, Renoir_Pass pass, Renoir_Clear_Desc desc)
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
 	if (desc.independent_clear_color == RENOIR_SWITCH_DEFAULT)
 		desc.independent_clear_color = RENOIR_SWITCH_DISABLE;
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_PASS_CLEAR);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_PASS_CLEAR);
 
 	command->pass_clear.desc = desc;
-	_renoir_gl450_command_push(&h->raster_pass, command);
 }
 
 static void
@@ -3721,15 +6688,16 @@ _renoir_gl450_use_pipeline(Renoir* api, Renoir_Pass pass, Renoir_Pipeline_Desc p
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 	_renoir_gl450_pipeline_desc_defaults(&pipeline_desc);
 
 	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_USE_PIPELINE);
+	auto hpipeline = _renoir_gl450_handle_ref(_renoir_gl450_pipeline_get(self, pipeline_desc));
 	mn::mutex_unlock(self->mtx);
 
-	command->use_pipeline.pipeline_desc = pipeline_desc;
-	_renoir_gl450_command_push(&h->raster_pass, command);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_USE_PIPELINE);
+
+	command->use_pipeline.handle = hpipeline;
 }
 
 static void
@@ -3739,14 +6707,11 @@ _renoir_gl450_use_program(Renoir* api, Renoir_Pass pass, Renoir_Program program)
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_USE_PROGRAM);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_USE_PROGRAM);
 
 	command->use_program.program = (Renoir_Handle*)program.handle;
-	_renoir_gl450_command_push(&h->raster_pass, command);
 }
 
 static void
@@ -3758,12 +6723,9 @@ _renoir_gl450_use_compute(Renoir* api, Renoir_Pass pass, Renoir_Compute compute)
 
 	assert(h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS);
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_USE_COMPUTE);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_USE_COMPUTE);
 
 	command->use_compute.compute = (Renoir_Handle*)compute.handle;
-	_renoir_gl450_command_push(&h->compute_pass, command);
 }
 
 static void
@@ -3773,17 +6735,33 @@ _renoir_gl450_scissor(Renoir* api, Renoir_Pass pass, int x, int y, int width, in
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_SCISSOR);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_SCISSOR);
 
 	command->scissor.x = x;
 	command->scissor.y = y;
 	command->scissor.w = width;
 	command->scissor.h = height;
-	_renoir_gl450_command_push(&h->raster_pass, command);
+}
+
+static void
+_renoir_gl450_bundle_execute(Renoir* api, Renoir_Pass pass, Renoir_Pass bundle)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	auto hbundle = (Renoir_Handle*)bundle.handle;
+	assert(hbundle != nullptr && hbundle->kind == RENOIR_HANDLE_KIND_BUNDLE);
+	assert(hbundle->bundle.recorded && "bundle should be recorded before executing it");
+
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_BUNDLE_EXECUTE);
+
+	// the command holds a reference to the bundle until it's freed
+	command->bundle_execute.handle = _renoir_gl450_handle_ref(hbundle);
 }
 
 static void
@@ -3797,96 +6775,255 @@ _renoir_gl450_buffer_write(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer,
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->buffer.usage != RENOIR_USAGE_STATIC);
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr);
+	assert(hbuffer->buffer.usage != RENOIR_USAGE_STATIC);
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_WRITE);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_BUFFER_WRITE);
 
-	command->buffer_write.handle = (Renoir_Handle*)buffer.handle;
+	command->buffer_write.handle = hbuffer;
 	command->buffer_write.offset = offset;
-	command->buffer_write.bytes = mn::alloc(bytes_size, alignof(char)).ptr;
+	command->buffer_write.bytes = _renoir_gl450_command_stream_upload_alloc(self, _renoir_gl450_pass_command_stream(h), bytes_size);
 	command->buffer_write.bytes_size = bytes_size;
 	::memcpy(command->buffer_write.bytes, bytes, bytes_size);
+}
 
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
-	{
-		_renoir_gl450_command_push(&h->raster_pass, command);
-	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+static void
+_renoir_gl450_texture_write(Renoir* api, Renoir_Pass pass, Renoir_Texture texture, Renoir_Texture_Edit_Desc desc)
+{
+	// this means he's trying to write nothing so no-op
+	if (desc.bytes_size == 0)
+		return;
+
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	auto htexture = (Renoir_Handle*)texture.handle;
+	assert(htexture != nullptr);
+	assert(htexture->texture.desc.usage != RENOIR_USAGE_STATIC);
+
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TEXTURE_WRITE);
+
+	command->texture_write.handle = htexture;
+	command->texture_write.desc = desc;
+	command->texture_write.desc.bytes = _renoir_gl450_command_stream_upload_alloc(self, _renoir_gl450_pass_command_stream(h), desc.bytes_size);
+	::memcpy(command->texture_write.desc.bytes, desc.bytes, desc.bytes_size);
+}
+
+static void
+_renoir_gl450_buffer_read(Renoir* api, Renoir_Buffer buffer, size_t offset, void* bytes, size_t bytes_size)
+{
+	// this means he's trying to read nothing so no-op
+	if (bytes_size == 0)
+		return;
+
+	auto h = (Renoir_Handle*)buffer.handle;
+	assert(h != nullptr);
+	// buffers have immutable storage which can only be mapped for reading if their cpu access allows it
+	assert(
+		(h->buffer.access == RENOIR_ACCESS_READ || h->buffer.access == RENOIR_ACCESS_READ_WRITE) &&
+		"a buffer should have cpu read access to be read"
+	);
+	// this means that buffer creation didn't execute yet
+	if (h->buffer.id == 0)
 	{
-		_renoir_gl450_command_push(&h->compute_pass, command);
+		::memset(bytes, 0, bytes_size);
+		return;
 	}
+
+	auto self = api->ctx;
+
+	Renoir_Command command{};
+	command.kind = RENOIR_COMMAND_KIND_BUFFER_READ;
+	command.buffer_read.handle = h;
+	command.buffer_read.offset = offset;
+	command.buffer_read.bytes = bytes;
+	command.buffer_read.bytes_size = bytes_size;
+
+	mn::mutex_lock(self->mtx);
+	if (self->settings.render_thread)
+		_renoir_gl450_render_thread_execute_sync(self, &command);
 	else
-	{
-		assert(false && "invalid pass");
-	}
+		_renoir_gl450_command_execute(self, &command);
+	mn::mutex_unlock(self->mtx);
+}
+
+static Renoir_Readback
+_renoir_gl450_buffer_read_async(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, size_t size)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	// bundles are replayed so they would copy into the same readback multiple times
+	assert(h->kind != RENOIR_HANDLE_KIND_BUNDLE && "readbacks can't be recorded in bundles");
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr);
+	assert(size > 0 && offset + size <= hbuffer->buffer.size);
+
+	mn::mutex_lock(self->mtx);
+	auto hreadback = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_READBACK);
+	mn::mutex_unlock(self->mtx);
+
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_BUFFER_READ_ASYNC);
+	command->buffer_read_async.handle = hreadback;
+	command->buffer_read_async.buffer = hbuffer;
+	command->buffer_read_async.offset = offset;
+	command->buffer_read_async.size = size;
+	return Renoir_Readback{hreadback};
 }
 
-static void
-_renoir_gl450_texture_write(Renoir* api, Renoir_Pass pass, Renoir_Texture texture, Renoir_Texture_Edit_Desc desc)
+static Renoir_Readback
+_renoir_gl450_texture_read_async(Renoir* api, Renoir_Pass pass, Renoir_Texture texture, Renoir_Texture_Read_Async_Desc desc)
 {
-	// this means he's trying to write nothing so no-op
-	if (desc.bytes_size == 0)
-		return;
-
 	auto self = api->ctx;
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
+	// bundles are replayed so they would copy into the same readback multiple times
+	assert(h->kind != RENOIR_HANDLE_KIND_BUNDLE && "readbacks can't be recorded in bundles");
+
+	auto htexture = (Renoir_Handle*)texture.handle;
+	assert(htexture != nullptr);
+	assert(htexture->texture.desc.msaa == RENOIR_MSAA_MODE_NONE && "msaa textures can't be read");
+	assert(desc.width > 0);
+
+	if (desc.height == 0)
+		desc.height = 1;
+	if (desc.depth == 0)
+		desc.depth = 1;
+	// 1D textures only have one row and 2D textures only have one layer, cube maps use z as the face index
+	if (htexture->texture.desc.size.height == 0)
+	{
+		desc.y = 0;
+		desc.height = 1;
+	}
+	if (htexture->texture.desc.size.depth == 0)
+	{
+		if (htexture->texture.desc.cube_map == false)
+			desc.z = 0;
+		desc.depth = 1;
+	}
 
-	assert(h->texture.desc.usage != RENOIR_USAGE_STATIC);
+	auto pixel_size = _renoir_pixelformat_to_size(htexture->texture.desc.pixel_format);
+	if (desc.row_pitch == 0)
+		desc.row_pitch = desc.width * pixel_size;
+	assert(desc.row_pitch >= desc.width * pixel_size && desc.row_pitch % pixel_size == 0 && "invalid row pitch");
 
 	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_WRITE);
+	auto hreadback = _renoir_gl450_handle_new(self, RENOIR_HANDLE_KIND_READBACK);
 	mn::mutex_unlock(self->mtx);
 
-	command->texture_write.handle = (Renoir_Handle*)texture.handle;
-	command->texture_write.desc = desc;
-	command->texture_write.desc.bytes = mn::alloc(desc.bytes_size, alignof(char)).ptr;
-	::memcpy(command->texture_write.desc.bytes, desc.bytes, desc.bytes_size);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TEXTURE_READ_ASYNC);
+	command->texture_read_async.handle = hreadback;
+	command->texture_read_async.texture = htexture;
+	command->texture_read_async.desc = desc;
+	command->texture_read_async.size = desc.row_pitch * desc.height * desc.depth;
+	return Renoir_Readback{hreadback};
+}
 
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
+static void*
+_renoir_gl450_buffer_map(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset, size_t size, RENOIR_ACCESS access)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)buffer.handle;
+	assert(h != nullptr);
+	assert(h->buffer.map_ptr == nullptr && "buffer is already mapped");
+	assert(size > 0 && offset + size <= h->buffer.size && "out of range buffer map");
+	assert((access == RENOIR_ACCESS_READ || access == RENOIR_ACCESS_WRITE) && "buffers can be mapped for either read or write");
+
+	h->buffer.map_offset = offset;
+	h->buffer.map_size = size;
+	h->buffer.map_access = access;
+	h->buffer.map_gl = false;
+	h->buffer.map_owned = false;
+
+	if (access == RENOIR_ACCESS_WRITE)
 	{
-		_renoir_gl450_command_push(&h->raster_pass, command);
+		auto hpass = (Renoir_Handle*)pass.handle;
+		assert(hpass != nullptr);
+		assert(h->buffer.usage != RENOIR_USAGE_STATIC && h->buffer.transient == false);
+		// the gl buffer can't be written until the commands which were recorded before the map execute, so the memory
+		// comes from the pass upload blocks and buffer_unmap records it as a buffer write without copying it
+		h->buffer.map_pass = hpass;
+		h->buffer.map_ptr = _renoir_gl450_command_stream_upload_alloc(self, _renoir_gl450_pass_command_stream(hpass), size);
+		return h->buffer.map_ptr;
 	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
+
+	assert(
+		(h->buffer.access == RENOIR_ACCESS_READ || h->buffer.access == RENOIR_ACCESS_READ_WRITE) &&
+		"a buffer should have cpu read access to be read"
+	);
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	// the render thread owns the context so we read a copy, and the same goes for buffers which aren't created yet
+	if (self->settings.render_thread || h->buffer.id == 0)
 	{
-		_renoir_gl450_command_push(&h->compute_pass, command);
+		h->buffer.map_owned = true;
+		h->buffer.map_ptr = mn::alloc(size, alignof(char)).ptr;
+		if (h->buffer.id == 0)
+		{
+			::memset(h->buffer.map_ptr, 0, size);
+			return h->buffer.map_ptr;
+		}
+
+		Renoir_Command command{};
+		command.kind = RENOIR_COMMAND_KIND_BUFFER_READ;
+		command.buffer_read.handle = h;
+		command.buffer_read.offset = offset;
+		command.buffer_read.bytes = h->buffer.map_ptr;
+		command.buffer_read.bytes_size = size;
+		_renoir_gl450_render_thread_execute_sync(self, &command);
+		return h->buffer.map_ptr;
 	}
-	else
+
+	// renamed buffers are persistently mapped and only written through the mapping
+	if (h->buffer.renamed)
 	{
-		assert(false && "invalid pass");
+		h->buffer.map_ptr = (char*)h->buffer.mapped + _renoir_gl450_buffer_offset(h) + offset;
+		return h->buffer.map_ptr;
 	}
+
+	h->buffer.map_gl = true;
+	h->buffer.map_ptr = glMapNamedBufferRange(h->buffer.id, offset, size, GL_MAP_READ_BIT);
+	assert(_renoir_gl450_check());
+	return h->buffer.map_ptr;
 }
 
 static void
-_renoir_gl450_buffer_read(Renoir* api, Renoir_Buffer buffer, size_t offset, void* bytes, size_t bytes_size)
+_renoir_gl450_buffer_unmap(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer)
 {
-	// this means he's trying to read nothing so no-op
-	if (bytes_size == 0)
-		return;
-
+	auto self = api->ctx;
 	auto h = (Renoir_Handle*)buffer.handle;
 	assert(h != nullptr);
-	// this means that buffer creation didn't execute yet
-	if (h->buffer.id == 0)
-	{
-		::memset(bytes, 0, bytes_size);
-		return;
-	}
-
-	auto self = api->ctx;
+	assert(h->buffer.map_ptr != nullptr && "buffer is not mapped");
 
-	Renoir_Command command{};
-	command.kind = RENOIR_COMMAND_KIND_BUFFER_READ;
-	command.buffer_read.handle = h;
-	command.buffer_read.offset = offset;
-	command.buffer_read.bytes = bytes;
-	command.buffer_read.bytes_size = bytes_size;
+	if (h->buffer.map_access == RENOIR_ACCESS_WRITE)
+	{
+		auto hpass = (Renoir_Handle*)pass.handle;
+		assert(hpass == h->buffer.map_pass && "buffer should be unmapped in the pass it was mapped in");
 
-	mn::mutex_lock(self->mtx);
-	_renoir_gl450_command_execute(self, &command);
-	mn::mutex_unlock(self->mtx);
+		auto command = _renoir_gl450_command_new(self, hpass, RENOIR_COMMAND_KIND_BUFFER_WRITE);
+		command->buffer_write.handle = h;
+		command->buffer_write.offset = h->buffer.map_offset;
+		command->buffer_write.bytes = h->buffer.map_ptr;
+		command->buffer_write.bytes_size = h->buffer.map_size;
+		h->buffer.map_pass = nullptr;
+	}
+	else if (h->buffer.map_owned)
+	{
+		mn::free(mn::Block{h->buffer.map_ptr, h->buffer.map_size});
+	}
+	else if (h->buffer.map_gl)
+	{
+		mn::mutex_lock(self->mtx);
+		glUnmapNamedBuffer(h->buffer.id);
+		assert(_renoir_gl450_check());
+		mn::mutex_unlock(self->mtx);
+	}
+	h->buffer.map_ptr = nullptr;
 }
 
 static void
@@ -3913,10 +7050,75 @@ _renoir_gl450_texture_read(Renoir* api, Renoir_Texture texture, Renoir_Texture_E
 	command.texture_read.desc = desc;
 
 	mn::mutex_lock(self->mtx);
-	_renoir_gl450_command_execute(self, &command);
+	if (self->settings.render_thread)
+		_renoir_gl450_render_thread_execute_sync(self, &command);
+	else
+		_renoir_gl450_command_execute(self, &command);
 	mn::mutex_unlock(self->mtx);
 }
 
+static Renoir_Transient
+_renoir_gl450_transient_alloc(Renoir* api, RENOIR_BUFFER type, size_t size)
+{
+	auto self = api->ctx;
+	assert(type == RENOIR_BUFFER_VERTEX || type == RENOIR_BUFFER_INDEX || type == RENOIR_BUFFER_UNIFORM);
+	assert(size > 0);
+
+	auto alignment = type == RENOIR_BUFFER_UNIFORM ? RENOIR_GL450_TRANSIENT_ALIGNMENT : RENOIR_GL450_UPLOAD_ALIGNMENT;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	Renoir_Transient res{};
+	res.buffer = Renoir_Buffer{self->transient_ring.buffer};
+	res.size = size;
+
+	// the commands execute on this thread so the data is written directly into the ring
+	if (self->settings.defer_api_calls == false)
+	{
+		renoir_gl450_context_bind(self->ctx);
+		if (self->transient_ring.buffer->buffer.id == 0)
+			_renoir_gl450_ring_resize(self, self->transient_ring, self->settings.transient_buffer_size);
+
+		size_t offset = 0;
+		if (_renoir_gl450_ring_alloc(self, self->transient_ring, size, alignment, offset) == false)
+		{
+			mn::log_error("gl450: transient ring is full, it'll grow at the end of the frame");
+			self->transient_ring.overflow = true;
+			return Renoir_Transient{};
+		}
+		res.offset = offset;
+		res.ptr = (char*)self->transient_ring.buffer->buffer.mapped + offset;
+		return res;
+	}
+
+	// otherwise the data is staged in the frame's blocks and copied into the ring once the frame executes,
+	// the offset is relative to the frame's region of the ring
+	auto& stream = self->command_stream;
+	auto block = stream.transient_tail;
+	auto used = block != nullptr ? (block->used + alignment - 1) / alignment * alignment : 0;
+	if (block == nullptr || used + size > block->capacity)
+	{
+		auto next = _renoir_gl450_upload_block_new(self, size);
+		// blocks are copied one after the other, each at an offset which fits any transient type
+		if (block != nullptr)
+			next->base = (block->base + block->used + RENOIR_GL450_TRANSIENT_ALIGNMENT - 1) / RENOIR_GL450_TRANSIENT_ALIGNMENT * RENOIR_GL450_TRANSIENT_ALIGNMENT;
+
+		if (stream.transient_tail == nullptr)
+			stream.transient_head = next;
+		else
+			stream.transient_tail->next = next;
+		stream.transient_tail = next;
+		block = next;
+		used = 0;
+	}
+
+	block->used = used + size;
+	res.offset = block->base + used;
+	res.ptr = _renoir_gl450_upload_block_data(block) + used;
+	return res;
+}
+
 static void
 _renoir_gl450_buffer_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RENOIR_SHADER shader, int slot)
 {
@@ -3924,17 +7126,39 @@ _renoir_gl450_buffer_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, R
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+	// the whole buffer is bound and the transient ring is only valid within the frame's region
+	assert(hbuffer->buffer.transient == false && "transient memory should be bound with buffer_bind_range");
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_BIND);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_BUFFER_BIND);
 
-	command->buffer_bind.handle = (Renoir_Handle*)buffer.handle;
+	command->buffer_bind.handle = hbuffer;
 	command->buffer_bind.shader = shader;
 	command->buffer_bind.slot = slot;
+}
+
+static void
+_renoir_gl450_buffer_bind_range(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, RENOIR_SHADER shader, int slot, size_t offset, size_t size)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+	assert(size > 0 && offset + size <= hbuffer->buffer.size && "out of range buffer range");
+	assert((hbuffer->buffer.type != RENOIR_BUFFER_UNIFORM || offset % RENOIR_GL450_TRANSIENT_ALIGNMENT == 0) && "uniform buffer ranges should be 256 bytes aligned");
 
-	_renoir_gl450_command_push(&h->raster_pass, command);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_BUFFER_BIND);
+
+	command->buffer_bind.handle = hbuffer;
+	command->buffer_bind.shader = shader;
+	command->buffer_bind.slot = slot;
+	command->buffer_bind.offset = offset;
+	command->buffer_bind.size = size;
 }
 
 static void
@@ -3949,15 +7173,14 @@ _renoir_gl450_texture_bind(Renoir* api, Renoir_Pass pass, Renoir_Texture texture
 
 	mn::mutex_lock(self->mtx);
 	auto sampler = _renoir_gl450_sampler_get(self, htex->texture.desc.sampler);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_BIND);
 	mn::mutex_unlock(self->mtx);
 
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TEXTURE_BIND);
+
 	command->texture_bind.handle = htex;
 	command->texture_bind.shader = shader;
 	command->texture_bind.slot = slot;
 	command->texture_bind.sampler = sampler;
-
-	_renoir_gl450_command_push(&h->raster_pass, command);
 }
 
 static void
@@ -3972,15 +7195,87 @@ _renoir_gl450_texture_sampler_bind(Renoir* api, Renoir_Pass pass, Renoir_Texture
 
 	mn::mutex_lock(self->mtx);
 	auto hsampler = _renoir_gl450_sampler_get(self, sampler);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_BIND);
 	mn::mutex_unlock(self->mtx);
 
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TEXTURE_BIND);
+
 	command->texture_bind.handle = htex;
 	command->texture_bind.shader = shader;
 	command->texture_bind.slot = slot;
 	command->texture_bind.sampler = hsampler;
+}
+
+static void
+_renoir_gl450_textures_bind(Renoir* api, Renoir_Pass pass, const Renoir_Texture* textures, const Renoir_Sampler_Desc* samplers, int textures_count, RENOIR_SHADER shader, int first_slot)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(textures_count >= 0 && textures_count <= RENOIR_CONSTANT_MULTI_BIND_SIZE);
+	if (textures_count == 0)
+		return;
+
+	// the draw sorting tracks the bound state per slot, so sorted passes get a texture bind per slot
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS && h->raster_pass.draw_sort != nullptr)
+	{
+		for (int i = 0; i < textures_count; ++i)
+		{
+			if (samplers)
+				_renoir_gl450_texture_sampler_bind(api, pass, textures[i], shader, first_slot + i, samplers[i]);
+			else
+				_renoir_gl450_texture_bind(api, pass, textures[i], shader, first_slot + i);
+		}
+		return;
+	}
+
+	auto command = _renoir_gl450_command_textures_bind_new(self, h, textures_count);
+	command->textures_bind.shader = shader;
+	command->textures_bind.first_slot = first_slot;
+
+	mn::mutex_lock(self->mtx);
+	for (int i = 0; i < textures_count; ++i)
+	{
+		auto htex = (Renoir_Handle*)textures[i].handle;
+		assert(htex != nullptr);
+
+		command->textures_bind.bindings[i].texture = htex;
+		command->textures_bind.bindings[i].sampler = _renoir_gl450_sampler_get(self, samplers ? samplers[i] : htex->texture.desc.sampler);
+	}
+	mn::mutex_unlock(self->mtx);
+}
+
+static void
+_renoir_gl450_buffers_bind(Renoir* api, Renoir_Pass pass, const Renoir_Buffer* buffers, int buffers_count, RENOIR_SHADER shader, int first_slot)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+	assert(buffers_count >= 0 && buffers_count <= RENOIR_CONSTANT_MULTI_BIND_SIZE);
+	if (buffers_count == 0)
+		return;
+
+	// the draw sorting tracks the bound state per slot, so sorted passes get a buffer bind per slot
+	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS && h->raster_pass.draw_sort != nullptr)
+	{
+		for (int i = 0; i < buffers_count; ++i)
+			_renoir_gl450_buffer_bind(api, pass, buffers[i], shader, first_slot + i);
+		return;
+	}
 
-	_renoir_gl450_command_push(&h->raster_pass, command);
+	auto command = _renoir_gl450_command_buffers_bind_new(self, h, buffers_count);
+	command->buffers_bind.shader = shader;
+	command->buffers_bind.first_slot = first_slot;
+	for (int i = 0; i < buffers_count; ++i)
+	{
+		auto hbuffer = (Renoir_Handle*)buffers[i].handle;
+		assert(hbuffer != nullptr && hbuffer->buffer.type == RENOIR_BUFFER_UNIFORM);
+		// the buffers are bound whole and the transient ring is only valid within the frame's region
+		assert(hbuffer->buffer.transient == false && "transient memory should be bound with buffer_bind_range");
+		command->buffers_bind.handles[i] = hbuffer;
+	}
 }
 
 static void
@@ -3996,16 +7291,12 @@ _renoir_gl450_buffer_compute_bind(Renoir* api, Renoir_Pass pass, Renoir_Buffer b
 		"gpu should read, write, or both, it has no meaning to bind a buffer that the GPU cannot read or write from"
 	);
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_BUFFER_BIND);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_BUFFER_BIND);
 
 	command->buffer_bind.handle = (Renoir_Handle*)buffer.handle;
 	command->buffer_bind.shader = RENOIR_SHADER_COMPUTE;
 	command->buffer_bind.slot = slot;
 	command->buffer_bind.gpu_access = gpu_access;
-
-	_renoir_gl450_command_push(&h->raster_pass, command);
 }
 
 static void
@@ -4023,16 +7314,12 @@ _renoir_gl450_texture_compute_bind(Renoir* api, Renoir_Pass pass, Renoir_Texture
 
 	auto htex = (Renoir_Handle*)texture.handle;
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TEXTURE_BIND);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TEXTURE_BIND);
 
 	command->texture_bind.handle = htex;
 	command->texture_bind.shader = RENOIR_SHADER_COMPUTE;
 	command->texture_bind.slot = slot;
 	command->texture_bind.gpu_access = gpu_access;
-
-	_renoir_gl450_command_push(&h->compute_pass, command);
 }
 
 static void
@@ -4042,15 +7329,129 @@ _renoir_gl450_draw(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc)
 	auto h = (Renoir_Handle*)pass.handle;
 	assert(h != nullptr);
 
-	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS);
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	// only encode the vertex buffers up to the last used slot
+	int vertex_buffers_count = 0;
+	for (int i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+		if (desc.vertex_buffers[i].buffer.handle != nullptr)
+			vertex_buffers_count = i + 1;
+
+	auto command = _renoir_gl450_command_draw_new(self, h, vertex_buffers_count);
+
+	command->draw.primitive = desc.primitive;
+	command->draw.base_element = desc.base_element;
+	command->draw.elements_count = desc.elements_count;
+	command->draw.instances_count = desc.instances_count;
+	command->draw.base_vertex = desc.base_vertex;
+	command->draw.base_instance = desc.base_instance;
+	command->draw.index_buffer = desc.index_buffer;
+	command->draw.index_type = desc.index_type;
+	command->draw.index_offset = desc.index_offset;
+	command->draw.sort_depth = desc.sort_depth;
+	command->draw.sort_ordered = desc.sort_ordered;
+	for (int i = 0; i < vertex_buffers_count; ++i)
+		command->draw.vertex_buffers[i] = desc.vertex_buffers[i];
+}
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_DRAW);
-	mn::mutex_unlock(self->mtx);
+static void
+_renoir_gl450_draw_batch(Renoir* api, Renoir_Pass pass, const Renoir_Draw_Desc* base, const Renoir_Draw_Range* ranges, size_t ranges_count)
+{
+	if (ranges_count == 0)
+		return;
+
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr && base != nullptr && ranges != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	// only encode the vertex buffers up to the last used slot
+	int vertex_buffers_count = 0;
+	for (int i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+		if (base->vertex_buffers[i].buffer.handle != nullptr)
+			vertex_buffers_count = i + 1;
+
+	auto command = _renoir_gl450_command_draw_batch_new(self, h, vertex_buffers_count);
+
+	auto ranges_size = ranges_count * sizeof(Renoir_Draw_Range);
+	command->draw_batch.ranges = (Renoir_Draw_Range*)_renoir_gl450_command_stream_upload_alloc(self, _renoir_gl450_pass_command_stream(h), ranges_size);
+	::memcpy(command->draw_batch.ranges, ranges, ranges_size);
+	command->draw_batch.ranges_count = ranges_count;
+	command->draw_batch.primitive = base->primitive;
+	command->draw_batch.index_buffer = base->index_buffer;
+	command->draw_batch.index_type = base->index_type;
+	command->draw_batch.index_offset = base->index_offset;
+	for (int i = 0; i < vertex_buffers_count; ++i)
+		command->draw_batch.vertex_buffers[i] = base->vertex_buffers[i];
+}
+
+// records an indirect draw, count_buffer is null unless the draws count is read from the gpu
+static void
+_renoir_gl450_draw_indirect_push(IRenoir* self, Renoir_Handle* h, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, int draws_count, size_t stride, Renoir_Handle* count_buffer, size_t count_offset)
+{
+	assert(h->kind == RENOIR_HANDLE_KIND_RASTER_PASS || h->kind == RENOIR_HANDLE_KIND_BUNDLE);
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr && hbuffer->buffer.type == RENOIR_BUFFER_INDIRECT);
+	assert(count_buffer == nullptr || count_buffer->buffer.type == RENOIR_BUFFER_INDIRECT);
+	assert(offset % 4 == 0 && stride % 4 == 0 && "indirect arguments should be 4 bytes aligned");
+	assert(draws_count >= 0);
+	assert(desc.index_offset == 0 && "indirect draws don't support index offsets");
+
+	// only encode the vertex buffers up to the last used slot
+	int vertex_buffers_count = 0;
+	for (int i = 0; i < RENOIR_CONSTANT_DRAW_VERTEX_BUFFER_SIZE; ++i)
+		if (desc.vertex_buffers[i].buffer.handle != nullptr)
+			vertex_buffers_count = i + 1;
+
+	auto command = _renoir_gl450_command_draw_indirect_new(self, h, vertex_buffers_count);
+
+	command->draw_indirect.buffer = hbuffer;
+	command->draw_indirect.offset = offset;
+	command->draw_indirect.draws_count = draws_count;
+	command->draw_indirect.stride = stride;
+	command->draw_indirect.count_buffer = count_buffer;
+	command->draw_indirect.count_offset = count_offset;
+	command->draw_indirect.primitive = desc.primitive;
+	command->draw_indirect.index_buffer = desc.index_buffer;
+	command->draw_indirect.index_type = desc.index_type == RENOIR_TYPE_NONE ? RENOIR_TYPE_UINT16 : desc.index_type;
+	for (int i = 0; i < vertex_buffers_count; ++i)
+		command->draw_indirect.vertex_buffers[i] = desc.vertex_buffers[i];
+}
+
+static void
+_renoir_gl450_draw_indirect(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	_renoir_gl450_draw_indirect_push(self, h, desc, buffer, offset, 1, 0, nullptr, 0);
+}
+
+static void
+_renoir_gl450_multi_draw_indirect(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, int draws_count, size_t stride)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	_renoir_gl450_draw_indirect_push(self, h, desc, buffer, offset, draws_count, stride, nullptr, 0);
+}
+
+static void
+_renoir_gl450_multi_draw_indirect_count(Renoir* api, Renoir_Pass pass, Renoir_Draw_Desc desc, Renoir_Buffer buffer, size_t offset, Renoir_Buffer count_buffer, size_t count_offset, int max_draws_count, size_t stride)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
 
-	command->draw.desc = desc;
+	auto hcount = (Renoir_Handle*)count_buffer.handle;
+	assert(hcount != nullptr);
+	assert(count_offset % 4 == 0 && "indirect count should be 4 bytes aligned");
 
-	_renoir_gl450_command_push(&h->raster_pass, command);
+	_renoir_gl450_draw_indirect_push(self, h, desc, buffer, offset, max_draws_count, stride, hcount, count_offset);
 }
 
 static void
@@ -4064,15 +7465,31 @@ _renoir_gl450_dispatch(Renoir* api, Renoir_Pass pass, int x, int y, int z)
 
 	assert(h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS);
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_DISPATCH);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_DISPATCH);
 
 	command->dispatch.x = x;
 	command->dispatch.y = y;
 	command->dispatch.z = z;
+}
+
+static void
+_renoir_gl450_dispatch_indirect(Renoir* api, Renoir_Pass pass, Renoir_Buffer buffer, size_t offset)
+{
+	assert(offset % 4 == 0 && "indirect arguments should be 4 bytes aligned");
+
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+
+	assert(h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS);
+
+	auto hbuffer = (Renoir_Handle*)buffer.handle;
+	assert(hbuffer != nullptr && hbuffer->buffer.type == RENOIR_BUFFER_INDIRECT);
 
-	_renoir_gl450_command_push(&h->compute_pass, command);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_DISPATCH_INDIRECT);
+
+	command->dispatch_indirect.buffer = hbuffer;
+	command->dispatch_indirect.offset = offset;
 }
 
 static void
@@ -4088,25 +7505,10 @@ _renoir_gl450_timer_begin(struct Renoir* api, Renoir_Pass pass, Renoir_Timer tim
 	if(htimer->timer.state != RENOIR_TIMER_STATE_NONE)
 		return;
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_BEGIN);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TIMER_BEGIN);
 
 	command->timer_begin.handle = htimer;
 	htimer->timer.state = RENOIR_TIMER_STATE_BEGIN;
-
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
-	{
-		_renoir_gl450_command_push(&h->raster_pass, command);
-	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
-	{
-		_renoir_gl450_command_push(&h->compute_pass, command);
-	}
-	else
-	{
-		assert(false && "unreachable");
-	}
 }
 
 static void
@@ -4121,25 +7523,27 @@ _renoir_gl450_timer_end(struct Renoir* api, Renoir_Pass pass, Renoir_Timer timer
 	if (htimer->timer.state != RENOIR_TIMER_STATE_BEGIN)
 		return;
 
-	mn::mutex_lock(self->mtx);
-	auto command = _renoir_gl450_command_new(self, RENOIR_COMMAND_KIND_TIMER_END);
-	mn::mutex_unlock(self->mtx);
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_TIMER_END);
 
 	command->timer_end.handle = htimer;
 	htimer->timer.state = RENOIR_TIMER_STATE_END;
+}
 
-	if (h->kind == RENOIR_HANDLE_KIND_RASTER_PASS)
-	{
-		_renoir_gl450_command_push(&h->raster_pass, command);
-	}
-	else if (h->kind == RENOIR_HANDLE_KIND_COMPUTE_PASS)
-	{
-		_renoir_gl450_command_push(&h->compute_pass, command);
-	}
-	else
-	{
-		assert(false && "unreachable");
-	}
+static void
+_renoir_gl450_fence_insert(struct Renoir* api, Renoir_Pass pass, Renoir_Fence fence)
+{
+	auto self = api->ctx;
+	auto h = (Renoir_Handle*)pass.handle;
+	assert(h != nullptr);
+	// bundles are replayed so they would insert the same generation multiple times
+	assert(h->kind != RENOIR_HANDLE_KIND_BUNDLE && "fences can't be recorded in bundles");
+
+	auto hfence = (Renoir_Handle*)fence.handle;
+	assert(hfence != nullptr && hfence->kind == RENOIR_HANDLE_KIND_FENCE);
+
+	auto command = _renoir_gl450_command_new(self, h, RENOIR_COMMAND_KIND_FENCE_INSERT);
+	command->fence_insert.handle = hfence;
+	command->fence_insert.generation = ++hfence->fence.inserted_generation;
 }
 
 inline static void
@@ -4178,34 +7582,61 @@ _renoir_load_api(Renoir* api)
 	api->pass_swapchain_new = _renoir_gl450_pass_swapchain_new;
 	api->pass_offscreen_new = _renoir_gl450_pass_offscreen_new;
 	api->pass_compute_new = _renoir_gl450_pass_compute_new;
+	api->pass_bundle_new = _renoir_gl450_pass_bundle_new;
 	api->pass_free = _renoir_gl450_pass_free;
 	api->pass_size = _renoir_gl450_pass_size;
 	api->pass_offscreen_desc = _renoir_gl450_pass_offscreen_desc;
+	api->pass_draw_sort = _renoir_gl450_pass_draw_sort;
 
 	api->timer_new = _renoir_gl450_timer_new;
 	api->timer_free = _renoir_gl450_timer_free;
 	api->timer_elapsed = _renoir_gl450_timer_elapsed;
 
+	api->readback_poll = _renoir_gl450_readback_poll;
+	api->readback_free = _renoir_gl450_readback_free;
+
+	api->fence_new = _renoir_gl450_fence_new;
+	api->fence_free = _renoir_gl450_fence_free;
+	api->fence_signaled = _renoir_gl450_fence_signaled;
+	api->fence_wait = _renoir_gl450_fence_wait;
+
 	api->pass_begin = _renoir_gl450_pass_begin;
 	api->pass_end = _renoir_gl450_pass_end;
+	api->pass_record_end = _renoir_gl450_pass_record_end;
+	api->pass_submit = _renoir_gl450_pass_submit;
 	api->clear = _renoir_gl450_clear;
 	api->use_pipeline = _renoir_gl450_use_pipeline;
 	api->use_program = _renoir_gl450_use_program;
 	api->use_compute = _renoir_gl450_use_compute;
 	api->scissor = _renoir_gl450_scissor;
+	api->bundle_execute = _renoir_gl450_bundle_execute;
 	api->buffer_write = _renoir_gl450_buffer_write;
 	api->texture_write = _renoir_gl450_texture_write;
 	api->buffer_read = _renoir_gl450_buffer_read;
 	api->texture_read = _renoir_gl450_texture_read;
+	api->buffer_read_async = _renoir_gl450_buffer_read_async;
+	api->texture_read_async = _renoir_gl450_texture_read_async;
+	api->buffer_map = _renoir_gl450_buffer_map;
+	api->buffer_unmap = _renoir_gl450_buffer_unmap;
+	api->transient_alloc = _renoir_gl450_transient_alloc;
 	api->buffer_bind = _renoir_gl450_buffer_bind;
+	api->buffer_bind_range = _renoir_gl450_buffer_bind_range;
 	api->texture_bind = _renoir_gl450_texture_bind;
 	api->texture_sampler_bind = _renoir_gl450_texture_sampler_bind;
+	api->textures_bind = _renoir_gl450_textures_bind;
+	api->buffers_bind = _renoir_gl450_buffers_bind;
 	api->buffer_compute_bind = _renoir_gl450_buffer_compute_bind;
 	api->texture_compute_bind = _renoir_gl450_texture_compute_bind;
 	api->draw = _renoir_gl450_draw;
+	api->draw_batch = _renoir_gl450_draw_batch;
+	api->draw_indirect = _renoir_gl450_draw_indirect;
+	api->multi_draw_indirect = _renoir_gl450_multi_draw_indirect;
+	api->multi_draw_indirect_count = _renoir_gl450_multi_draw_indirect_count;
 	api->dispatch = _renoir_gl450_dispatch;
+	api->dispatch_indirect = _renoir_gl450_dispatch_indirect;
 	api->timer_begin = _renoir_gl450_timer_begin;
 	api->timer_end = _renoir_gl450_timer_end;
+	api->fence_insert = _renoir_gl450_fence_insert;
 }
 
 Renoir*
@@ -4216,6 +7647,17 @@ renoir_api()
 	return &_api;
 }
 
+Renoir_GL450_Frame_Stats
+renoir_gl450_frame_stats(Renoir* api)
+{
+	auto self = api->ctx;
+
+	mn::mutex_lock(self->mtx);
+	mn_defer(mn::mutex_unlock(self->mtx));
+
+	return self->frame_stats;
+}
+
 extern "C" RENOIR_GL450_EXPORT void*
 rad_api(void* api, bool reload)
 {